@@ -30,6 +30,8 @@ plan_arc.c
 
 plan_line.c
 
+plan_spline.c
+
 pwm.c
 
 report.c
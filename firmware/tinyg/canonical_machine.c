@@ -83,7 +83,9 @@
 #include "config.h"
 #include "canonical_machine.h"
 #include "plan_arc.h"
+#include "plan_spline.h"
 #include "planner.h"
+#include "kinematics.h"
 #include "stepper.h"
 #include "spindle.h"
 #include "report.h"
@@ -156,6 +158,7 @@ uint8_t cm_get_model_coord_system() { return gm.coord_system;}
 uint8_t cm_get_model_units_mode() { return gm.units_mode;}
 uint8_t cm_get_model_select_plane() { return gm.select_plane;}
 uint8_t cm_get_model_path_control() { return gm.path_control;}
+float cm_get_model_path_tolerance() { return gm.path_tolerance;}
 uint8_t cm_get_model_distance_mode() { return gm.distance_mode;}
 uint8_t cm_get_model_inverse_feed_rate_mode() { return gm.inverse_feed_rate_mode;}
 uint8_t cm_get_model_spindle_mode() { return gm.spindle_mode;} 
@@ -505,6 +508,18 @@ static float _get_move_times(float *min_time)
 		max_time = max(max_time, tmp_time);
 		*min_time = min(*min_time, tmp_time);
 	}
+	if (ik_joint_limits()) {	// the motors must keep within the limits too (see kinematics.h)
+		float travel[AXES], joint[AXES];
+		for (i=0; i<AXES; i++) { travel[i] = gm.target[i] - gm.position[i];}
+		ik_joint_vector(travel, joint);
+		for (i=0; i<AXES; i++) {
+			if (gm.motion_mode == MOTION_MODE_STRAIGHT_FEED) {
+				max_time = max(max_time, fabs(joint[i]) / cfg.a[i].feedrate_max);
+			} else {
+				max_time = max(max_time, fabs(joint[i]) / cfg.a[i].velocity_max);
+			}
+		}
+	}
 	return (max4(inv_time, max_time, xyz_time, abc_time));
 }
 
@@ -844,7 +859,8 @@ stat_t cm_set_inverse_feed_rate_mode(uint8_t mode)
 }
 
 /*
- * cm_set_path_control() - G61, G61.1, G64
+ * cm_set_path_control() 	- G61, G61.1, G64
+ * cm_set_path_tolerance() - G64 P - round corners to within this distance of the path
  */
 
 stat_t cm_set_path_control(uint8_t mode)
@@ -853,6 +869,13 @@ stat_t cm_set_path_control(uint8_t mode)
 	return (STAT_OK);
 }
 
+stat_t cm_set_path_tolerance(float tolerance)
+{
+	if (tolerance < 0) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	gm.path_tolerance = _to_millimeters(tolerance);
+	return (STAT_OK);
+}
+
 /* 
  * Machining Functions (4.3.6)
  *
@@ -1140,12 +1163,16 @@ stat_t cm_feedhold_sequencing_callback()
 
 stat_t cm_queue_flush()
 {
+	float position[AXES];
+
 	xio_reset_usb_rx_buffers();		// flush serial queues
 	mp_flush_planner();				// flush planner queue
+	sp_abort_spline();				// and any spline that was feeding it
+	mp_get_step_position(position);	// where the motors actually are (motion has stopped)
 
 	for (uint8_t i=0; i<AXES; i++) {
-		mp_set_axis_position(i, mp_get_runtime_machine_position(i));	// set mm from mr
-		gm.position[i] = mp_get_runtime_machine_position(i);
+		mp_set_axis_position(i, position[i]);	// set mm and mr
+		gm.position[i] = position[i];
 		gm.target[i] = gm.position[i];
 	}
 	_program_finalize(MACHINE_PROGRAM_STOP, 0);
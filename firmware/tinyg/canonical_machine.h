@@ -115,6 +115,7 @@ typedef struct GCodeModel {				// Gcode dynamic model
 	uint8_t origin_offset_enable;		// G92 offsets enabled/disabled.  0=disabled, 1=enabled
 
 	uint8_t path_control;				// G61... EXACT_PATH, EXACT_STOP, CONTINUOUS
+	float path_tolerance;				// G64 P - corner blending tolerance in mm (0 = no blending)
 	uint8_t distance_mode;				// G91   0=use absolute coords(G90), 1=incremental movement
 
 	uint8_t tool;						// T value
@@ -184,6 +185,7 @@ typedef struct GCodeInput {				// Gcode model inputs - meaning depends on contex
 	float parameter;					// P - parameter used for dwell time in seconds, G10 coord select...
 	float arc_radius;					// R - radius value in arc radius mode
 	float arc_offset[3];  				// IJK - used by arc commands
+	float q_word;						// Q - used by G5 splines (P Q is the second control point)
 } GCodeInput_t;
 
 // Allocation
@@ -317,6 +319,8 @@ enum cmMotionMode {						// G Modal Group 1
 	MOTION_MODE_CW_ARC,					// G2 - arc feed
 	MOTION_MODE_CCW_ARC,				// G3 - arc feed
 	MOTION_MODE_CANCEL_MOTION_MODE,		// G80
+	MOTION_MODE_CUBIC_SPLINE,			// G5 - cubic spline feed
+	MOTION_MODE_QUADRATIC_SPLINE,		// G5.1 - quadratic spline feed
 	MOTION_MODE_STRAIGHT_PROBE,			// G38.2
 	MOTION_MODE_CANNED_CYCLE_81,		// G81 - drilling
 	MOTION_MODE_CANNED_CYCLE_82,		// G82 - drilling with dwell
@@ -450,6 +454,7 @@ uint8_t cm_get_model_coord_system(void);
 uint8_t cm_get_model_units_mode(void);
 uint8_t cm_get_model_select_plane(void);
 uint8_t cm_get_model_path_control(void);
+float cm_get_model_path_tolerance(void);
 uint8_t cm_get_model_distance_mode(void);
 uint8_t cm_get_model_inverse_feed_rate_mode(void);
 uint8_t cm_get_model_spindle_mode(void);
@@ -511,10 +516,13 @@ stat_t cm_straight_traverse(float target[], float flags[]);
 stat_t cm_set_feed_rate(float feed_rate);						// F parameter
 stat_t cm_set_inverse_feed_rate_mode(uint8_t mode);				// True= inv mode
 stat_t cm_set_path_control(uint8_t mode);						// G61, G61.1, G64
+stat_t cm_set_path_tolerance(float tolerance);					// G64 P
 stat_t cm_straight_feed(float target[], float flags[]);			// G1
 stat_t cm_arc_feed(float target[], float flags[], 				// G2, G3
 					float i, float j, float k, 
 					float radius, uint8_t motion_mode);
+stat_t cm_spline_feed(float target[], float flags[],			// G5, G5.1
+					  float offset[], float offset_flags[], uint8_t motion_mode);
 stat_t cm_dwell(float seconds);									// G4, P parameter
 
 stat_t cm_set_spindle_speed(float speed);						// S parameter
@@ -45,6 +45,7 @@
 #include "json_parser.h"
 #include "planner.h"
 #include "stepper.h"
+#include "kinematics.h"
 #include "gpio.h"
 #include "test.h"
 #include "help.h"
@@ -148,10 +149,24 @@ static stat_t _set_si(cmdObj_t *cmd);		// set status report interval
 static stat_t _run_boot(cmdObj_t *cmd);	// jump to the bootloader
 static stat_t _get_id(cmdObj_t *cmd);		// get device ID
 static stat_t _set_jv(cmdObj_t *cmd);		// set JSON verbosity
+static stat_t _set_la(cmdObj_t *cmd);		// set line coalesce angle
+static stat_t _set_kd(cmdObj_t *cmd);		// set a delta dimension
+static stat_t _set_kin(cmdObj_t *cmd);		// set kinematics
+static stat_t _set_zme(cmdObj_t *cmd);		// set Z mesh enable
+static stat_t _set_zm(cmdObj_t *cmd);		// set a Z mesh origin or point
+static stat_t _set_zms(cmdObj_t *cmd);		// set a Z mesh spacing
 static stat_t _get_qr(cmdObj_t *cmd);		// get a queue report (as data)
 static stat_t _run_qf(cmdObj_t *cmd);		// execute a queue flush block
 static stat_t _get_er(cmdObj_t *cmd);		// invoke a bogus exception report for testing purposes
 static stat_t _get_rx(cmdObj_t *cmd);		// get bytes in RX buffer
+static stat_t _get_udr(cmdObj_t *cmd);		// get stepper underrun count
+static stat_t _get_stc(cmdObj_t *cmd);		// get motor step count
+static void _print_stc(cmdObj_t *cmd);		// print motor step count
+#ifdef __STEP_TIMING
+static stat_t _get_stp(cmdObj_t *cmd);		// get a stepper timing statistic
+static stat_t _set_stp(cmdObj_t *cmd);		// clear the stepper timing statistics
+static void _print_stp(cmdObj_t *cmd);		// print a stepper timing statistic
+#endif
 static stat_t _set_md(cmdObj_t *cmd);		// disable all motors
 static stat_t _set_me(cmdObj_t *cmd);		// enable motors with power-mode set to 0 (on)
 
@@ -185,12 +200,15 @@ static stat_t _set_defa(cmdObj_t *cmd);	// reset config to default values
 static stat_t _set_sa(cmdObj_t *cmd);		// set motor step angle
 static stat_t _set_tr(cmdObj_t *cmd);		// set motor travel per revolution
 static stat_t _set_mi(cmdObj_t *cmd);		// set microsteps
+static stat_t _set_ma(cmdObj_t *cmd);		// set motor map
 static stat_t _set_po(cmdObj_t *cmd);		// set motor polarity
 static stat_t _set_pm(cmdObj_t *cmd);		// set motor power mode
 
 static stat_t _set_sw(cmdObj_t *cmd);		// must run any time you change a switch setting
 static stat_t _get_am(cmdObj_t *cmd);		// get axis mode
 static stat_t _set_am(cmdObj_t *cmd);		// set axis mode
+static stat_t _set_pc(cmdObj_t *cmd);		// set a pitch correction or backlash
+static stat_t _set_ps(cmdObj_t *cmd);		// set pitch table spacing
 static void _print_am(cmdObj_t *cmd);		// print axis mode
 
 static stat_t _set_ic(cmdObj_t *cmd);		// ignore CR or LF on RX input
@@ -207,6 +225,19 @@ static const char msg_units0[] PROGMEM = " in";	// used by generic print functio
 static const char msg_units1[] PROGMEM = " mm";
 static const char msg_units2[] PROGMEM = " deg";
 static PGM_P const msg_units[] PROGMEM = { msg_units0, msg_units1, msg_units2 };
+
+#ifdef __STEP_TIMING
+static const char msg_stp_row0[] PROGMEM = "DDA ISR";			// stepper timing rows (see stepper.h)
+static const char msg_stp_row1[] PROGMEM = "Segment load";
+static const char msg_stp_row2[] PROGMEM = "Segment exec";
+static const char msg_stp_row3[] PROGMEM = "Late exec wait";
+static PGM_P const msg_stp_row[] PROGMEM = { msg_stp_row0, msg_stp_row1, msg_stp_row2, msg_stp_row3 };
+static const char msg_stp_stat0[] PROGMEM = "min";
+static const char msg_stp_stat1[] PROGMEM = "max";
+static const char msg_stp_stat2[] PROGMEM = "mean";
+static const char msg_stp_stat3[] PROGMEM = "count";
+static PGM_P const msg_stp_stat[] PROGMEM = { msg_stp_stat0, msg_stp_stat1, msg_stp_stat2, msg_stp_stat3 };
+#endif
 #define F_DEG 2
 
 static const char msg_g20[] PROGMEM = "G20 - inches mode";
@@ -286,7 +317,9 @@ static const char msg_g01[] PROGMEM = "G1  - linear feed";
 static const char msg_g02[] PROGMEM = "G2  - clockwise arc feed";
 static const char msg_g03[] PROGMEM = "G3  - counter clockwise arc feed";
 static const char msg_g80[] PROGMEM = "G80 - cancel motion mode (none active)";
-static PGM_P const msg_momo[] PROGMEM = { msg_g00, msg_g01, msg_g02, msg_g03, msg_g80 };
+static const char msg_g05[] PROGMEM = "G5  - cubic spline feed";
+static const char msg_g051[] PROGMEM = "G5.1 - quadratic spline feed";
+static PGM_P const msg_momo[] PROGMEM = { msg_g00, msg_g01, msg_g02, msg_g03, msg_g80, msg_g05, msg_g051 };
 
 static const char msg_g17[] PROGMEM = "G17 - XY plane";
 static const char msg_g18[] PROGMEM = "G18 - XZ plane";
@@ -331,6 +364,17 @@ static const char fmt_ja[] PROGMEM = "[ja]  junction acceleration%8.0f%S\n";
 static const char fmt_ml[] PROGMEM = "[ml]  min line segment%17.3f%S\n";
 static const char fmt_ma[] PROGMEM = "[ma]  min arc segment%18.3f%S\n";
 static const char fmt_ct[] PROGMEM = "[ct]  chordal tolerance%16.3f%S\n";
+static const char fmt_la[] PROGMEM = "[la]  line coalesce angle%14.3f degrees [0=off]\n";
+static const char fmt_lt[] PROGMEM = "[lt]  line coalesce tolerance%10.4f%S\n";
+static const char fmt_kin[] PROGMEM = "[kin] kinematics%19d [0=cartesian,1=CoreXY,2=H-bot,3=delta]\n";
+static const char fmt_kl[] PROGMEM = "[kl]  delta rod length%17.3f%S\n";
+static const char fmt_kr[] PROGMEM = "[kr]  delta radius%21.3f%S\n";
+static const char fmt_zme[] PROGMEM = "[zme] z mesh enable%16d [0=off,1=on]\n";
+static const char fmt_zmx[] PROGMEM = "[zmx] z mesh origin x%18.3f%S\n";
+static const char fmt_zmy[] PROGMEM = "[zmy] z mesh origin y%18.3f%S\n";
+static const char fmt_zmi[] PROGMEM = "[zmi] z mesh spacing x%17.3f%S\n";
+static const char fmt_zmj[] PROGMEM = "[zmj] z mesh spacing y%17.3f%S\n";
+static const char fmt_zmp[] PROGMEM = "[%s%s]%.0s%.0s z mesh offset%19.3f%S\n";
 static const char fmt_ms[] PROGMEM = "[ms]  min segment time%13.0f uSec\n";
 static const char fmt_st[] PROGMEM = "[st]  switch type%18d [0=NO,1=NC]\n";
 static const char fmt_si[] PROGMEM = "[si]  status interval%14.0f ms\n";
@@ -347,6 +391,8 @@ static const char fmt_baud[] PROGMEM = "[baud] USB baud rate%15d [1=9600,2=19200
 
 static const char fmt_qr[] PROGMEM = "qr:%d\n";
 static const char fmt_rx[] PROGMEM = "rx:%d\n";
+static const char fmt_udr[] PROGMEM = "udr:%d\n";
+static const char fmt_stp[] PROGMEM = "[stp%c%c] %S %S:%12.0f%s\n";
 
 static const char fmt_md[] PROGMEM = "motors disabled\n";
 static const char fmt_me[] PROGMEM = "motors enabled\n";
@@ -372,6 +418,7 @@ static const char fmt_frmo[] PROGMEM = "Feed rate mode:      %s\n";
 
 static const char fmt_pos[]  PROGMEM = "%c position:%15.3f%S\n";
 static const char fmt_mpos[] PROGMEM = "%c machine posn:%11.3f%S\n";
+static const char fmt_stc[]  PROGMEM = "Motor %c steps:%12ld\n";
 static const char fmt_ofs[]  PROGMEM = "%c work offset:%12.3f%S\n";
 static const char fmt_hom[]  PROGMEM = "%c axis homing state:%2.0f\n";
 
@@ -398,6 +445,9 @@ static const char fmt_Xlv[] PROGMEM = "[%s%s] %s latch velocity%17.3f%S/min\n";
 static const char fmt_Xlb[] PROGMEM = "[%s%s] %s latch backoff%18.3f%S\n";
 static const char fmt_Xzb[] PROGMEM = "[%s%s] %s zero backoff%19.3f%S\n";
 static const char fmt_Xjh[] PROGMEM = "[%s%s] %s jerk homing%16.0f%S/min^3\n";
+static const char fmt_Xbl[] PROGMEM = "[%s%s] %s backlash%23.3f%S\n";
+static const char fmt_Xps[] PROGMEM = "[%s%s] %s pitch table spacing%12.3f%S\n";
+static const char fmt_Xpc[] PROGMEM = "[%s%s] %s pitch correction%15.3f%S\n";
 
 // PWM strings
 static const char fmt_p1frq[] PROGMEM = "[p1frq] pwm frequency   %15.3f Hz\n";
@@ -434,6 +484,12 @@ static const char fmt_gdi[] PROGMEM = "[gdi] default gcode distance mode%2d [0=G
  *
  *	- Groups do not have groups. Neither do uber-groups, e.g.
  *	  'x' is --> { "", "x",  	and 'm' is --> { "", "m",  
+ *
+ *	- Values are persisted in NVM by array index (see cmd_read_NVM_value()).
+ *	  Adding, removing or moving a row ahead of a persisted one changes the
+ *	  layout: bump TINYG_FIRMWARE_BUILD so cfg_init() loads the defaults
+ *	  instead of reading old values into the wrong tokens. Rows that are only
+ *	  in some builds (__STEP_TIMING) go after the last persisted row.
  */
 
 const cfgItem_t cfgArray[] PROGMEM = {
@@ -468,6 +524,11 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "mpo","mpob",_f00, 3, fmt_mpos,_print_mpos, _get_mpos,_set_nul,(float *)&tg.null, 0 },// B machine position
 	{ "mpo","mpoc",_f00, 3, fmt_mpos,_print_mpos, _get_mpos,_set_nul,(float *)&tg.null, 0 },// C machine position
 
+	{ "stc","stc1",_f00, 0, fmt_stc, _print_stc, _get_stc, _set_nul,(float *)&tg.null, 0 },	// motor 1 step count
+	{ "stc","stc2",_f00, 0, fmt_stc, _print_stc, _get_stc, _set_nul,(float *)&tg.null, 0 },	// motor 2 step count
+	{ "stc","stc3",_f00, 0, fmt_stc, _print_stc, _get_stc, _set_nul,(float *)&tg.null, 0 },	// motor 3 step count
+	{ "stc","stc4",_f00, 0, fmt_stc, _print_stc, _get_stc, _set_nul,(float *)&tg.null, 0 },	// motor 4 step count
+
 	{ "pos","posx",_f00, 3, fmt_pos, _print_pos, _get_pos, _set_nul,(float *)&tg.null, 0 },	// X work position
 	{ "pos","posy",_f00, 3, fmt_pos, _print_pos, _get_pos, _set_nul,(float *)&tg.null, 0 },	// Y work position
 	{ "pos","posz",_f00, 3, fmt_pos, _print_pos, _get_pos, _set_nul,(float *)&tg.null, 0 },	// Z work position
@@ -496,6 +557,8 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "", "qf",  _f00, 0, fmt_nul, _print_nul, _get_nul, _run_qf,  (float *)&tg.null, 0 },	// queue flush
 	{ "", "er",  _f00, 0, fmt_nul, _print_nul, _get_er,  _set_nul, (float *)&tg.null, 0 },	// invoke bogus exception report for testing
 	{ "", "rx",  _f00, 0, fmt_rx,  _print_int, _get_rx,  _set_nul, (float *)&tg.null, 0 },	// space in RX buffer
+	{ "", "udr", _f00, 0, fmt_udr, _print_int, _get_udr, _set_nul, (float *)&tg.null, 0 },	// stepper underrun count
+
 	{ "", "msg", _f00, 0, fmt_str, _print_str, _get_nul, _set_nul, (float *)&tg.null, 0 },	// string for generic messages
 	{ "", "test",_f00, 0, fmt_nul, _print_nul, print_test_help, tg_test, (float *)&tg.test,0 },// prints test help screen
 	{ "", "defa",_f00, 0, fmt_nul, _print_nul, print_defaults_help,_set_defa,(float *)&tg.null,0},// prints defaults help screen
@@ -504,28 +567,28 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "", "h",   _f00, 0, fmt_nul, _print_nul, print_config_help,_set_nul, (float *)&tg.null,0 },// alias for "help"
 
 	// Motor parameters
-	{ "1","1ma",_fip, 0, fmt_0ma, _pr_ma_ui8, _get_ui8, _set_ui8,(float *)&cfg.m[MOTOR_1].motor_map,	M1_MOTOR_MAP },
+	{ "1","1ma",_fip, 0, fmt_0ma, _pr_ma_ui8, _get_ui8, _set_ma, (float *)&cfg.m[MOTOR_1].motor_map,	M1_MOTOR_MAP },
 	{ "1","1sa",_fip, 2, fmt_0sa, _pr_ma_rot, _get_dbl ,_set_sa, (float *)&cfg.m[MOTOR_1].step_angle,	M1_STEP_ANGLE },
 	{ "1","1tr",_fip, 3, fmt_0tr, _pr_ma_lin, _get_dbu ,_set_tr, (float *)&cfg.m[MOTOR_1].travel_rev,	M1_TRAVEL_PER_REV },
 	{ "1","1mi",_fip, 0, fmt_0mi, _pr_ma_ui8, _get_ui8, _set_mi, (float *)&cfg.m[MOTOR_1].microsteps,	M1_MICROSTEPS },
 	{ "1","1po",_fip, 0, fmt_0po, _pr_ma_ui8, _get_ui8, _set_po, (float *)&cfg.m[MOTOR_1].polarity,		M1_POLARITY },
 	{ "1","1pm",_fip, 0, fmt_0pm, _pr_ma_ui8, _get_ui8, _set_pm, (float *)&cfg.m[MOTOR_1].power_mode,	M1_POWER_MODE },
 
-	{ "2","2ma",_fip, 0, fmt_0ma, _pr_ma_ui8, _get_ui8, _set_ui8,(float *)&cfg.m[MOTOR_2].motor_map,	M2_MOTOR_MAP },
+	{ "2","2ma",_fip, 0, fmt_0ma, _pr_ma_ui8, _get_ui8, _set_ma, (float *)&cfg.m[MOTOR_2].motor_map,	M2_MOTOR_MAP },
 	{ "2","2sa",_fip, 2, fmt_0sa, _pr_ma_rot, _get_dbl, _set_sa, (float *)&cfg.m[MOTOR_2].step_angle,	M2_STEP_ANGLE },
 	{ "2","2tr",_fip, 3, fmt_0tr, _pr_ma_lin, _get_dbu, _set_tr, (float *)&cfg.m[MOTOR_2].travel_rev,	M2_TRAVEL_PER_REV },
 	{ "2","2mi",_fip, 0, fmt_0mi, _pr_ma_ui8, _get_ui8, _set_mi, (float *)&cfg.m[MOTOR_2].microsteps,	M2_MICROSTEPS },
 	{ "2","2po",_fip, 0, fmt_0po, _pr_ma_ui8, _get_ui8, _set_po, (float *)&cfg.m[MOTOR_2].polarity,		M2_POLARITY },
 	{ "2","2pm",_fip, 0, fmt_0pm, _pr_ma_ui8, _get_ui8, _set_pm, (float *)&cfg.m[MOTOR_2].power_mode,	M2_POWER_MODE },
 
-	{ "3","3ma",_fip, 0, fmt_0ma, _pr_ma_ui8, _get_ui8, _set_ui8,(float *)&cfg.m[MOTOR_3].motor_map,	M3_MOTOR_MAP },
+	{ "3","3ma",_fip, 0, fmt_0ma, _pr_ma_ui8, _get_ui8, _set_ma, (float *)&cfg.m[MOTOR_3].motor_map,	M3_MOTOR_MAP },
 	{ "3","3sa",_fip, 2, fmt_0sa, _pr_ma_rot, _get_dbl, _set_sa, (float *)&cfg.m[MOTOR_3].step_angle,	M3_STEP_ANGLE },
 	{ "3","3tr",_fip, 3, fmt_0tr, _pr_ma_lin, _get_dbu, _set_tr, (float *)&cfg.m[MOTOR_3].travel_rev,	M3_TRAVEL_PER_REV },
 	{ "3","3mi",_fip, 0, fmt_0mi, _pr_ma_ui8, _get_ui8, _set_mi, (float *)&cfg.m[MOTOR_3].microsteps,	M3_MICROSTEPS },
 	{ "3","3po",_fip, 0, fmt_0po, _pr_ma_ui8, _get_ui8, _set_po, (float *)&cfg.m[MOTOR_3].polarity,		M3_POLARITY },
 	{ "3","3pm",_fip, 0, fmt_0pm, _pr_ma_ui8, _get_ui8, _set_pm, (float *)&cfg.m[MOTOR_3].power_mode,	M3_POWER_MODE },
 
-	{ "4","4ma",_fip, 0, fmt_0ma, _pr_ma_ui8, _get_ui8, _set_ui8,(float *)&cfg.m[MOTOR_4].motor_map,	M4_MOTOR_MAP },
+	{ "4","4ma",_fip, 0, fmt_0ma, _pr_ma_ui8, _get_ui8, _set_ma, (float *)&cfg.m[MOTOR_4].motor_map,	M4_MOTOR_MAP },
 	{ "4","4sa",_fip, 2, fmt_0sa, _pr_ma_rot, _get_dbl, _set_sa, (float *)&cfg.m[MOTOR_4].step_angle,	M4_STEP_ANGLE },
 	{ "4","4tr",_fip, 3, fmt_0tr, _pr_ma_lin, _get_dbu, _set_tr, (float *)&cfg.m[MOTOR_4].travel_rev,	M4_TRAVEL_PER_REV },
 	{ "4","4mi",_fip, 0, fmt_0mi, _pr_ma_ui8, _get_ui8, _set_mi, (float *)&cfg.m[MOTOR_4].microsteps,	M4_MICROSTEPS },
@@ -546,6 +609,16 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "x","xlv",_fip, 0, fmt_Xlv, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_X].latch_velocity,X_LATCH_VELOCITY },
 	{ "x","xlb",_fip, 3, fmt_Xlb, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_X].latch_backoff,	X_LATCH_BACKOFF },
 	{ "x","xzb",_fip, 3, fmt_Xzb, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_X].zero_backoff,	X_ZERO_BACKOFF },
+	{ "x","xbl",_fip, 3, fmt_Xbl, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_X].backlash,		X_BACKLASH },
+	{ "x","xps",_fip, 3, fmt_Xps, _pr_ma_lin, _get_dbu, _set_ps, (float *)&cfg.a[AXIS_X].pitch_spacing,X_PITCH_SPACING },
+	{ "x","xp0",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_X].pitch[0],	0 },
+	{ "x","xp1",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_X].pitch[1],	0 },
+	{ "x","xp2",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_X].pitch[2],	0 },
+	{ "x","xp3",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_X].pitch[3],	0 },
+	{ "x","xp4",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_X].pitch[4],	0 },
+	{ "x","xp5",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_X].pitch[5],	0 },
+	{ "x","xp6",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_X].pitch[6],	0 },
+	{ "x","xp7",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_X].pitch[7],	0 },
 
 	{ "y","yam",_fip, 0, fmt_Xam, _print_am,  _get_am,  _set_am, (float *)&cfg.a[AXIS_Y].axis_mode,		Y_AXIS_MODE },
 	{ "y","yvm",_fip, 0, fmt_Xvm, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_Y].velocity_max,	Y_VELOCITY_MAX },
@@ -560,6 +633,16 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "y","ylv",_fip, 0, fmt_Xlv, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_Y].latch_velocity,Y_LATCH_VELOCITY },
 	{ "y","ylb",_fip, 3, fmt_Xlb, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_Y].latch_backoff,	Y_LATCH_BACKOFF },
 	{ "y","yzb",_fip, 3, fmt_Xzb, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_Y].zero_backoff,	Y_ZERO_BACKOFF },
+	{ "y","ybl",_fip, 3, fmt_Xbl, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Y].backlash,		Y_BACKLASH },
+	{ "y","yps",_fip, 3, fmt_Xps, _pr_ma_lin, _get_dbu, _set_ps, (float *)&cfg.a[AXIS_Y].pitch_spacing,Y_PITCH_SPACING },
+	{ "y","yp0",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Y].pitch[0],	0 },
+	{ "y","yp1",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Y].pitch[1],	0 },
+	{ "y","yp2",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Y].pitch[2],	0 },
+	{ "y","yp3",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Y].pitch[3],	0 },
+	{ "y","yp4",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Y].pitch[4],	0 },
+	{ "y","yp5",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Y].pitch[5],	0 },
+	{ "y","yp6",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Y].pitch[6],	0 },
+	{ "y","yp7",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Y].pitch[7],	0 },
 
 	{ "z","zam",_fip, 0, fmt_Xam, _print_am,  _get_am,  _set_am, (float *)&cfg.a[AXIS_Z].axis_mode,		Z_AXIS_MODE },
 	{ "z","zvm",_fip, 0, fmt_Xvm, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_Z].velocity_max,	Z_VELOCITY_MAX },
@@ -574,6 +657,16 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "z","zlv",_fip, 0, fmt_Xlv, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_Z].latch_velocity,Z_LATCH_VELOCITY },
 	{ "z","zlb",_fip, 3, fmt_Xlb, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_Z].latch_backoff,	Z_LATCH_BACKOFF },
 	{ "z","zzb",_fip, 3, fmt_Xzb, _pr_ma_lin, _get_dbu, _set_dbu,(float *)&cfg.a[AXIS_Z].zero_backoff,	Z_ZERO_BACKOFF },
+	{ "z","zbl",_fip, 3, fmt_Xbl, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Z].backlash,		Z_BACKLASH },
+	{ "z","zps",_fip, 3, fmt_Xps, _pr_ma_lin, _get_dbu, _set_ps, (float *)&cfg.a[AXIS_Z].pitch_spacing,Z_PITCH_SPACING },
+	{ "z","zp0",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Z].pitch[0],	0 },
+	{ "z","zp1",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Z].pitch[1],	0 },
+	{ "z","zp2",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Z].pitch[2],	0 },
+	{ "z","zp3",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Z].pitch[3],	0 },
+	{ "z","zp4",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Z].pitch[4],	0 },
+	{ "z","zp5",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Z].pitch[5],	0 },
+	{ "z","zp6",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Z].pitch[6],	0 },
+	{ "z","zp7",_fip, 3, fmt_Xpc, _pr_ma_lin, _get_dbu, _set_pc, (float *)&cfg.a[AXIS_Z].pitch[7],	0 },
 
 	{ "a","aam",_fip, 0, fmt_Xam, _print_am,  _get_am,  _set_am, (float *)&cfg.a[AXIS_A].axis_mode,		A_AXIS_MODE },
 	{ "a","avm",_fip, 0, fmt_Xvm, _pr_ma_rot, _get_dbl, _set_dbl,(float *)&cfg.a[AXIS_A].velocity_max,	A_VELOCITY_MAX },
@@ -682,9 +775,52 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "g30","g30b",_fin, 3, fmt_cloc, _print_corr,_get_dbl, _set_nul,(float *)&gm.g30_position[AXIS_B], 0 },
 	{ "g30","g30c",_fin, 3, fmt_cloc, _print_corr,_get_dbl, _set_nul,(float *)&gm.g30_position[AXIS_C], 0 },
 
+	// Z mesh compensation (see kinematics.h). Points are zm<row><column>, row along Y and column along X
+	{ "zm","zme", _fip, 0, fmt_zme, _print_ui8, _get_ui8, _set_zme, (float *)&cfg.zmesh_enable,		ZMESH_ENABLE },
+	{ "zm","zmx", _fip, 3, fmt_zmx, _print_lin, _get_dbu, _set_zm,  (float *)&cfg.zmesh_origin[0],	ZMESH_ORIGIN_X },
+	{ "zm","zmy", _fip, 3, fmt_zmy, _print_lin, _get_dbu, _set_zm,  (float *)&cfg.zmesh_origin[1],	ZMESH_ORIGIN_Y },
+	{ "zm","zmi", _fip, 3, fmt_zmi, _print_lin, _get_dbu, _set_zms, (float *)&cfg.zmesh_spacing[0],	ZMESH_SPACING_X },
+	{ "zm","zmj", _fip, 3, fmt_zmj, _print_lin, _get_dbu, _set_zms, (float *)&cfg.zmesh_spacing[1],	ZMESH_SPACING_Y },
+
+	{ "zm0","zm00",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[0][0], 0 },
+	{ "zm0","zm01",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[0][1], 0 },
+	{ "zm0","zm02",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[0][2], 0 },
+	{ "zm0","zm03",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[0][3], 0 },
+	{ "zm0","zm04",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[0][4], 0 },
+
+	{ "zm1","zm10",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[1][0], 0 },
+	{ "zm1","zm11",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[1][1], 0 },
+	{ "zm1","zm12",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[1][2], 0 },
+	{ "zm1","zm13",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[1][3], 0 },
+	{ "zm1","zm14",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[1][4], 0 },
+
+	{ "zm2","zm20",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[2][0], 0 },
+	{ "zm2","zm21",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[2][1], 0 },
+	{ "zm2","zm22",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[2][2], 0 },
+	{ "zm2","zm23",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[2][3], 0 },
+	{ "zm2","zm24",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[2][4], 0 },
+
+	{ "zm3","zm30",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[3][0], 0 },
+	{ "zm3","zm31",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[3][1], 0 },
+	{ "zm3","zm32",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[3][2], 0 },
+	{ "zm3","zm33",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[3][3], 0 },
+	{ "zm3","zm34",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[3][4], 0 },
+
+	{ "zm4","zm40",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[4][0], 0 },
+	{ "zm4","zm41",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[4][1], 0 },
+	{ "zm4","zm42",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[4][2], 0 },
+	{ "zm4","zm43",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[4][3], 0 },
+	{ "zm4","zm44",_fip, 3, fmt_zmp, _print_coor,_get_dbu, _set_zm,(float *)&cfg.zmesh[4][4], 0 },
+
+
 	// System parameters
 	{ "sys","ja",  _f07, 0, fmt_ja, _print_lin, _get_dbu, _set_dbu, (float *)&cfg.junction_acceleration,JUNCTION_ACCELERATION },
 	{ "sys","ct",  _f07, 4, fmt_ct, _print_lin, _get_dbu, _set_dbu, (float *)&cfg.chordal_tolerance,	CHORDAL_TOLERANCE },
+	{ "sys","la",  _f07, 3, fmt_la, _print_dbl, _get_dbl, _set_la,  (float *)&cfg.coalesce_angle,		COALESCE_ANGLE },
+	{ "sys","lt",  _f07, 4, fmt_lt, _print_lin, _get_dbu, _set_dbu, (float *)&cfg.coalesce_tolerance,	COALESCE_TOLERANCE },
+	{ "sys","kin", _f07, 0, fmt_kin, _print_ui8, _get_ui8, _set_kin, (float *)&cfg.kinematics,		KINEMATICS },
+	{ "sys","kl",  _f07, 3, fmt_kl, _print_lin, _get_dbu, _set_kd,  (float *)&cfg.delta_rod_length,	DELTA_ROD_LENGTH },
+	{ "sys","kr",  _f07, 3, fmt_kr, _print_lin, _get_dbu, _set_kd,  (float *)&cfg.delta_radius,		DELTA_RADIUS },
 	{ "sys","st",  _f07, 0, fmt_st, _print_ui8, _get_ui8, _set_sw,  (float *)&sw.switch_type,			SWITCH_TYPE },
 	{ "sys","mt",  _f07, 0, fmt_mt, _print_int, _get_int, _set_int, (float *)&cfg.motor_disable_timeout,MOTOR_DISABLE_TIMEOUT},
 	// Note:"me" must initialize after "mt" so it can use the timeout value
@@ -748,6 +884,29 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "","se22",_fpe, 0, fmt_nul, _print_nul, _get_int, _set_int,(float *)&cfg.status_report_list[22],0 },
 	{ "","se23",_fpe, 0, fmt_nul, _print_nul, _get_int, _set_int,(float *)&cfg.status_report_list[23],0 },
 
+#ifdef __STEP_TIMING
+	// Stepper timing - rows are d=DDA ISR, l=load, e=exec, w=late exec wait; then n=min x=max a=mean c=count
+	// Setting any of these clears them all. Not persisted, and kept after every persisted row
+	// so the NVM layout is the same with and without __STEP_TIMING
+	// *** Count must agree with CMD_COUNT_STEP_TIMING below ***
+	{ "stp","stpdn",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpdx",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpda",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpdc",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpln",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stplx",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpla",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stplc",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpen",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpex",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpea",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpec",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpwn",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpwx",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpwa",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+	{ "stp","stpwc",_f00, 0, fmt_stp, _print_stp, _get_stp, _set_stp,(float *)&tg.null, 0 },
+#endif
+
 	// Group lookups - must follow the single-valued entries for proper sub-string matching
 	// *** Must agree with CMD_COUNT_GROUPS below ****
 	{ "","sys",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// system group
@@ -772,9 +931,19 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "","g28",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// g28 home position
 	{ "","g30",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// g30 home position
 	{ "","mpo",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// machine position group
+	{ "","stc",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// motor step count group
 	{ "","pos",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// work position group
 	{ "","ofs",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// work offset group
 	{ "","hom",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// axis homing state group
+	{ "","zm", _f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// Z mesh settings group
+	{ "","zm0",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// Z mesh row groups
+	{ "","zm1",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },
+	{ "","zm2",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },
+	{ "","zm3",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },
+	{ "","zm4",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },
+#ifdef __STEP_TIMING
+	{ "","stp",_f00, 0, fmt_nul, _print_nul, _get_grp, _set_grp,(float *)&tg.null,0 },	// stepper timing group
+#endif
 
 	// Uber-group (groups of groups, for text-mode displays only)
 	// *** Must agree with CMD_COUNT_UBER_GROUPS below ****
@@ -784,12 +953,22 @@ const cfgItem_t cfgArray[] PROGMEM = {
 	{ "", "$", _f00, 0, fmt_nul, _print_nul, _do_all,    _set_nul,(float *)&tg.null,0 }
 };
 
-#define CMD_COUNT_GROUPS 		25		// count of simple groups
+#ifdef __STEP_TIMING
+#define CMD_COUNT_GROUPS 		33		// count of simple groups
+#else
+#define CMD_COUNT_GROUPS 		32		// count of simple groups
+#endif
 #define CMD_COUNT_UBER_GROUPS 	4 		// count of uber-groups
+#ifdef __STEP_TIMING
+#define CMD_COUNT_STEP_TIMING	16		// stp rows between the status report persistence and the groups
+#else
+#define CMD_COUNT_STEP_TIMING	0
+#endif
 
 #define CMD_INDEX_MAX (sizeof cfgArray / sizeof(cfgItem_t))
-#define CMD_INDEX_END_SINGLES		(CMD_INDEX_MAX - CMD_COUNT_UBER_GROUPS - CMD_COUNT_GROUPS - CMD_STATUS_REPORT_LEN)
 #define CMD_INDEX_START_GROUPS		(CMD_INDEX_MAX - CMD_COUNT_UBER_GROUPS - CMD_COUNT_GROUPS)
+#define CMD_INDEX_START_STEP_TIMING	(CMD_INDEX_START_GROUPS - CMD_COUNT_STEP_TIMING)
+#define CMD_INDEX_END_SINGLES		(CMD_INDEX_START_STEP_TIMING - CMD_STATUS_REPORT_LEN)
 #define CMD_INDEX_START_UBER_GROUPS (CMD_INDEX_MAX - CMD_COUNT_UBER_GROUPS)
 
 #define _index_is_single(i) ((i <= CMD_INDEX_END_SINGLES) ? true : false)	// Evaluators
@@ -877,6 +1056,80 @@ static stat_t _get_rx(cmdObj_t *cmd)
 	return (STAT_OK);
 }
 
+static stat_t _get_udr(cmdObj_t *cmd)
+{
+	cmd->value = (float)st_get_underruns();
+	cmd->objtype = TYPE_INTEGER;
+	return (STAT_OK);
+}
+
+/*
+ * _get_stc()	- get a motor step count. The last character of the token is the motor
+ * _print_stc()	- print a motor step count (signed, so _print_int() won't do)
+ */
+static stat_t _get_stc(cmdObj_t *cmd)
+{
+	cmd->value = (float)st_get_step_count(cmd->token[3] - '1');
+	cmd->objtype = TYPE_INTEGER;
+	return (STAT_OK);
+}
+
+static void _print_stc(cmdObj_t *cmd)
+{
+	cmd_get(cmd);
+	char format[CMD_FORMAT_LEN+1];
+	fprintf(stderr, _get_format(cmd->index, format), cmd->token[3], (long)cmd->value);
+}
+
+/*
+ * _get_stp()	- get a stepper timing statistic. The token picks the row and statistic
+ * _set_stp()	- clear all stepper timing statistics
+ * _print_stp()	- print a stepper timing statistic
+ */
+#ifdef __STEP_TIMING
+static const char stp_rows[] = {"dlew"};		// order must agree with stTimingRow (stepper.h)
+static const char stp_stats[] = {"nxac"};		// order must agree with stTimingStat (stepper.h)
+
+static void _get_stp_index(cmdObj_t *cmd, uint8_t *row, uint8_t *stat)
+{
+	char tmp[CMD_TOKEN_LEN+1];
+
+	strcpy_P(tmp, cfgArray[cmd->index].token);
+	*row = strchr(stp_rows, tmp[3]) - stp_rows;
+	*stat = strchr(stp_stats, tmp[4]) - stp_stats;
+}
+
+static stat_t _get_stp(cmdObj_t *cmd)
+{
+	uint8_t row, stat;
+
+	_get_stp_index(cmd, &row, &stat);
+	cmd->value = (float)st_get_timing(row, stat);
+	cmd->objtype = TYPE_INTEGER;
+	return (STAT_OK);
+}
+
+static stat_t _set_stp(cmdObj_t *cmd)
+{
+	st_clear_timing();
+	cmd->value = 0;
+	cmd->objtype = TYPE_INTEGER;
+	return (STAT_OK);
+}
+
+static void _print_stp(cmdObj_t *cmd)
+{
+	uint8_t row, stat;
+	char format[CMD_FORMAT_LEN+1];
+
+	cmd_get(cmd);
+	_get_stp_index(cmd, &row, &stat);
+	fprintf(stderr, _get_format(cmd->index, format), stp_rows[row], stp_stats[stat],
+		(PGM_P)pgm_read_word(&msg_stp_row[row]), (PGM_P)pgm_read_word(&msg_stp_stat[stat]),
+		(double)cmd->value, (stat == TIMING_COUNT) ? "" : TIMING_UNITS);
+}
+#endif // __STEP_TIMING
+
 static stat_t _get_sr(cmdObj_t *cmd)
 {
 	rpt_populate_unfiltered_status_report();
@@ -900,6 +1153,49 @@ static stat_t _set_si(cmdObj_t *cmd)
 	return(STAT_OK);
 }
 
+static stat_t _set_la(cmdObj_t *cmd)
+{
+	if ((cmd->value < 0) || (cmd->value > 90)) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	cfg.coalesce_angle = cmd->value;
+	cfg.coalesce_cosine = cos(cmd->value / RADIAN);	// compute-once for _coalesce_aline()
+	return(STAT_OK);
+}
+
+static stat_t _set_kin(cmdObj_t *cmd)
+{
+	ritorno (_set_0123(cmd));
+	ik_map_motors();									// inhibited axes map differently (see kinematics.c)
+	return(STAT_OK);
+}
+
+static stat_t _set_kd(cmdObj_t *cmd)
+{
+	if (cmd->value <= 0) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	_set_dbu(cmd);
+	ik_delta_init();									// compute-once for the delta kinematics
+	return(STAT_OK);
+}
+
+static stat_t _set_zme(cmdObj_t *cmd)
+{
+	ritorno(_set_01(cmd));
+	ik_mesh_init();										// compute-once for the Z mesh
+	return(STAT_OK);
+}
+
+static stat_t _set_zm(cmdObj_t *cmd)
+{
+	_set_dbu(cmd);
+	ik_mesh_init();
+	return(STAT_OK);
+}
+
+static stat_t _set_zms(cmdObj_t *cmd)
+{
+	if (cmd->value <= 0) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	return (_set_zm(cmd));
+}
+
 static stat_t _run_boot(cmdObj_t *cmd)
 {
 	tg_request_bootloader();
@@ -956,7 +1252,7 @@ static stat_t _get_msg_helper(cmdObj_t *cmd, prog_char_ptr msg, uint8_t value)
 {
 	cmd->value = (float)value;
 	cmd->objtype = TYPE_INTEGER;
-	ritorno(cmd_copy_string_P(cmd, (PGM_P)pgm_read_word(&msg[value*2]))); // hack alert: direct computation of index
+	ritorno(cmd_copy_string_P(cmd, (PGM_P)pgm_read_word(&((PGM_P *)msg)[value]))); // msg is an array of PGM_P
 	return (STAT_OK);
 //	return((char *)pgm_read_word(&msg[(uint8_t)value]));
 }
@@ -1129,6 +1425,7 @@ static stat_t _run_home(cmdObj_t *cmd)
  * _set_sa() - set motor step_angle & recompute steps_per_unit
  * _set_tr() - set motor travel_per_rev & recompute steps_per_unit
  * _set_mi() - set microsteps & recompute steps_per_unit
+ * _set_ma() - set motor map & recompile the kinematics motor table
  * _set_po() - set polarity and update stepper structs
  * _set_pm() - set motor power mode and take action
  *
@@ -1145,6 +1442,7 @@ static stat_t _set_motor_steps_per_unit(cmdObj_t *cmd)
 {
 	uint8_t m = _get_motor(cmd->index);
 	cfg.m[m].steps_per_unit = (360 / (cfg.m[m].step_angle / cfg.m[m].microsteps) / cfg.m[m].travel_rev);
+	ik_map_motors();
 	return (STAT_OK);
 }
 
@@ -1163,9 +1461,24 @@ static stat_t _set_am(cmdObj_t *cmd)		// axis mode
 		if (cmd->value > AXIS_MAX_ROTARY) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
 	}
 	_set_ui8(cmd);
+	ik_map_motors();
+	ik_comp_init();
+	return(STAT_OK);
+}
+
+static stat_t _set_pc(cmdObj_t *cmd)		// pitch correction or backlash
+{
+	_set_dbu(cmd);
+	ik_comp_init();							// compute-once for the compensation
 	return(STAT_OK);
 }
 
+static stat_t _set_ps(cmdObj_t *cmd)		// pitch table spacing
+{
+	if (cmd->value <= 0) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	return (_set_pc(cmd));
+}
+
 static stat_t _set_sw(cmdObj_t *cmd)		// switch setting
 {
 	if (cmd->value > SW_MODE_MAX_VALUE) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
@@ -1199,6 +1512,13 @@ static stat_t _set_mi(cmdObj_t *cmd)		// motor microsteps
 	return (STAT_OK);
 }
 
+static stat_t _set_ma(cmdObj_t *cmd)		// motor map to axis
+{
+	_set_ui8(cmd);
+	ik_map_motors();
+	return (STAT_OK);
+}
+
 static stat_t _set_po(cmdObj_t *cmd)		// motor polarity
 { 
 	ritorno (_set_01(cmd));
@@ -1411,6 +1731,10 @@ static stat_t _do_all(cmdObj_t *cmd)	// print all parameters
 	_get_grp(cmd);
 	cmd_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_RESPONSE_FORMAT);
 
+	strcpy(cmd->token,"zm");			// print Z mesh settings (the points are $zm0...$zm4)
+	_get_grp(cmd);
+	cmd_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_RESPONSE_FORMAT);
+
 	return (_do_offsets(cmd));			// print all offsets
 }
 
@@ -1885,7 +2209,9 @@ static stat_t _get_grp(cmdObj_t *cmd)
 	char *parent_group = cmd->token;		// token in the parent cmd object is the group
 	char group[CMD_GROUP_LEN+1];			// group string retrieved from cfgArray child
 	cmd->objtype = TYPE_PARENT;				// make first object the parent 
-	for (index_t i=0; i<=CMD_INDEX_END_SINGLES; i++) {
+	for (index_t i=0; i<CMD_INDEX_START_GROUPS; i++) {
+		if (i == CMD_INDEX_END_SINGLES+1) { i = CMD_INDEX_START_STEP_TIMING;}	// skip to the stp rows
+		if (i == CMD_INDEX_START_GROUPS) break;
 		strcpy_P(group, cfgArray[i].group);  // don't need strncpy as it's always terminated
 		if (strcmp(parent_group, group) != 0) continue;
 		(++cmd)->index = i;
@@ -186,6 +186,9 @@ typedef uint16_t index_t;			// use this if there are > 255 indexed objects
 #define CMD_STATUS_REPORT_LEN 28	// max number of status report elements - see cfgArray
 									// must also line up in cfgArray, se00 - seXX
 
+#define ZMESH_POINTS 5				// Z mesh points per row and column - see cfgArray zm00 - zm44
+#define PITCH_POINTS 8				// pitch error table points per axis - see cfgArray xp0 - xp7
+
 #define NVM_VALUE_LEN 4				// NVM value length (float, fixed length)
 #define NVM_BASE_ADDR 0x0000		// base address of usable NVM
 
@@ -361,6 +364,9 @@ typedef struct cfgAxisParameters {
 	float latch_backoff;			// backoff from switches prior to homing latch movement
 	float zero_backoff;				// backoff from switches for machine zero
 	float jerk_homing;				// homing jerk (Jh) in mm/min^3
+	float backlash;					// backlash taken up on direction reversal (see kinematics.h)
+	float pitch_spacing;			// distance between pitch error table points
+	float pitch[PITCH_POINTS];		// pitch error corrections from machine zero up
 } cfgAxis_t;
 
 typedef struct cfgMotorParameters {
@@ -395,6 +401,16 @@ typedef struct cfgParameters {
 	// system group settings
 	float junction_acceleration;	// centripetal acceleration max for cornering
 	float chordal_tolerance;		// arc chordal accuracy setting in mm
+	float coalesce_angle;			// max direction change in degrees for merging G1 moves (0 = off)
+	float coalesce_cosine;			// cosine of coalesce_angle (derived)
+	float coalesce_tolerance;		// max chord error in mm for merging G1 moves
+	uint8_t kinematics;				// machine kinematics (see kinematics.h)
+	float delta_rod_length;			// delta diagonal rod length in mm
+	float delta_radius;				// delta tower to effector distance in mm
+	uint8_t zmesh_enable;			// Z mesh compensation on (see kinematics.h)
+	float zmesh_origin[2];			// XY of mesh point zm00
+	float zmesh_spacing[2];			// XY distance between mesh points
+	float zmesh[ZMESH_POINTS][ZMESH_POINTS];// Z offsets in mm, [row (Y)][column (X)]
 	uint32_t motor_disable_timeout;	// time in seconds before disabling motors
 	uint32_t motor_disable_timer;	// down counter for above (in system ticks - 10ms increments)
 //	float max_spindle_speed;		// in RPM
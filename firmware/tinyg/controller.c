@@ -30,6 +30,7 @@
 
 #include <ctype.h>				// for parsing
 #include <string.h>
+#include <stdlib.h>				// for strtoul()
 #include <avr/pgmspace.h>		// precursor for xio.h
 #include <avr/interrupt.h>
 #include <avr/wdt.h>			// used for software reset
@@ -42,6 +43,7 @@
 #include "gcode_parser.h"
 #include "canonical_machine.h"
 #include "plan_arc.h"
+#include "plan_spline.h"
 #include "planner.h"
 #include "stepper.h"
 #include "system.h"
@@ -52,10 +54,15 @@
 #include "xio/xio.h"
 #include "xmega/xmega_rtc.h"
 #include "xmega/xmega_init.h"
+#ifdef __SIMULATION
+#include "sim/sim.h"
+#endif
 
 // local helpers
 static void _controller_HSM(void);
 static stat_t _dispatch(void);
+static stat_t _check_line(char *block, uint32_t *resend);
+static void _check_line_response(stat_t status, uint32_t resend);
 static stat_t _reset_handler(void);
 static stat_t _bootloader_handler(void);
 static stat_t _limit_switch_handler(void);
@@ -77,6 +84,8 @@ void tg_init(uint8_t std_in, uint8_t std_out, uint8_t std_err)
 
 	tg.reset_requested = false;
 	tg.bootloader_requested = false;
+	tg.line_expected = 1;
+	tg.line_resend = 0;
 
 	xio_set_stdin(std_in);
 	xio_set_stdout(std_out);
@@ -110,6 +119,9 @@ void tg_init(uint8_t std_in, uint8_t std_out, uint8_t std_err)
 void tg_controller() 
 { 
 	while (true) { 
+#ifdef __SIMULATION
+		sim_run_interrupts();			// host simulation runs the timer ISRs here
+#endif
 		_controller_HSM();
 	}
 }
@@ -141,7 +153,7 @@ static void _controller_HSM()
 //----- planner hierarchy for gcode and cycles -------------------------//
 	DISPATCH(rpt_status_report_callback());	// conditionally send status report
 	DISPATCH(rpt_queue_report_callback());	// conditionally send queue report
-	DISPATCH(ar_arc_callback());			// arc generation runs behind lines
+	DISPATCH(sp_spline_callback());			// G5 spline lines run behind lines
 	DISPATCH(cm_homing_callback());			// G28.2 continuation
 
 //----- command readers and parsers ------------------------------------//
@@ -163,6 +175,7 @@ static void _controller_HSM()
 static stat_t _dispatch()
 {
 	uint8_t status;
+	uint32_t resend;
 
 	// read input line or return if not a completed line
 	// xio_gets() is a non-blocking workalike of fgets()
@@ -192,6 +205,15 @@ static stat_t _dispatch()
 //		case '@': { cm_request_queue_flush(); break; }
 //		case '~': { cm_request_cycle_start(); break; }
 
+		case STX: {								// binary gcode block (see gcode_parser.h)
+			if (cfg.comm_mode == JSON_MODE) {
+				cmd_reset_list();
+				cmd_print_list(gc_binary_parser(tg.bufp+1), TEXT_NO_PRINT, JSON_RESPONSE_FORMAT);
+			} else {
+				tg_text_response(gc_binary_parser(tg.bufp+1), tg.saved_buf);
+			}
+			break;
+		}
 		case NUL: { 							// blank line (just a CR)
 			if (cfg.comm_mode != JSON_MODE) {
 				tg_text_response(STAT_OK, tg.saved_buf);
@@ -215,6 +237,10 @@ static stat_t _dispatch()
 			break;
 		}
 		default: {								// anything else must be Gcode
+			if ((status = _check_line(tg.bufp, &resend)) != STAT_OK) {
+				_check_line_response(status, resend);
+				break;
+			}
 			if (cfg.comm_mode == JSON_MODE) {
 				strncpy(tg.out_buf, tg.bufp, INPUT_BUFFER_LEN -8);	// use out_buf as temp
 				sprintf(tg.bufp,"{\"gc\":\"%s\"}\n", tg.out_buf);
@@ -227,6 +253,91 @@ static stat_t _dispatch()
 	return (STAT_OK);
 }
 
+/*
+ * _check_line() - validate a line numbered, checksummed gcode block
+ *
+ *	A host that streams lines ahead of their responses sends them as
+ *	"N<line> <gcode>*<checksum>", the checksum being compute_checksum() of
+ *	everything before the '*'. Every line gets exactly one response, in the
+ *	order sent, so the host slides its window of lines in flight by counting
+ *	responses. Blocks run only in line number order:
+ *
+ *	  - A good line with the expected number runs (without its checksum).
+ *	  - A good line with a lower number has run already - the host went back
+ *		further than it had to. It gets an ok and doesn't run again.
+ *	  - A line with a bad checksum, or the first line past a gap, gets an error
+ *		and a resend request for the expected line. The host goes back to that
+ *		line and sends everything from there again.
+ *	  - Lines past the gap that were in flight already get an error but no
+ *		further resend request, until the expected line arrives. A bad checksum
+ *		always asks again as it may have been the resent line.
+ *	  - N0 restarts the numbering at 1. A host starts each stream with it, or
+ *		lines it numbers from 1 could be taken for lines of an earlier stream.
+ *
+ *	A '*' that isn't in a comment starts the checksum, and anything but digits
+ *	after it is damage. Lines without a checksum are passed as before, and a
+ *	checksummed line without a line number has its checksum checked only.
+ *
+ *	Returns STAT_OK to run the block, STAT_NOOP to acknowledge it without
+ *	running it, or an error. Resend is the line to ask for with the error, 0
+ *	for none.
+ */
+static stat_t _check_line(char *block, uint32_t *resend)
+{
+	char *star = strrchr(block, '*');
+	char *end;
+
+	*resend = 0;
+	if ((star == NULL) || (strchr(star, ')') != NULL) || (memchr(block, ';', star - block) != NULL)) {
+		return (STAT_OK);						// no checksum, or a '*' in a comment
+	}
+	uint32_t checksum = strtoul(star+1, &end, 10);
+	if ((isdigit(star[1]) == false) || (*end != NUL) || (checksum != compute_checksum(block, star - block))) {
+		tg.line_resend = tg.line_expected;
+		*resend = tg.line_resend;
+		return (STAT_CHECKSUM_MISMATCH);
+	}
+	*star = NUL;								// the block runs without its checksum
+
+	char *rd = block;
+	while (isspace(*rd)) { rd++;}
+	if ((toupper(*rd) != 'N') || (isdigit(rd[1]) == false)) { return (STAT_OK);}
+	uint32_t line = strtoul(rd+1, NULL, 10);
+
+	if ((line == 0) || (line == tg.line_expected)) {
+		tg.line_expected = line+1;
+		tg.line_resend = 0;
+		return (STAT_OK);
+	}
+	if (line < tg.line_expected) { return (STAT_NOOP);}
+	if (tg.line_resend == 0) {					// first line past the gap
+		tg.line_resend = tg.line_expected;
+		*resend = tg.line_resend;
+	}
+	return (STAT_LINE_NUMBER_ERROR);
+}
+
+/*
+ * _check_line_response() - respond to a line _check_line() won't run
+ *
+ *	Text mode puts a "resend <line>" line ahead of the error prompt, so the
+ *	prompt still ends the response. JSON mode puts {"rs":<line>} in it.
+ */
+static void _check_line_response(stat_t status, uint32_t resend)
+{
+	if (status == STAT_NOOP) { status = STAT_OK;}
+	if (cfg.comm_mode == JSON_MODE) {
+		cmd_reset_list();
+		if (resend != 0) { cmd_add_integer("rs", resend);}
+		cmd_print_list(status, TEXT_NO_PRINT, JSON_RESPONSE_FORMAT);
+	} else {
+		if ((resend != 0) && (cfg.text_verbosity != TV_SILENT)) {
+			fprintf_P(stderr, PSTR("resend %lu\n"), (unsigned long)resend);
+		}
+		tg_text_response(status, tg.saved_buf);
+	}
+}
+
 /************************************************************************************
  * tg_text_response() - text mode responses
  */
@@ -281,6 +392,7 @@ static stat_t _sync_to_tx_buffer()
 static stat_t _sync_to_planner()
 {
 	if (mp_get_planner_buffers_available() < PLANNER_BUFFER_HEADROOM) { // allow up to N planner buffers for this line
+		_sim_planner_stall();
 		return (STAT_EAGAIN);
 	}
 	return (STAT_OK);
@@ -384,8 +496,6 @@ uint8_t _system_assertions()
 	if (mb.magic_end		!= MAGICNUM) { value = 12; }
 	if (mr.magic_start		!= MAGICNUM) { value = 13; }
 	if (mr.magic_end		!= MAGICNUM) { value = 14; }
-	if (ar.magic_start		!= MAGICNUM) { value = 15; }
-	if (ar.magic_end		!= MAGICNUM) { value = 16; }
 	if (st_get_st_magic()	!= MAGICNUM) { value = 17; }
 	if (st_get_sps_magic()	!= MAGICNUM) { value = 18; }
 	if (rtc.magic_end 		!= MAGICNUM) { value = 19; }
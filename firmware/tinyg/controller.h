@@ -48,6 +48,8 @@ struct controllerSingleton {			// main TG controller struct
 	uint8_t default_src;				// default source device
 	uint8_t network_mode;				// 0=master, 1=repeater, 2=slave
 	uint8_t linelen;					// length of currently processing line
+	uint32_t line_expected;				// next line of a checksummed stream (see _check_line())
+	uint32_t line_resend;				// line the host was asked to send again, 0 = none pending
 	uint8_t led_state;					// 0=off, 1=on
 	int32_t led_counter;				// a convenience for flashing an LED
 	uint8_t reset_requested;			// flag to perform a software reset
@@ -25,6 +25,7 @@
 #include <math.h>
 #include <string.h>					// needed for memcpy, memset
 #include <avr/pgmspace.h>			// precursor for xio.h
+#include <util/crc16.h>				// binary block CRC
 
 #include "tinyg.h"
 #include "util.h"
@@ -33,14 +34,29 @@
 #include "canonical_machine.h"
 #include "xio/xio.h"				// for char definitions
 
+#ifdef __SIMULATION
+#include "sim/sim.h"
+#endif
+
 struct gcodeParserSingleton {	 	  // struct to manage globals
 	uint8_t modals[MODAL_GROUP_COUNT];// collects modal groups in a block
+	char *comment;					  // comment of the block or NULL (see _get_comment())
+	char *msg;						  // message in the comment or NULL
 }; struct gcodeParserSingleton gp;
 
+struct gcodeBinarySingleton {		  // binary block state (see gcode_parser.h)
+	uint8_t sequence;				  // sequence number of the next binary block
+}; struct gcodeBinarySingleton gb;
+
 // local helper functions and macros
-static void _normalize_gcode_block(char_t *cmd, char_t **com, char_t **msg, uint8_t *block_delete_flag);
 static stat_t _get_next_gcode_word(char **pstr, char *letter, float *value);
+static stat_t _get_number(char **pstr, float *value);
+static void _get_comment(char *rd);
 static stat_t _point(float value);
+static stat_t _parse_gcode_word(char letter, float value);
+static void _init_gcode_block(void);
+static stat_t _get_binary_word(char **pstr, uint8_t digits, uint32_t *word);
+static uint16_t _get_binary_crc(uint32_t word[], uint8_t words);
 static stat_t _validate_gcode_block(void);
 static stat_t _parse_gcode_block(char_t *line);	// Parse the block into the GN/GF structs
 static stat_t _execute_gcode_block(void);		// Execute the gcode block
@@ -52,45 +68,125 @@ static stat_t _execute_gcode_block(void);		// Execute the gcode block
 /*
  * gc_gcode_parser() - parse a block (line) of gcode
  *
- *	Top level of gcode parser. Normalizes block and looks for special cases
+ *	Top level of gcode parser. Looks for special cases and reads the block in place
  */
 
 stat_t gc_gcode_parser(char_t *block)
 {
-	char_t *cmd = block;					// gcode command or NUL string
-	char_t none = NUL;
-	char_t *com = &none;					// gcode comment or NUL string
-	char_t *msg = &none;					// gcode message or NUL string
-	uint8_t block_delete_flag;
-
-	_normalize_gcode_block(cmd, &com, &msg, &block_delete_flag);
-	
-	if ((block_delete_flag == true) && (cm_get_block_delete_switch() == true)) {
-		return (STAT_NOOP);
+	_sim_parse_begin();
+	if ((*block == '/') && (cm_get_block_delete_switch() == true)) {
+		return (STAT_NOOP);					// block delete
 	}
-//	if (*msg != NUL) { // +++++ THIS HAS A SERIOUS BUG IN IT SO FOR NOW IT'S DISABLED
-//		(void)cm_message(msg);				// queue the message	
-//	}	
 	return(_parse_gcode_block(block));
 }
 
 /*
- * _normalize_gcode_block() - normalize a block (line) of gcode in place
+ * _get_next_gcode_word() - get gcode word consisting of a letter and a value
  *
- *	Normalization functions:
- *   - convert all letters to upper case
- *	 - remove white space, control and other invalid characters 
- *	 - remove (erroneous) leading zeros that might be taken to mean Octal
- *	 - identify and return start of comments and messages
- *	 - signal if a block-delete character (/) was encountered in the first space
+ *	Reads the raw block in a single pass. Nothing is copied or moved, so there is
+ *	no normalization pass over the block before the words are read:
+ *	 - letters are folded to upper case as they are read
+ *	 - white space, control and other invalid characters between words are skipped,
+ *	   as are spaces between the letter and its value ("X 10")
+ *	 - values are read by _get_number(), which only reads decimal. Leading zeros
+ *	   are not taken to mean Octal (G01 is G1) and G0X... is not read as hexadecimal
+ *	 - a comment ends the block (see _get_comment())
  *
- *	So this: "  g1 x100 Y100 f400" becomes this: "G1X100Y100F400"
+ *	So this: "  g1 x100 Y100 f400" reads as G1 X100 Y100 F400. A number with no
+ *	letter in front of it is an error (G1 X10 5 does not read as G1 X105).
  *
- *	Comment and message handling:
+ *	Returns STAT_COMPLETE at the end of the block or at its comment.
+ */
+static stat_t _get_next_gcode_word(char **pstr, char *letter, float *value) 
+{
+	char *rd = *pstr;
+
+	for (;; rd++) {
+		if (isalpha(*rd)) break;
+		if ((*rd == NUL) || (*rd == '(') || (*rd == ';')) {	// no more words
+			_get_comment(rd);
+			*pstr = rd;
+			return (STAT_COMPLETE);
+		}
+		if ((isdigit(*rd)) || (*rd == '-') || (*rd == '+') || (*rd == '.')) {
+			return (STAT_EXPECTED_COMMAND_LETTER);
+		}
+	}
+	*letter = (char)toupper(*rd++);
+	while ((*rd == ' ') || (*rd == '\t')) { rd++;}
+	ritorno(_get_number(&rd, value));
+	*pstr = rd;
+	return (STAT_OK);			// pointer points to next character after the word
+}
+
+/*
+ * _get_number() - read a gcode number: an optional sign, digits and an optional decimal point
+ *
+ *	Used instead of strtod(), which is slow on the AVR and reads more than gcode
+ *	has (exponents, hex, inf, nan). The digits are collected as an integer and
+ *	scaled once by an exact power of ten, so a number of up to 7 significant 
+ *	digits (a mantissa below 2^24) is correctly rounded to float. Anything that
+ *	can't be done in one exact operation - a mantissa of 2^24 or more, or a 
+ *	scale past 10^GC_POWERS_MAX - is read with strtod() instead, with the number
+ *	NUL terminated so it can't read an exponent. So the result is always the 
+ *	same as strtod()'s.
+ *
+ *	Returns STAT_BAD_NUMBER_FORMAT if there are no digits. *pstr is advanced past the number.
+ */
+static const float _powers_of_ten[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10 };
+#define GC_POWERS_MAX 10					// largest power of ten in the table (all exact in float)
+#define GC_MANTISSA_EXACT 16777216UL		// 2^24: smaller mantissas are exact in float
+
+static stat_t _get_number(char **pstr, float *value)
+{
+	char *start = *pstr;
+	char *rd = start;
+	uint32_t mantissa = 0;
+	int8_t scale = 0;						// power of ten the mantissa is off by
+	uint8_t digits = 0;
+	uint8_t negative = false;
+
+	if (*rd == '-') { negative = true; rd++;}
+	else if (*rd == '+') { rd++;}
+
+	for (; isdigit(*rd); rd++, digits++) {	// integer part
+		if (mantissa < GC_MANTISSA_EXACT) { mantissa = mantissa * 10 + (*rd - '0');}
+		else if (scale < INT8_MAX) { scale++;}
+	}
+	if (*rd == '.') {						// fraction
+		for (rd++; isdigit(*rd); rd++, digits++) {
+			if ((mantissa < GC_MANTISSA_EXACT) && (scale > INT8_MIN)) {
+				mantissa = mantissa * 10 + (*rd - '0');
+				scale--;
+			}
+		}
+	}
+	if (digits == 0) { return (STAT_BAD_NUMBER_FORMAT);}
+
+	if ((mantissa >= GC_MANTISSA_EXACT) || (scale > GC_POWERS_MAX) || (scale < -GC_POWERS_MAX)) {
+		char end = *rd;						// rounding it here would round twice
+		*rd = NUL;
+		*value = strtod(start, NULL);
+		*rd = end;
+		*pstr = rd;
+		return (STAT_OK);
+	}
+	float number = (float)mantissa;
+	if (scale > 0) { number *= _powers_of_ten[scale];}
+	else if (scale < 0) { number /= _powers_of_ten[-scale];}
+
+	*value = (negative == true) ? -number : number;
+	*pstr = rd;
+	return (STAT_OK);
+}
+
+/*
+ * _get_comment() - find the comment and message of a block
+ *
+ *	Called with the character that ended the words of the block.
  *	 - Comments field start with a '(' char or alternately a semicolon ';' 
- *	 - Comments and messages are not normalized - they are left alone
+ *	 - Comments and messages are left as they are (apart from the NUL on the trailing paren)
  *	 - The 'MSG' specifier in comment can have mixed case but cannot cannot have embedded white spaces
- *	 - Normalization returns true if there was a message to display, false otherwise
  *	 - Comments always terminate the block - i.e. leading or embedded comments are not supported
  *	 	- Valid cases (examples)			Notes:
  *		    G0X10							 - command only - no comment
@@ -105,88 +201,20 @@ stat_t gc_gcode_parser(char_t *block)
  *		    (comment) G0X10 				 - leading comment. G0X10 will be ignored
  * 			G0X10 # comment					 - invalid separator
  *
- *	Returns:
- *	 - com points to comment string or to NUL if no comment
- *	 - msg points to message string or to NUL if no comment
- *	 - block_delete_flag is set true if block delete encountered, false otherwise
+ *	Sets gp.comment to the comment text and gp.msg to the message, or leaves them NULL.
+ *	The comment is NUL terminated on its trailing parenthesis, if any.
  */
-static void _normalize_gcode_block(char_t *cmd, char_t **com, char_t **msg, uint8_t *block_delete_flag)
+static void _get_comment(char *rd)
 {
-	char_t *rd = cmd;				// read pointer
-	char_t *wr = cmd;				// write pointer
-
-	// Preset comments and messages to NUL string
-	// Not required if com and msg already point to NUL on entry
-//	for (rd = cmd; *rd != NUL; rd++) { if (*rd == NUL) { *com = rd; *msg = rd; rd = cmd;} }
-
-	// mark block deletes
-	if (*rd == '/') { *block_delete_flag = true; } 
-	else { *block_delete_flag = false; }
-	
-	// normalize the command block & find the comment (if any)
-	for (; *wr != NUL; rd++) {
-		if (*rd == NUL) { *wr = NUL; }
-//		else if (*rd == '(') { *wr = NUL; *com = rd+1; }
-		else if ((*rd == '(') || (*rd == ';')) { *wr = NUL; *com = rd+1; }
-		else if ((isalnum((char)*rd)) || (strchr("-.", *rd))) { // all valid characters
-			*(wr++) = (char_t)toupper((char)*(rd));
-		}
+	if (*rd == NUL) { return;}
+	gp.comment = ++rd;
+	while (isspace(*rd)) { rd++; }		// skip any leading spaces before "msg"
+	if ((tolower(*rd) == 'm') && (tolower(*(rd+1)) == 's') && (tolower(*(rd+2)) == 'g')) {
+		gp.msg = rd+3;
 	}
-	
-	// Perform Octal stripping - remove invalid leading zeros in number strings
-	rd = cmd;
-	while (*rd != NUL) {
-		if (*rd == '.') break;							// don't strip past a decimal point
-		if ((!isdigit(*rd)) && (*(rd+1) == '0') && (isdigit(*(rd+2)))) {
-			wr = rd+1;
-			while (*wr != NUL) { *wr = *(wr+1); wr++;}	// copy forward w/overwrite
-			continue;
-		}
-		rd++;
+	for (; *rd != NUL; rd++) {	
+		if (*rd == ')') { *rd = NUL; break;}	// NUL terminate on trailing parenthesis, if any
 	}
-	
-	// process comments and messages
-	if (**com != NUL) {
-		rd = *com;
-		while (isspace(*rd)) { rd++; }		// skip any leading spaces before "msg"
-		if ((tolower(*rd) == 'm') && (tolower(*(rd+1)) == 's') && (tolower(*(rd+2)) == 'g')) {
-			*msg = rd+3;
-		}
-		for (; *rd != NUL; rd++) {	
-			if (*rd == ')') *rd = NUL;		// NUL terminate on trailing parenthesis, if any
-		}
-	}
-}
-
-/*
- * _get_next_gcode_word() - get gcode word consisting of a letter and a value
- *
- *	This function requires the Gcode string to be normalized.
- *	Normalization must remove any leading zeros or they will be converted to Octal
- *	G0X... is not interpreted as hexadecimal. This is trapped.
- */
-static stat_t _get_next_gcode_word(char **pstr, char *letter, float *value) 
-{
-	if (**pstr == NUL) { return (STAT_COMPLETE); }	// no more words
-
-	// get letter part
-	if(isupper(**pstr) == false) { return (STAT_EXPECTED_COMMAND_LETTER); }
-	*letter = **pstr;
-	(*pstr)++;
-	
-	// X-axis-becomes-a-hexadecimal-number get-value case, e.g. G0X100 --> G255
-	if ((**pstr == '0') && (*(*pstr+1) == 'X')) {
-		*value = 0;
-		(*pstr)++;
-		return (STAT_OK);		// pointer points to X
-	}
-
-	// get-value general case
-	char *end; 
-	*value = strtod(*pstr, &end);
-	if(end == *pstr) { return(STAT_BAD_NUMBER_FORMAT); }	// more robust test then checking for value=0;
-	*pstr = end;
-	return (STAT_OK);			// pointer points to next character after the word
 }
 
 /*
@@ -223,8 +251,8 @@ static stat_t _validate_gcode_block()
  * _parse_gcode_block() - parses one line of NULL terminated G-Code. 
  *
  *	All the parser does is load the state values in gn (next model state) and set flags
- *	in gf (model state flags). The execute routine applies them. The buffer is assumed to 
- *	contain only uppercase characters and signed floats (no whitespace).
+ *	in gf (model state flags). The execute routine applies them. The block is read as it
+ *	was received - see _get_next_gcode_word() for what it may contain.
  *
  *	A number of implicit things happen when the gn struct is zeroed:
  *	  - inverse feed rate mode is cancelled - set back to units_per_minute mode
@@ -236,137 +264,263 @@ static stat_t _parse_gcode_block(char_t *buf)
 	float value = 0;				// value parsed from letter (e.g. 2 for G2)
 	stat_t status = STAT_OK;
 
-	// set initial state for new move 
+	_init_gcode_block();
+  	// extract commands and parameters
+	while((status = _get_next_gcode_word(&pstr, &letter, &value)) == STAT_OK) {
+		if ((status = _parse_gcode_word(letter, value)) != STAT_OK) break;
+	}
+	_sim_parse_end();
+//	if (gp.msg != NULL) { // +++++ THIS HAS A SERIOUS BUG IN IT SO FOR NOW IT'S DISABLED
+//		(void)cm_message(gp.msg);				// queue the message	
+//	}	
+	if ((status != STAT_OK) && (status != STAT_COMPLETE)) return (status);
+	ritorno(_validate_gcode_block());
+	return (_execute_gcode_block());		// if successful execute the block
+}
+
+/*
+ * gc_binary_parser() - parse a binary gcode block (see gcode_parser.h)
+ *
+ *	Called with the block after its STX. The values are float32 already, so they
+ *	go straight into the gn and gf structs through _parse_gcode_word() with
+ *	no text to read and no numbers to convert. A NaN or infinite value, which
+ *	no text block can give, is rejected as STAT_BINARY_BLOCK_ERROR.
+ */
+stat_t gc_binary_parser(char_t *block)
+{
+	char *rd = (char *)block;
+	uint32_t word[GC_BINARY_MAX_VALUES+1];	// header and values
+	uint32_t crc;
+	uint8_t words = 0;
+	uint8_t values = 0;
+	stat_t status = STAT_OK;
+
+	_sim_parse_begin();
+	uint8_t len = strlen(rd);
+	if ((len < GC_BINARY_WORD_LEN + GC_BINARY_CRC_LEN) || 
+		((len - GC_BINARY_CRC_LEN) % GC_BINARY_WORD_LEN != 0) ||
+		((words = (len - GC_BINARY_CRC_LEN) / GC_BINARY_WORD_LEN) > GC_BINARY_MAX_VALUES+1)) {
+		return (STAT_BINARY_BLOCK_ERROR);
+	}
+	for (uint8_t i=0; i<words; i++) {
+		ritorno(_get_binary_word(&rd, GC_BINARY_WORD_LEN, &word[i]));
+	}
+	ritorno(_get_binary_word(&rd, GC_BINARY_CRC_LEN, &crc));
+	if (crc != _get_binary_crc(word, words)) { return (STAT_BINARY_BLOCK_ERROR);}
+
+	uint8_t sequence = (uint8_t)(word[0] >> 24);
+	uint8_t opcode = (uint8_t)(word[0] >> 16);
+	uint16_t mask = (uint16_t)word[0];
+	for (uint16_t bits = mask; bits != 0; bits >>= 1) { values += (bits & 1);}
+	if ((opcode >= GC_OPCODE_COUNT) || (values != words-1) || (mask >> GC_BINARY_MAX_VALUES != 0)) {
+		return (STAT_BINARY_BLOCK_ERROR);
+	}
+	for (uint8_t v=1; v<words; v++) {
+		union { uint32_t word; float value; } number = { .word = word[v] };
+		if (isfinite(number.value) == false) { return (STAT_BINARY_BLOCK_ERROR);}
+	}
+	if ((sequence != 0) && (sequence != gb.sequence)) { return (STAT_BINARY_SEQUENCE_ERROR);}
+	gb.sequence = (sequence == GC_BINARY_SEQUENCE_MAX) ? 1 : sequence+1;
+
+	_init_gcode_block();
+	if (opcode != GC_OPCODE_NONE) {
+		status = _parse_gcode_word('G', (float)(opcode - GC_OPCODE_G0));
+	}
+	for (uint8_t i=0, v=1; (mask != 0) && (status == STAT_OK); i++, mask >>= 1) {
+		if ((mask & 1) == 0) continue;
+		union { uint32_t word; float value; } number = { .word = word[v++] };
+		status = _parse_gcode_word(GC_BINARY_WORDS[i], number.value);
+	}
+	_sim_parse_end();
+	ritorno(status);
+	ritorno(_validate_gcode_block());
+	return (_execute_gcode_block());
+}
+
+/*
+ * _get_binary_word() - read a number of base85 digits into a 32 bit word
+ * _get_binary_crc()  - CRC-16 of the words of a binary block
+ */
+static stat_t _get_binary_word(char **pstr, uint8_t digits, uint32_t *word)
+{
+	uint32_t value = 0;
+
+	for (; digits > 0; digits--) {
+		char c = *(*pstr)++;
+		if ((c < GC_BINARY_DIGIT_MIN) || (c > GC_BINARY_DIGIT_MAX) || (c == GC_BINARY_DIGIT_SKIP)) {
+			return (STAT_BINARY_BLOCK_ERROR);
+		}
+		uint8_t digit = c - GC_BINARY_DIGIT_MIN - ((c > GC_BINARY_DIGIT_SKIP) ? 1 : 0);
+		if ((value > UINT32_MAX / GC_BINARY_DIGITS) || 		// value * 85 + digit must fit
+			((value == UINT32_MAX / GC_BINARY_DIGITS) && (digit != 0))) {
+			return (STAT_BINARY_BLOCK_ERROR);
+		}
+		value = value * GC_BINARY_DIGITS + digit;
+	}
+	*word = value;
+	return (STAT_OK);
+}
+
+static uint16_t _get_binary_crc(uint32_t word[], uint8_t words)
+{
+	uint16_t crc = 0xFFFF;
+
+	for (uint8_t i=0; i<words; i++) {
+		for (int8_t shift=24; shift >= 0; shift -= 8) {
+			crc = _crc_ccitt_update(crc, (uint8_t)(word[i] >> shift));
+		}
+	}
+	return (crc);
+}
+
+/*
+ * _init_gcode_block() - set initial state for new move
+ */
+static void _init_gcode_block()
+{
 	memset(&gp, 0, sizeof(gp));		// clear all parser values
 	memset(&gf, 0, sizeof(gf));		// clear all next-state flags
 	memset(&gn, 0, sizeof(gn));		// clear all next-state values
 	gn.motion_mode = cm_get_model_motion_mode();// get motion mode from previous block
+}
 
-  	// extract commands and parameters
-	while((status = _get_next_gcode_word(&pstr, &letter, &value)) == STAT_OK) {
-		switch(letter) {
-			case 'G':
-				switch((uint8_t)value) {
-					case 0:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_STRAIGHT_TRAVERSE);
-					case 1:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_STRAIGHT_FEED);
-					case 2:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CW_ARC);
-					case 3:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CCW_ARC);
-					case 4:  SET_NON_MODAL (next_action, NEXT_ACTION_DWELL);
-					case 10: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_COORD_DATA);
-					case 17: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_XY);
-					case 18: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_XZ);
-					case 19: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_YZ);
-					case 20: SET_MODAL (MODAL_GROUP_G6, units_mode, INCHES);
-					case 21: SET_MODAL (MODAL_GROUP_G6, units_mode, MILLIMETERS);
-					case 28: {
-						switch (_point(value)) {
-							case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_GOTO_G28_POSITION);
-							case 1: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_G28_POSITION); 
-							case 2: SET_NON_MODAL (next_action, NEXT_ACTION_SEARCH_HOME); 
-							case 3: SET_NON_MODAL (next_action, NEXT_ACTION_SET_ABSOLUTE_ORIGIN);
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
+/*
+ * _parse_gcode_word() - load one word (letter and value) into the gn and gf structs
+ *
+ *	Shared by text blocks and binary blocks (see gc_binary_parser())
+ */
+static stat_t _parse_gcode_word(char letter, float value)
+{
+	stat_t status = STAT_OK;
+
+	switch(letter) {
+		case 'G':
+			switch((uint8_t)value) {
+				case 0:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_STRAIGHT_TRAVERSE);
+				case 1:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_STRAIGHT_FEED);
+				case 2:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CW_ARC);
+				case 3:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CCW_ARC);
+				case 4:  SET_NON_MODAL (next_action, NEXT_ACTION_DWELL);
+				case 5: {
+					switch (_point(value)) {
+						case 0: SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CUBIC_SPLINE);
+						case 1: SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_QUADRATIC_SPLINE);
+						default: status = STAT_UNRECOGNIZED_COMMAND;
+					}
+					break;
+				}
+				case 10: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_COORD_DATA);
+				case 17: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_XY);
+				case 18: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_XZ);
+				case 19: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_YZ);
+				case 20: SET_MODAL (MODAL_GROUP_G6, units_mode, INCHES);
+				case 21: SET_MODAL (MODAL_GROUP_G6, units_mode, MILLIMETERS);
+				case 28: {
+					switch (_point(value)) {
+						case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_GOTO_G28_POSITION);
+						case 1: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_G28_POSITION); 
+						case 2: SET_NON_MODAL (next_action, NEXT_ACTION_SEARCH_HOME); 
+						case 3: SET_NON_MODAL (next_action, NEXT_ACTION_SET_ABSOLUTE_ORIGIN);
+						default: status = STAT_UNRECOGNIZED_COMMAND;
 					}
-					case 30: {
-						switch (_point(value)) {
-							case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_GOTO_G30_POSITION);
-							case 1: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_G30_POSITION); 
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
+					break;
+				}
+				case 30: {
+					switch (_point(value)) {
+						case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_GOTO_G30_POSITION);
+						case 1: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_G30_POSITION); 
+						default: status = STAT_UNRECOGNIZED_COMMAND;
 					}
+					break;
+				}
 /*					case 38: 
-						switch (_point(value)) {
-							case 2: SET_NON_MODAL (next_action, NEXT_ACTION_STRAIGHT_PROBE); 
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
+					switch (_point(value)) {
+						case 2: SET_NON_MODAL (next_action, NEXT_ACTION_STRAIGHT_PROBE); 
+						default: status = STAT_UNRECOGNIZED_COMMAND;
 					}
+					break;
+				}
 */					case 40: break;	// ignore cancel cutter radius compensation
-					case 49: break;	// ignore cancel tool length offset comp.
-					case 53: SET_NON_MODAL (absolute_override, true);
-					case 54: SET_MODAL (MODAL_GROUP_G12, coord_system, G54);
-					case 55: SET_MODAL (MODAL_GROUP_G12, coord_system, G55);
-					case 56: SET_MODAL (MODAL_GROUP_G12, coord_system, G56);
-					case 57: SET_MODAL (MODAL_GROUP_G12, coord_system, G57);
-					case 58: SET_MODAL (MODAL_GROUP_G12, coord_system, G58);
-					case 59: SET_MODAL (MODAL_GROUP_G12, coord_system, G59);
-					case 61: {
-						switch (_point(value)) {
-							case 0: SET_MODAL (MODAL_GROUP_G13, path_control, PATH_EXACT_PATH);
-							case 1: SET_MODAL (MODAL_GROUP_G13, path_control, PATH_EXACT_STOP); 
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
-					}
-					case 64: SET_MODAL (MODAL_GROUP_G13,path_control, PATH_CONTINUOUS);
-					case 80: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANCEL_MOTION_MODE);
-					case 90: SET_MODAL (MODAL_GROUP_G3, distance_mode, ABSOLUTE_MODE);
-					case 91: SET_MODAL (MODAL_GROUP_G3, distance_mode, INCREMENTAL_MODE);
-					case 92: {
-						switch (_point(value)) {
-							case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_ORIGIN_OFFSETS);
-							case 1: SET_NON_MODAL (next_action, NEXT_ACTION_RESET_ORIGIN_OFFSETS);
-							case 2: SET_NON_MODAL (next_action, NEXT_ACTION_SUSPEND_ORIGIN_OFFSETS);
-							case 3: SET_NON_MODAL (next_action, NEXT_ACTION_RESUME_ORIGIN_OFFSETS); 
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
+				case 49: break;	// ignore cancel tool length offset comp.
+				case 53: SET_NON_MODAL (absolute_override, true);
+				case 54: SET_MODAL (MODAL_GROUP_G12, coord_system, G54);
+				case 55: SET_MODAL (MODAL_GROUP_G12, coord_system, G55);
+				case 56: SET_MODAL (MODAL_GROUP_G12, coord_system, G56);
+				case 57: SET_MODAL (MODAL_GROUP_G12, coord_system, G57);
+				case 58: SET_MODAL (MODAL_GROUP_G12, coord_system, G58);
+				case 59: SET_MODAL (MODAL_GROUP_G12, coord_system, G59);
+				case 61: {
+					switch (_point(value)) {
+						case 0: SET_MODAL (MODAL_GROUP_G13, path_control, PATH_EXACT_PATH);
+						case 1: SET_MODAL (MODAL_GROUP_G13, path_control, PATH_EXACT_STOP); 
+						default: status = STAT_UNRECOGNIZED_COMMAND;
 					}
-					case 93: SET_MODAL (MODAL_GROUP_G5, inverse_feed_rate_mode, true);
-					case 94: SET_MODAL (MODAL_GROUP_G5, inverse_feed_rate_mode, false);
-					default: status = STAT_UNRECOGNIZED_COMMAND;
+					break;
 				}
-				break;
-
-			case 'M':
-				switch((uint8_t)value) {
-					case 0: case 1: case 60:
-							SET_MODAL (MODAL_GROUP_M4, program_flow, PROGRAM_STOP);
-					case 2: case 30:
-							SET_MODAL (MODAL_GROUP_M4, program_flow, PROGRAM_END);
-					case 3: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_CW);
-					case 4: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_CCW);
-					case 5: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_OFF);
-					case 6: SET_NON_MODAL (change_tool, true);
-					case 7: SET_MODAL (MODAL_GROUP_M8, mist_coolant, true);
-					case 8: SET_MODAL (MODAL_GROUP_M8, flood_coolant, true);
-					case 9: SET_MODAL (MODAL_GROUP_M8, flood_coolant, false);
-					case 48: SET_MODAL (MODAL_GROUP_M9, override_enables, true);
-					case 49: SET_MODAL (MODAL_GROUP_M9, override_enables, false);
-					case 50: SET_MODAL (MODAL_GROUP_M9, feed_rate_override_enable, true); // conditionally true
-					case 51: SET_MODAL (MODAL_GROUP_M9, spindle_override_enable, true);	  // conditionally true
-					default: status = STAT_UNRECOGNIZED_COMMAND;
+				case 64: SET_MODAL (MODAL_GROUP_G13,path_control, PATH_CONTINUOUS);
+				case 80: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANCEL_MOTION_MODE);
+				case 90: SET_MODAL (MODAL_GROUP_G3, distance_mode, ABSOLUTE_MODE);
+				case 91: SET_MODAL (MODAL_GROUP_G3, distance_mode, INCREMENTAL_MODE);
+				case 92: {
+					switch (_point(value)) {
+						case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_ORIGIN_OFFSETS);
+						case 1: SET_NON_MODAL (next_action, NEXT_ACTION_RESET_ORIGIN_OFFSETS);
+						case 2: SET_NON_MODAL (next_action, NEXT_ACTION_SUSPEND_ORIGIN_OFFSETS);
+						case 3: SET_NON_MODAL (next_action, NEXT_ACTION_RESUME_ORIGIN_OFFSETS); 
+						default: status = STAT_UNRECOGNIZED_COMMAND;
+					}
+					break;
 				}
-				break;
-
-			case 'T': SET_NON_MODAL (tool, (uint8_t)trunc(value));
-			case 'F': SET_NON_MODAL (feed_rate, value);
-			case 'P': SET_NON_MODAL (parameter, value);				// used for dwell time, G10 coord select
-			case 'S': SET_NON_MODAL (spindle_speed, value); 
-			case 'X': SET_NON_MODAL (target[AXIS_X], value);
-			case 'Y': SET_NON_MODAL (target[AXIS_Y], value);
-			case 'Z': SET_NON_MODAL (target[AXIS_Z], value);
-			case 'A': SET_NON_MODAL (target[AXIS_A], value);
-			case 'B': SET_NON_MODAL (target[AXIS_B], value);
-			case 'C': SET_NON_MODAL (target[AXIS_C], value);
-		//	case 'U': SET_NON_MODAL (target[AXIS_U], value);		// reserved
-		//	case 'V': SET_NON_MODAL (target[AXIS_V], value);		// reserved
-		//	case 'W': SET_NON_MODAL (target[AXIS_W], value);		// reserved
-			case 'I': SET_NON_MODAL (arc_offset[0], value);
-			case 'J': SET_NON_MODAL (arc_offset[1], value);
-			case 'K': SET_NON_MODAL (arc_offset[2], value);
-			case 'R': SET_NON_MODAL (arc_radius, value);
-			case 'N': SET_NON_MODAL (linenum,(uint32_t)value);		// line number
-			case 'L': break;										// not used for anything
-			default: status = STAT_UNRECOGNIZED_COMMAND;
-		}
-		if(status != STAT_OK) break;
+				case 93: SET_MODAL (MODAL_GROUP_G5, inverse_feed_rate_mode, true);
+				case 94: SET_MODAL (MODAL_GROUP_G5, inverse_feed_rate_mode, false);
+				default: status = STAT_UNRECOGNIZED_COMMAND;
+			}
+			break;
+
+		case 'M':
+			switch((uint8_t)value) {
+				case 0: case 1: case 60:
+						SET_MODAL (MODAL_GROUP_M4, program_flow, PROGRAM_STOP);
+				case 2: case 30:
+						SET_MODAL (MODAL_GROUP_M4, program_flow, PROGRAM_END);
+				case 3: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_CW);
+				case 4: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_CCW);
+				case 5: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_OFF);
+				case 6: SET_NON_MODAL (change_tool, true);
+				case 7: SET_MODAL (MODAL_GROUP_M8, mist_coolant, true);
+				case 8: SET_MODAL (MODAL_GROUP_M8, flood_coolant, true);
+				case 9: SET_MODAL (MODAL_GROUP_M8, flood_coolant, false);
+				case 48: SET_MODAL (MODAL_GROUP_M9, override_enables, true);
+				case 49: SET_MODAL (MODAL_GROUP_M9, override_enables, false);
+				case 50: SET_MODAL (MODAL_GROUP_M9, feed_rate_override_enable, true); // conditionally true
+				case 51: SET_MODAL (MODAL_GROUP_M9, spindle_override_enable, true);	  // conditionally true
+				default: status = STAT_UNRECOGNIZED_COMMAND;
+			}
+			break;
+
+		case 'T': SET_NON_MODAL (tool, (uint8_t)trunc(value));
+		case 'F': SET_NON_MODAL (feed_rate, value);
+		case 'P': SET_NON_MODAL (parameter, value);				// used for dwell time, G10 coord select
+		case 'S': SET_NON_MODAL (spindle_speed, value); 
+		case 'X': SET_NON_MODAL (target[AXIS_X], value);
+		case 'Y': SET_NON_MODAL (target[AXIS_Y], value);
+		case 'Z': SET_NON_MODAL (target[AXIS_Z], value);
+		case 'A': SET_NON_MODAL (target[AXIS_A], value);
+		case 'B': SET_NON_MODAL (target[AXIS_B], value);
+		case 'C': SET_NON_MODAL (target[AXIS_C], value);
+	//	case 'U': SET_NON_MODAL (target[AXIS_U], value);		// reserved
+	//	case 'V': SET_NON_MODAL (target[AXIS_V], value);		// reserved
+	//	case 'W': SET_NON_MODAL (target[AXIS_W], value);		// reserved
+		case 'I': SET_NON_MODAL (arc_offset[0], value);
+		case 'J': SET_NON_MODAL (arc_offset[1], value);
+		case 'K': SET_NON_MODAL (arc_offset[2], value);
+		case 'R': SET_NON_MODAL (arc_radius, value);
+		case 'Q': SET_NON_MODAL (q_word, value);
+		case 'N': SET_NON_MODAL (linenum,(uint32_t)value);		// line number
+		case 'L': break;										// not used for anything
+		default: status = STAT_UNRECOGNIZED_COMMAND;
 	}
-	if ((status != STAT_OK) && (status != STAT_COMPLETE)) return (status);
-	ritorno(_validate_gcode_block());
-	return (_execute_gcode_block());		// if successful execute the block
+	return (status);
 }
 
 /*
@@ -377,7 +531,7 @@ static stat_t _parse_gcode_block(char_t *buf)
  *  (below, with modifications):
  *
  *	    0. record the line number
- *		1. comment (includes message) [handled during block normalization]
+ *		1. comment (includes message) [handled while reading the block]
  *		2. set feed rate mode (G93, G94 - inverse time or per minute)
  *		3. set feed rate (F)
  *		3a. set feed override rate (M50.1)
@@ -438,6 +592,9 @@ static stat_t _execute_gcode_block()
 	//--> cutter length compensation goes here
 	EXEC_FUNC(cm_set_coord_system, coord_system);
 	EXEC_FUNC(cm_set_path_control, path_control);
+	if (((uint8_t)gf.path_control != false) && (gn.path_control == PATH_CONTINUOUS)) {
+		status = cm_set_path_tolerance(((uint8_t)gf.parameter != false) ? gn.parameter : 0); // G64 P
+	}
 	EXEC_FUNC(cm_set_distance_mode, distance_mode);
 	//--> set retract mode goes here
 
@@ -466,6 +623,11 @@ static stat_t _execute_gcode_block()
 					// gf.radius sets radius mode if radius was collected in gn
 					{ status = cm_arc_feed(gn.target, gf.target, gn.arc_offset[0], gn.arc_offset[1],
 								gn.arc_offset[2], gn.arc_radius, gn.motion_mode); break;}
+				case MOTION_MODE_CUBIC_SPLINE: case MOTION_MODE_QUADRATIC_SPLINE: {
+					float offset[] = { gn.arc_offset[0], gn.arc_offset[1], gn.parameter, gn.q_word };
+					float offset_flags[] = { gf.arc_offset[0], gf.arc_offset[1], gf.parameter, gf.q_word };
+					status = cm_spline_feed(gn.target, gf.target, offset, offset_flags, gn.motion_mode); break;
+				}
 			}
 		}
 	}
@@ -479,3 +641,206 @@ static stat_t _execute_gcode_block()
 	return (status);
 }
 
+
+//###########################################################################
+//##### UNIT TESTS ##########################################################
+//###########################################################################
+
+#if defined (__UNIT_TESTS) && defined (__UNIT_TEST_GCODE)
+
+/*
+ * gc_unit_tests() - gcode parser unit tests
+ *
+ *	_test_get_number() compares _get_number() with strtod() over numbers written
+ *	with 0 to TEST_GN_DECIMALS decimals. All of them must come out the same. 
+ *	Numbers of more than TEST_GN_SHORT significant digits are counted apart, as
+ *	they are the ones read by strtod(). The host build also times both. 
+ *	_test_long_numbers() does the same for numbers that are hard to round: 
+ *	halfway cases between two floats, with and without a digit that breaks 
+ *	the tie far down, and numbers too long or too small to scale exactly. _test_get_words() prints the words
+ *	read from some blocks. _test_binary_words() writes words in base85 and reads
+ *	them back with _get_binary_word(), checks _get_binary_crc() against the
+ *	CRC-16/MCRF4XX check value (0x6F91 for "123456789", 0xF795 for "12345678"),
+ *	and checks that gc_binary_parser() rejects NaN and infinite values.
+ */
+#ifdef __SIMULATION
+#include <time.h>
+#endif
+
+#define TEST_GN_START 0.0001
+#define TEST_GN_END 100000
+#define TEST_GN_STEP 1.001			// about 20700 points per number of decimals
+#define TEST_GN_DECIMALS 10
+#define TEST_GN_SHORT 7				// significant digits that must match strtod()
+#define TEST_GN_REPEAT 100			// timing loop count (host only)
+
+static void _test_get_number(void);
+static void _test_long_numbers(void);
+static void _test_get_words(void);
+static void _test_binary_words(void);
+
+void gc_unit_tests()
+{
+	_test_get_number();
+	_test_long_numbers();
+	_test_get_words();
+	_test_binary_words();
+}
+
+static uint8_t _test_significant_digits(const char *str)
+{
+	uint8_t digits = 0;
+	for (; *str != NUL; str++) {
+		if ((isdigit(*str)) && ((digits > 0) || (*str != '0'))) { digits++;}
+	}
+	return (digits);
+}
+
+static void _test_get_number()
+{
+	char buf[32];
+	char *rd;
+	float value;
+	uint32_t count = 0, short_count = 0, short_differ = 0, long_differ = 0, failed = 0;
+#ifdef __SIMULATION
+	volatile float sink = 0;		// keeps the loops from being optimized away
+	clock_t fast_time = 0, strtod_time = 0, start;
+#endif
+
+	for (uint8_t decimals=0; decimals <= TEST_GN_DECIMALS; decimals++) {
+		for (float x = TEST_GN_START; x < TEST_GN_END; x *= TEST_GN_STEP) {
+			sprintf(buf, "%0.*f", decimals, (double)((count & 1) ? -x : x));
+			rd = buf;
+			if ((_get_number(&rd, &value) != STAT_OK) || (*rd != NUL)) { failed++; continue;}
+			float ref = strtod(buf, NULL);
+			count++;
+			if (_test_significant_digits(buf) <= TEST_GN_SHORT) {
+				short_count++;
+				if (value != ref) { short_differ++;}
+			} else if (value != ref) {
+				long_differ++;
+			}
+#ifdef __SIMULATION
+			start = clock();
+			for (uint16_t r=0; r<TEST_GN_REPEAT; r++) { rd = buf; _get_number(&rd, &value); sink += value;}
+			fast_time += clock() - start;
+			start = clock();
+			for (uint16_t r=0; r<TEST_GN_REPEAT; r++) { sink += strtod(buf, NULL);}
+			strtod_time += clock() - start;
+#endif
+		}
+	}
+	fprintf_P(stderr, PSTR("gcode numbers %lu read (%lu failed), %lu of %lu up to %d digits and %lu of %lu longer differ from strtod()"),
+			  (unsigned long)count, (unsigned long)failed, (unsigned long)short_differ, (unsigned long)short_count, TEST_GN_SHORT,
+			  (unsigned long)long_differ, (unsigned long)(count - short_count));
+#ifdef __SIMULATION
+	double calls = (double)count * TEST_GN_REPEAT;
+	fprintf_P(stderr, PSTR(", %0.1f ns vs %0.1f ns strtod() (host)"),
+			  (double)fast_time / CLOCKS_PER_SEC / calls * 1e9, (double)strtod_time / CLOCKS_PER_SEC / calls * 1e9);
+#endif
+	fprintf_P(stderr, PSTR("\n"));
+}
+
+static void _test_long_numbers()
+{
+	const char *numbers[] = {
+		"16777217",							// 2^24+1, halfway: ties to even
+		"16777217.0000000000001",				// just past halfway: rounds up
+		"1.000000059604644775390625",			// 1 + 2^-24, halfway: ties to even
+		"1.0000000596046447753906250000001",	// just past halfway
+		"-123.4567890123",
+		"99999999.5",
+		"0.00000000001",						// scale past 10^10 with a short mantissa
+		"0.000000000000000000000000000000000000011754943",	// about FLT_MIN
+		"340282346638528859811704183484516925440",	// FLT_MAX
+		"12345678901234567890123456789.0123456789"
+	};
+	char buf[64];
+	char *rd;
+	float value;
+	uint8_t differ = 0, count = sizeof(numbers)/sizeof(numbers[0]);
+
+	for (uint8_t i=0; i < count; i++) {
+		strcpy(buf, numbers[i]);
+		rd = buf;
+		if ((_get_number(&rd, &value) != STAT_OK) || (*rd != NUL) || (value != (float)strtod(numbers[i], NULL))) {
+			fprintf_P(stderr, PSTR("gcode long number %s read as %0.9e\n"), numbers[i], (double)value);
+			differ++;
+		}
+	}
+	fprintf_P(stderr, PSTR("gcode long numbers %d of %d differ from strtod()\n"), differ, count);
+}
+
+static void _test_get_words()
+{
+	const char *blocks[] = {
+		"  g1 x100 Y100 f400",			// G1 X100 Y100 F400
+		"G01 X007.50 Y-.5",				// G1 X7.5 Y-0.5 (no Octal)
+		"G0X10",						// G0 X10 (not hexadecimal)
+		"n20 g1 x 10 y+2.5 ;comment",	// N20 G1 X10 Y2.5
+		"G1 X10 (msg hello)",			// G1 X10, message "hello"
+		"G1 X10 5",						// STAT_EXPECTED_COMMAND_LETTER
+		"G1 X-",						// STAT_BAD_NUMBER_FORMAT
+		"G1 X1e3"						// G1 X1 E3 (no exponents)
+	};
+	char buf[40];
+	char *rd;
+	char letter;
+	float value;
+	stat_t status;
+
+	for (uint8_t i=0; i < sizeof(blocks)/sizeof(blocks[0]); i++) {
+		strcpy(buf, blocks[i]);
+		rd = buf;
+		memset(&gp, 0, sizeof(gp));
+		fprintf_P(stderr, PSTR("gcode words \"%s\":"), blocks[i]);
+		while ((status = _get_next_gcode_word(&rd, &letter, &value)) == STAT_OK) {
+			fprintf_P(stderr, PSTR(" %c%g"), letter, (double)value);
+		}
+		fprintf_P(stderr, PSTR(" (status %d)"), status);
+		if (gp.msg != NULL) { fprintf_P(stderr, PSTR(" msg \"%s\""), gp.msg);}
+		fprintf_P(stderr, PSTR("\n"));
+	}
+}
+
+static void _test_put_binary_word(char *buf, uint32_t word, uint8_t digits)
+{
+	for (int8_t d=digits-1; d >= 0; d--) {	// most significant digit first
+		uint8_t digit = word % GC_BINARY_DIGITS;
+		buf[d] = GC_BINARY_DIGIT_MIN + digit + ((GC_BINARY_DIGIT_MIN + digit >= GC_BINARY_DIGIT_SKIP) ? 1 : 0);
+		word /= GC_BINARY_DIGITS;
+	}
+	buf[digits] = NUL;
+}
+
+static void _test_binary_words()
+{
+	uint32_t words[] = { 0, 1, 84, 85, 0x3F800000, 0xC2C80000, 0x12345678, UINT32_MAX };
+	uint32_t check[] = { 0x31323334, 0x35363738 };	// "12345678"
+	uint32_t not_finite[] = { 0x7FC00000, 0x7F800000, 0xFF800000 };	// NaN, Inf, -Inf
+	char buf[2*GC_BINARY_WORD_LEN + GC_BINARY_CRC_LEN + 1];
+	char *rd;
+	uint32_t word;
+	uint8_t failed = 0;
+
+	for (uint8_t i=0; i < sizeof(words)/sizeof(words[0]); i++) {
+		_test_put_binary_word(buf, words[i], GC_BINARY_WORD_LEN);
+		rd = buf;
+		if ((_get_binary_word(&rd, GC_BINARY_WORD_LEN, &word) != STAT_OK) || (word != words[i])) { failed++;}
+	}
+	const char *bad[] = { "xxxxx", "#%###", "#### ", "\"####" };	// overflow, invalid digits
+	for (uint8_t i=0; i < sizeof(bad)/sizeof(bad[0]); i++) {
+		rd = (char *)bad[i];
+		if (_get_binary_word(&rd, GC_BINARY_WORD_LEN, &word) != STAT_BINARY_BLOCK_ERROR) { failed++;}
+	}
+	for (uint8_t i=0; i < sizeof(not_finite)/sizeof(not_finite[0]); i++) {	// G1 X<value>, good CRC
+		uint32_t block[] = { ((uint32_t)GC_OPCODE_G1 << 16) | 1, not_finite[i] };
+		_test_put_binary_word(buf, block[0], GC_BINARY_WORD_LEN);
+		_test_put_binary_word(buf + GC_BINARY_WORD_LEN, block[1], GC_BINARY_WORD_LEN);
+		_test_put_binary_word(buf + 2*GC_BINARY_WORD_LEN, _get_binary_crc(block, 2), GC_BINARY_CRC_LEN);
+		if (gc_binary_parser(buf) != STAT_BINARY_BLOCK_ERROR) { failed++;}
+	}
+	fprintf_P(stderr, PSTR("gcode binary words %d failed, crc 0x%04X (0xF795)\n"), failed, _get_binary_crc(check, 2));
+}
+
+#endif // __UNIT_TEST_GCODE
@@ -21,10 +21,74 @@
 #define gcode_h
 #include "tinyg.h"
 
+/*
+ * Binary gcode blocks
+ *
+ *	A pre-tokenized block is sent as one line: an STX, then the block in base85.
+ *	The serial RX path only passes 7 bit characters and traps CR, LF and the signal
+ *	characters (^x ! ~ % XON XOFF), so the block can't be sent as raw bytes. Base85
+ *	carries 4 bytes in 5 characters and its digits ('#' to 'x', skipping '%') stay
+ *	clear of all of them.
+ *
+ *	The block is a sequence of 32 bit words, each sent as 5 digits, most significant first:
+ *	  - header: sequence number (bits 31-24), opcode (23-16), word mask (15-0)
+ *	  - one float32 for each bit set in the word mask, lowest bit first
+ *	  - then the CRC-16 of the words as 3 digits (avr-libc _crc_ccitt_update(), 0xFFFF
+ *		start, bytes most significant first)
+ *
+ *	The opcode is the motion command of the block, or none if the motion mode carries
+ *	over. Bit n of the word mask is the word GC_BINARY_WORDS[n]. Blocks with any other
+ *	words are sent as text - a stream can mix both. sim/encode.c is the host encoder.
+ *	It sends each block in whichever form is shorter.
+ *
+ *	Sequence numbers run from 1 to 255 and wrap to 1. 0 starts a stream and is always
+ *	accepted. A block out of sequence (STAT_BINARY_SEQUENCE_ERROR) or damaged in
+ *	transit (STAT_BINARY_BLOCK_ERROR) is not run and leaves the sequence number
+ *	expected as it was, so the host can resend from there.
+ */
+#define GC_BINARY_WORDS "XYZABCIJKRFPQSN"	// word for each bit of the word mask
+#define GC_BINARY_MAX_VALUES 15				// words in GC_BINARY_WORDS
+#define GC_BINARY_DIGITS 85					// base
+#define GC_BINARY_DIGIT_MIN '#'				// digit 0
+#define GC_BINARY_DIGIT_MAX 'x'				// digit 84
+#define GC_BINARY_DIGIT_SKIP '%'			// not a digit (queue flush signal)
+#define GC_BINARY_WORD_LEN 5				// digits per 32 bit word
+#define GC_BINARY_CRC_LEN 3					// digits of the CRC
+#define GC_BINARY_SEQUENCE_MAX 255
+
+enum gcBinaryOpcode {
+	GC_OPCODE_NONE = 0,						// no motion command (motion mode carries over)
+	GC_OPCODE_G0,							// G0 - G3
+	GC_OPCODE_G1,
+	GC_OPCODE_G2,
+	GC_OPCODE_G3,
+	GC_OPCODE_COUNT
+};
+
 /*
  * Global Scope Functions
  */
 
 stat_t gc_gcode_parser(char_t *block);
+stat_t gc_binary_parser(char_t *block);
+
+// host simulation hooks for the parser benchmark (see sim/sim.h). Compile out on the target
+#ifdef __SIMULATION
+#define _sim_parse_begin() sim_parse_begin()
+#define _sim_parse_end() sim_parse_end()
+#else
+#define _sim_parse_begin()
+#define _sim_parse_end()
+#endif
+
+/* unit test setup */
+
+//#define __UNIT_TEST_GCODE				// uncomment to enable gcode parser unit tests
+#ifdef __UNIT_TEST_GCODE
+void gc_unit_tests(void);
+#define	GCODE_UNITS gc_unit_tests();
+#else
+#define	GCODE_UNITS
+#endif // __UNIT_TEST_GCODE
 
 #endif
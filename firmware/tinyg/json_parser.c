@@ -117,6 +117,7 @@ stat_t _json_parser_kernal(char *str)
 		// propagate the group from previous NV pair (if relevant)
 		if (group[0] != NUL) {
 			strncpy(cmd->group, group, CMD_GROUP_LEN);// copy the parent's group to this child
+			cmd->group[CMD_GROUP_LEN] = NUL;
 		}
 		// validate the token and get the index
 		if ((cmd->index = cmd_get_index(cmd->group, cmd->token)) == NO_MATCH) { 
@@ -124,6 +125,7 @@ stat_t _json_parser_kernal(char *str)
 		}
 		if ((cmd_index_is_group(cmd->index)) && (cmd_group_is_prefixed(cmd->token))) {
 			strncpy(group, cmd->token, CMD_GROUP_LEN);// record the group ID
+			group[CMD_GROUP_LEN] = NUL;
 		}
 		if ((cmd = cmd->nx) == NULL) return (STAT_JSON_TOO_MANY_PAIRS);// Not supposed to encounter a NULL
 	} while (status != STAT_OK);					// breaks when parsing is complete
@@ -28,18 +28,66 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 #include "tinyg.h"
 #include "config.h"
 #include "gcode_parser.h"
 #include "canonical_machine.h"
 #include "kinematics.h"
+#include "util.h"
 
-//static void _inverse_kinematics(float travel[], float joint[], float microseconds);
+#define DELTA_TOWERS 3
+
+static struct ikMotorMap {			// motors to joints, compiled from the settings by ik_map_motors()
+	uint8_t count;					// motors mapped to a joint
+	uint8_t motor[MOTORS];			// motor number...
+	uint8_t joint[MOTORS];			// ...the joint it is mapped to...
+	float scale[MOTORS];			// ...and its steps per unit (0 if a cartesian axis is inhibited)
+} km;
+
+static struct ikDelta {				// linear delta constants and state (see kinematics.h)
+	float tower_x[DELTA_TOWERS];	// tower positions in the XY plane (from $kr)
+	float tower_y[DELTA_TOWERS];
+	float rod_squared;				// diagonal rod length squared (from $kl)
+	float position[DELTA_TOWERS];	// XYZ of the last ik_kinematics() target...
+	float height[DELTA_TOWERS];		// ...and its carriage heights
+} dk;
+
+static struct ikMesh {				// Z mesh constants and state (see kinematics.h)
+	float inverse_spacing[2];		// 1/$zmi and 1/$zmj
+	float curvature;				// most Z curvature along a line within a cell (1/mm)
+	float kink;						// most change of Z slope across a cell edge
+	uint8_t column;					// cell of the last lookup...
+	uint8_t row;
+	float a, b, c, d;				// ...and its offset a + b*u + c*v + d*u*v (u, v in cells)
+	float position[2];				// XY of the last ik_kinematics() target...
+	float offset;					// ...and its Z offset
+} zk;
+
+static struct ikCompensation {		// pitch error and backlash state (see kinematics.h)
+	uint8_t count;					// joints compensated...
+	uint8_t joint[AXES];			// ...and which ones
+	float inverse_spacing[AXES];	// 1/$xps...
+	float pitch[AXES];				// pitch correction in the step counters
+	float backlash[AXES];			// backlash take-up in the step counters...
+	float backlash_due[AXES];		// ...and still to run
+	int8_t direction[AXES];			// direction of the last joint travel (0 = not known yet)
+} pk;
+
+static void _joint_position(const float position[], float joint[]);
+static void _joint_steps(const float joint[], float steps[]);
+static void _delta_heights(const float position[], float height[]);
+static void _delta_forward(const float height[], float position[]);
+static float _mesh_offset(const float position[]);
+static void _position_joints(const float position[], float joint[]);
+static void _compensate(float joint[], const float joint_target[], const float microseconds);
+static float _pitch(const uint8_t joint, const float position);
 
 /*
  * ik_kinematics() - wrapper routine for inverse kinematics
  *
+ *	Returns the steps to move from position[] to target[] (both absolute).
  *	Calls kinematics function(s). 
  *	Performs axis mapping & conversion of length units to steps (see note)
  *	Also deals with inhibited axes
@@ -50,51 +98,602 @@
  *		  the smoothest possible operation. Steps are passed to the move prep
  *		  routine as floats and converted to fixed-point binary during queue 
  *		  loading. See stepper.c for details.
+ *
+ *	This is run during the _exec() portion of the cycle and will therefore be 
+ *	run once per interpolation segment. The total time for the segment load, 
+ *	including the kinematics, cannot exceed the segment time, and ideally 
+ *	should be no more than 25-50% of the segment time. To profile this time 
+ *	look at the time it takes to complete the mp_exec_move() function.
+ *
+ *	The linear kinematics transform the travel. A delta needs the carriage 
+ *	heights at both ends. Segments run end to end, so the heights of the last 
+ *	target are kept and the start of the next segment costs nothing. That 
+ *	leaves three square roots per segment (see IK_DELTA_USEC).
+ *
+ *	The Z mesh keeps the offset of the last target the same way, so a segment
+ *	looks up one offset (see IK_MESH_USEC). Pitch error and backlash are added
+ *	to the joint travel last.
  */
 
-void ik_kinematics(float travel[], float steps[], float microseconds)
+void ik_kinematics(const float position[], const float target[], float steps[], float microseconds)
 {
 	uint8_t i;
 	float joint[AXES];
+	float joint_target[AXES];
+	float mesh_position[AXES], mesh_target[AXES];
 
-//	_inverse_kinematics(travel, joint, microseconds);// you can insert inverse kinematics transformations here
-	memcpy(joint, travel, sizeof(float)*AXES);		 //...or just do a memcopy for cartesian machines
+	if (cfg.zmesh_enable == true) {				// move Z onto the surface
+		copy_axis_vector(mesh_position, position);
+		copy_axis_vector(mesh_target, target);
+		if ((position[AXIS_X] == zk.position[0]) && (position[AXIS_Y] == zk.position[1])) {
+			mesh_position[AXIS_Z] += zk.offset;
+		} else {
+			mesh_position[AXIS_Z] += _mesh_offset(position);
+		}
+		zk.offset = _mesh_offset(target);
+		zk.position[0] = target[AXIS_X];
+		zk.position[1] = target[AXIS_Y];
+		mesh_target[AXIS_Z] += zk.offset;
+		position = mesh_position;
+		target = mesh_target;
+	}
+	if ((cfg.kinematics == KINE_CARTESIAN) && (pk.count == 0)) {	// joints are the axes. One subtract and multiply per motor
+		for (i=0; i<km.count; i++) {
+			uint8_t j = km.joint[i];
+			steps[km.motor[i]] = (target[j] - position[j]) * km.scale[i];
+		}
+		return;
+	}
+	if (cfg.kinematics == KINE_DELTA) {
+		float start[DELTA_TOWERS];
+		if ((position[AXIS_X] == dk.position[AXIS_X]) && (position[AXIS_Y] == dk.position[AXIS_Y]) &&
+			(position[AXIS_Z] == dk.position[AXIS_Z])) {
+			for (i=0; i<DELTA_TOWERS; i++) { start[i] = dk.height[i];}
+		} else {
+			_delta_heights(position, start);
+		}
+		_delta_heights(target, dk.height);
+		for (i=0; i<DELTA_TOWERS; i++) {
+			dk.position[i] = target[i];
+			joint[i] = dk.height[i] - start[i];
+		}
+		for (; i<AXES; i++) {
+			joint[i] = (cfg.a[i].axis_mode == AXIS_INHIBITED) ? 0 : target[i] - position[i];
+		}
+		if (pk.count != 0) {
+			copy_axis_vector(joint_target, target);
+			for (i=0; i<DELTA_TOWERS; i++) { joint_target[i] = dk.height[i];}
+		}
+	} else {
+		float axis[AXES];
+		for (i=0; i<AXES; i++) {
+			axis[i] = (cfg.a[i].axis_mode == AXIS_INHIBITED) ? 0 : target[i] - position[i];
+		}
+		ik_joint_vector(axis, joint);
+		if (pk.count != 0) { ik_joint_vector(target, joint_target);}
+	}
+	if (pk.count != 0) { _compensate(joint, joint_target, microseconds);}
+	_joint_steps(joint, steps);
+}
 
-	// Map motors to axes and convert length units to steps
+/*
+ * ik_position_steps() - motor steps at an absolute position
+ *
+ *	Sets the step counters from a machine position, and converts endpoints
+ *	for the simulator's step check. Inhibited axes give no steps. Includes the
+ *	Z mesh offset and the pitch correction, but not the backlash take-up (see
+ *	ik_backlash_steps()).
+ */
+
+void ik_position_steps(const float position[], float steps[])
+{
+	float joint[AXES];
+
+	_position_joints(position, joint);
+	for (uint8_t k=0; k<pk.count; k++) {
+		uint8_t j = pk.joint[k];
+		joint[j] += _pitch(j, joint[j]);
+	}
+	_joint_steps(joint, steps);
+}
+
+static void _position_joints(const float position[], float joint[])
+{
+	float axis[AXES];
+
+	for (uint8_t i=0; i<AXES; i++) {
+		axis[i] = (cfg.a[i].axis_mode == AXIS_INHIBITED) ? 0 : position[i];
+	}
+	if ((cfg.zmesh_enable == true) && (cfg.a[AXIS_Z].axis_mode != AXIS_INHIBITED)) {
+		axis[AXIS_Z] += _mesh_offset(position);
+	}
+	_joint_position(axis, joint);
+}
+
+static void _joint_steps(const float joint[], float steps[])
+{
+	// Map motors to joints and convert length units to steps
 	// Most of the conversion math has already been done in steps_per_unit
 	// which takes axis travel, step angle and microsteps into account.
-	for (i=0; i<AXES; i++) {
-		if (cfg.a[i].axis_mode == AXIS_INHIBITED) { joint[i] = 0;}
-		if (cfg.m[MOTOR_1].motor_map == i) { steps[MOTOR_1] = joint[i] * cfg.m[MOTOR_1].steps_per_unit;}
-		if (cfg.m[MOTOR_2].motor_map == i) { steps[MOTOR_2] = joint[i] * cfg.m[MOTOR_2].steps_per_unit;}
-		if (cfg.m[MOTOR_3].motor_map == i) { steps[MOTOR_3] = joint[i] * cfg.m[MOTOR_3].steps_per_unit;}
-		if (cfg.m[MOTOR_4].motor_map == i) { steps[MOTOR_4] = joint[i] * cfg.m[MOTOR_4].steps_per_unit;}
-	// the above is a loop unrolled version of this:
-	//	for (uint8_t j=0; j<MOTORS; j++) {
-	//		if (cfg.m[j].motor_map == i) { steps[j] = joint[i] * cfg.m[j].steps_per_unit;}
-	//	}
+	for (uint8_t i=0; i<km.count; i++) {
+		steps[km.motor[i]] = joint[km.joint[i]] * km.scale[i];
+	}
+}
+
+static void _joint_position(const float position[], float joint[])
+{
+	if (cfg.kinematics == KINE_DELTA) {
+		copy_axis_vector(joint, position);
+		_delta_heights(position, joint);
+	} else {
+		ik_joint_vector(position, joint);
 	}
 }
 
 /*
- * _inverse_kinematics() - inverse kinematics - example is for a cartesian machine
+ * fk_kinematics() - forward kinematics: motor steps to axis positions
  *
- *	You can glue in inverse kinematics here, but be aware of time budget constrants.
- *	This function is run during the _exec() portion of the cycle and will therefore
- *	be run once per interpolation segment. The total time for the segment load, 
- *	including the inverse kinematics transformation cannot exceed the segment time, 
- *	and ideally should be no more than 25-50% of the segment time. Currently segments 
- *	run avery 5 ms, but this might be lowered. To profile this time look at the 
- *	time it takes to complete the mp_exec_move() function.
+ *	The reverse of ik_kinematics(), used to turn step counts back into a 
+ *	position. Joints with no motor mapped keep the value they have at the
+ *	incoming position[], so on a cartesian machine unmapped axes are left as 
+ *	they were. Inhibited axes are also left alone since their motors do not 
+ *	move. If more than one motor is mapped to a joint the lowest numbered one 
+ *	is used. The Z mesh offset, pitch correction and backlash take-up are 
+ *	taken back out. The pitch correction is a small fraction of the travel, so
+ *	two rounds of subtracting it converge.
  */
+
+void fk_kinematics(const float steps[], float position[])
+{
+	float joint[AXES];
+	float axis[AXES];
+
+	copy_axis_vector(axis, position);
+	if (cfg.zmesh_enable == true) { axis[AXIS_Z] += _mesh_offset(position);}
+	_joint_position(axis, joint);
+	for (uint8_t k=0; k<pk.count; k++) {
+		uint8_t j = pk.joint[k];
+		joint[j] += _pitch(j, joint[j]) + pk.backlash[j];
+	}
+	for (uint8_t i=0; i<AXES; i++) {
+		for (uint8_t j=0; j<MOTORS; j++) {
+			if (cfg.m[j].motor_map == i) {
+				joint[i] = steps[j] / cfg.m[j].steps_per_unit;
+				break;
+			}
+		}
+	}
+	for (uint8_t k=0; k<pk.count; k++) {
+		uint8_t j = pk.joint[k];
+		float nominal = joint[j] - pk.backlash[j];
+		joint[j] = nominal - _pitch(j, nominal);
+		joint[j] = nominal - _pitch(j, joint[j]);
+	}
+	copy_axis_vector(axis, joint);
+	if (cfg.kinematics == KINE_DELTA) {
+		_delta_forward(joint, axis);
+	} else if (cfg.kinematics != KINE_CARTESIAN) {	// CoreXY and H-bot
+		axis[AXIS_X] = (joint[AXIS_X] + joint[AXIS_Y]) / 2;
+		axis[AXIS_Y] = (joint[AXIS_X] - joint[AXIS_Y]) / 2;
+	}
+	if (cfg.zmesh_enable == true) { axis[AXIS_Z] -= _mesh_offset(axis);}
+	for (uint8_t i=0; i<AXES; i++) {
+		if (cfg.a[i].axis_mode != AXIS_INHIBITED) { position[i] = axis[i];}
+	}
+}
+
 /*
-static void _inverse_kinematics(float travel[], float joint[], float microseconds)
+ * ik_joint_vector() - transform an axis vector to joint space (see kinematics.h)
+ *
+ *	For the linear kinematics, so this serves positions, travel and unit 
+ *	vectors alike. A delta returns the vector unchanged (its joint limits are
+ *	not checked by the planner). vector[] and joint[] must not be the same array.
+ */
+
+void ik_joint_vector(const float vector[], float joint[])
+{
+	copy_axis_vector(joint, vector);
+	if (ik_joint_limits()) {					// CoreXY and H-bot
+		joint[AXIS_X] = vector[AXIS_X] + vector[AXIS_Y];
+		joint[AXIS_Y] = vector[AXIS_X] - vector[AXIS_Y];
+	}
+}
+
+/*
+ * ik_planar_gain() - most joint travel per unit of travel in a plane
+ *
+ *	For each joint, the largest travel it makes for a unit of travel in any 
+ *	direction in the axis_1/axis_2 plane. Arcs use this as they change 
+ *	direction along the way. For a cartesian machine it is 1 for the plane 
+ *	axes and 0 for the rest. For CoreXY it is sqrt(2) for joints X and Y in 
+ *	the XY plane.
+ */
+
+void ik_planar_gain(const uint8_t axis_1, const uint8_t axis_2, float gain[])
 {
+	float unit[AXES] = {0};
+	float joint_1[AXES], joint_2[AXES];
+
+	unit[axis_1] = 1;
+	ik_joint_vector(unit, joint_1);
+	unit[axis_1] = 0;
+	unit[axis_2] = 1;
+	ik_joint_vector(unit, joint_2);
 	for (uint8_t i=0; i<AXES; i++) {
-		joint[i] = travel[i];
-	}	
+		gain[i] = hypot(joint_1[i], joint_2[i]);
+	}
+}
+
+/*
+ * ik_map_motors() - compile the motor map into the table used per segment
+ *
+ *	The exec runs ik_kinematics() for every segment, so the motor map ($1ma...),
+ *	steps per unit ($1sa, $1tr, $1mi), axis modes ($xam...) and kinematics 
+ *	($kin) are boiled down here to a list of mapped motors with their joint and
+ *	scale. Called by the setters of all of those. Motors mapped past the last
+ *	axis are left out, and keep whatever steps the caller had for them.
+ *
+ *	An inhibited axis gets a scale of 0 on a cartesian machine. The other 
+ *	kinematics zero inhibited axes before the transform, since a joint can
+ *	mix several axes.
+ */
+
+void ik_map_motors()
+{
+	km.count = 0;
+	for (uint8_t m=0; m<MOTORS; m++) {
+		uint8_t j = cfg.m[m].motor_map;
+		if (j >= AXES) { continue;}
+		km.motor[km.count] = m;
+		km.joint[km.count] = j;
+		if ((cfg.kinematics == KINE_CARTESIAN) && (cfg.a[j].axis_mode == AXIS_INHIBITED)) {
+			km.scale[km.count] = 0;
+		} else {
+			km.scale[km.count] = cfg.m[m].steps_per_unit;
+		}
+		km.count++;
+	}
+}
+
+/*
+ * ik_delta_init() - compute the delta tower constants from $kl and $kr
+ *
+ *	Called by the $kl and $kr setters, so it runs at config time and not per
+ *	segment. Also drops the saved carriage heights.
+ */
+
+void ik_delta_init()
+{
+	const float angle[DELTA_TOWERS] = { 210, 330, 90 };		// X, Y and Z towers (degrees)
+
+	for (uint8_t i=0; i<DELTA_TOWERS; i++) {
+		dk.tower_x[i] = cfg.delta_radius * cos(angle[i] / RADIAN);
+		dk.tower_y[i] = cfg.delta_radius * sin(angle[i] / RADIAN);
+		dk.position[i] = NAN;				// never equal, so the next segment starts fresh
+	}
+	dk.rod_squared = square(cfg.delta_rod_length);
+}
+
+/*
+ * ik_mesh_init() - compute the Z mesh constants from the $zm settings
+ *
+ *	Called by the setters of all of the Z mesh settings. Drops the cell and the
+ *	offset kept by the lookup, and works out the bounds ik_segment_length() 
+ *	uses. Within a cell the offset is a + b*u + c*v + d*u*v, which curves by 
+ *	at most |d| / (zmi * zmj) along a line. Across a cell edge the slope 
+ *	changes by at most the second difference of the points along the edge 
+ *	normal, over the spacing.
+ */
+
+void ik_mesh_init()
+{
+	uint8_t r, c;
+
+	zk.inverse_spacing[0] = 1 / cfg.zmesh_spacing[0];
+	zk.inverse_spacing[1] = 1 / cfg.zmesh_spacing[1];
+	zk.column = ZMESH_POINTS;				// no cell, so the next lookup loads one
+	zk.position[0] = NAN;					// never equal, so the next segment starts fresh
+
+	zk.curvature = 0;
+	zk.kink = 0;
+	for (r=0; r<ZMESH_POINTS; r++) {
+		for (c=0; c<ZMESH_POINTS; c++) {
+			if ((r < ZMESH_POINTS-1) && (c < ZMESH_POINTS-1)) {
+				zk.curvature = max(zk.curvature, fabs(cfg.zmesh[r+1][c+1] - cfg.zmesh[r+1][c] - 
+									cfg.zmesh[r][c+1] + cfg.zmesh[r][c]));
+			}
+			if ((c > 0) && (c < ZMESH_POINTS-1)) {
+				zk.kink = max(zk.kink, fabs(cfg.zmesh[r][c+1] - 2*cfg.zmesh[r][c] + cfg.zmesh[r][c-1]) 
+							  * zk.inverse_spacing[0]);
+			}
+			if ((r > 0) && (r < ZMESH_POINTS-1)) {
+				zk.kink = max(zk.kink, fabs(cfg.zmesh[r+1][c] - 2*cfg.zmesh[r][c] + cfg.zmesh[r-1][c]) 
+							  * zk.inverse_spacing[1]);
+			}
+		}
+	}
+	zk.curvature *= zk.inverse_spacing[0] * zk.inverse_spacing[1];
+}
+
+/*
+ * ik_comp_init()		- compile the pitch error and backlash settings
+ * ik_comp_reset()		- the step counters were set to a position
+ * ik_backlash_steps()	- backlash take-up in the step counters, per motor
+ *
+ *	ik_comp_init() is called by the setters of the pitch tables, backlash and
+ *	axis modes. It lists the joints to compensate, including ones that still 
+ *	have a correction in the step counters from before the settings changed.
+ *	ik_comp_reset() is called when the step counters are set from a position
+ *	(see ik_position_steps()), which takes the pitch correction of the position
+ *	and no take-up. The simulator's step check adds ik_backlash_steps() to the
+ *	endpoint steps.
+ */
+
+void ik_comp_init()
+{
+	pk.count = 0;
+	for (uint8_t j=0; j<=AXIS_Z; j++) {
+		uint8_t compensated = ((cfg.a[j].backlash > 0) || (pk.backlash_due[j] != 0) || (pk.pitch[j] != 0));
+		pk.inverse_spacing[j] = 1 / cfg.a[j].pitch_spacing;
+		for (uint8_t i=0; i<PITCH_POINTS; i++) {
+			if (cfg.a[j].pitch[i] != 0) { compensated = true;}
+		}
+		if ((compensated == true) && (cfg.a[j].axis_mode != AXIS_INHIBITED)) { pk.joint[pk.count++] = j;}
+	}
+}
+
+void ik_comp_reset(const float position[])
+{
+	float joint[AXES];
+
+	_position_joints(position, joint);
+	for (uint8_t k=0; k<pk.count; k++) {
+		uint8_t j = pk.joint[k];
+		pk.pitch[j] = _pitch(j, joint[j]);
+		pk.backlash[j] = 0;
+	}
+}
+
+void ik_backlash_steps(float steps[])
+{
+	float joint[AXES] = {0};
+
+	for (uint8_t k=0; k<pk.count; k++) { joint[pk.joint[k]] = pk.backlash[pk.joint[k]];}
+	_joint_steps(joint, steps);
+}
+
+/*
+ * _compensate() - add pitch correction and backlash take-up to a segment
+ *
+ *	joint[] is the joint travel of the segment and joint_target[] the joint
+ *	position it ends at. The travel gets the change of the pitch correction 
+ *	from the last segment, and the take-up this segment has time for.
+ */
+
+static void _compensate(float joint[], const float joint_target[], const float microseconds)
+{
+	for (uint8_t k=0; k<pk.count; k++) {
+		uint8_t j = pk.joint[k];
+		int8_t direction = (joint[j] > 0) ? 1 : ((joint[j] < 0) ? -1 : 0);
+
+		float pitch = _pitch(j, joint_target[j]);
+		joint[j] += pitch - pk.pitch[j];
+		pk.pitch[j] = pitch;
+
+		if ((direction != 0) && (direction != pk.direction[j])) {
+			if (pk.direction[j] != 0) { pk.backlash_due[j] += direction * cfg.a[j].backlash;}
+			pk.direction[j] = direction;
+		}
+		if (pk.backlash_due[j] != 0) {
+			float most = cfg.a[j].velocity_max * IK_BACKLASH_VELOCITY * microseconds / MICROSECONDS_PER_MINUTE;
+			float take = min(max(pk.backlash_due[j], -most), most);
+			joint[j] += take;
+			pk.backlash[j] += take;
+			pk.backlash_due[j] -= take;
+		}
+	}
+}
+
+/*
+ * _pitch() - pitch correction at a joint position
+ */
+
+static float _pitch(const uint8_t joint, const float position)
+{
+	float u = min(max(position * pk.inverse_spacing[joint], 0), PITCH_POINTS-1);	// in table points
+	uint8_t i = min((uint8_t)u, PITCH_POINTS-2);
+	return (cfg.a[joint].pitch[i] + (u - i) * (cfg.a[joint].pitch[i+1] - cfg.a[joint].pitch[i]));
+}
+
+/*
+ * ik_segment_length() - longest segment that keeps within $ct
+ *
+ *	The shorter of the delta and Z mesh limits, for the kinematics in use 
+ *	(see ik_segment_limit()). Returns INFINITY if neither limits the segments.
+ *
+ *	Delta:
+ *	A carriage height is h = z + sqrt(L^2 - d^2) for a tower d away. Along a 
+ *	straight line its second derivative is at most L^2/q^3 where q = 
+ *	sqrt(L^2 - d^2), and a segment of length s run as a straight carriage 
+ *	move is off by at most s^2/8 times that. So s = sqrt(8 * ct * q^3 / L^2).
+ *	q is smallest for the tower farthest away, and the error grows quickly 
+ *	toward the edge of the reach.
+ *
+ *	point[] is a point on the move and reach how far the move goes from it
+ *	in the XY plane. Pass each end of a line with a reach of 0, or the center
+ *	of an arc with its radius.
+ *
+ *	Z mesh: a segment of length s is off the surface by at most s^2/8 times 
+ *	the curvature within a cell, plus s/4 times the slope change where it 
+ *	crosses a cell edge. s is where the two add up to $ct. It is the same 
+ *	anywhere on the mesh.
+ */
+
+float ik_segment_length(const float point[], const float reach)
+{
+	float length = INFINITY;
+	float ct = cfg.chordal_tolerance;
+
+	if (cfg.kinematics == KINE_DELTA) {
+		float q_squared = dk.rod_squared;
+		for (uint8_t i=0; i<DELTA_TOWERS; i++) {
+			float d = hypot(dk.tower_x[i] - point[AXIS_X], dk.tower_y[i] - point[AXIS_Y]) + reach;
+			q_squared = min(q_squared, dk.rod_squared - square(d));
+		}
+		if (q_squared < EPSILON) { return (ct);}		// out of reach
+		length = sqrt(8 * ct * q_squared * sqrt(q_squared) / dk.rod_squared);
+	}
+	if (cfg.zmesh_enable == true) {				// solve s^2 * curvature/8 + s * kink/4 = ct
+		if (zk.curvature > EPSILON) {
+			length = min(length, (sqrt(square(zk.kink) + 8 * zk.curvature * ct) - zk.kink) / zk.curvature);
+		} else if (zk.kink > EPSILON) {
+			length = min(length, 4 * ct / zk.kink);
+		}
+	}
+	return (length);
+}
+
+/*
+ * ik_check_target() - reject a move target the kinematics can't reach
+ *
+ *	On a delta the effector must be less than a rod length ($kl) from each
+ *	tower in XY. Returns STAT_MAX_TRAVEL_EXCEEDED if it isn't, else STAT_OK.
+ */
+
+stat_t ik_check_target(const float target[])
+{
+	if (cfg.kinematics != KINE_DELTA) { return (STAT_OK);}
+	for (uint8_t i=0; i<DELTA_TOWERS; i++) {
+		if ((square(dk.tower_x[i] - target[AXIS_X]) + square(dk.tower_y[i] - target[AXIS_Y])) >= dk.rod_squared) {
+			return (STAT_MAX_TRAVEL_EXCEEDED);
+		}
+	}
+	return (STAT_OK);
+}
+
+/*
+ * ik_check_arc() - reject an arc that leaves the reach of the kinematics
+ *
+ *	The arc lies within radius of its center in the plane, radius being the
+ *	larger of the start and end radius. In XY it is in reach if, for each 
+ *	tower, the distance to the center plus the radius is less than $kl. In XZ 
+ *	or YZ the XY extent of the arc is a rectangle, which is in reach if its 
+ *	corners are, as the area in reach is convex. Returns STAT_MAX_TRAVEL_EXCEEDED
+ *	if the arc or its target can't be reached, else STAT_OK.
+ */
+
+stat_t ik_check_arc(const float position[], const float target[], const float center[], 
+					const float radius, const uint8_t axis_1, const uint8_t axis_2)
+{
+	if (cfg.kinematics != KINE_DELTA) { return (STAT_OK);}
+	if (((axis_1 == AXIS_X) && (axis_2 == AXIS_Y)) || ((axis_1 == AXIS_Y) && (axis_2 == AXIS_X))) {
+		float center_x = (axis_1 == AXIS_X) ? center[0] : center[1];
+		float center_y = (axis_1 == AXIS_X) ? center[1] : center[0];
+		for (uint8_t i=0; i<DELTA_TOWERS; i++) {
+			if (square(hypot(dk.tower_x[i] - center_x, dk.tower_y[i] - center_y) + radius) >= dk.rod_squared) {
+				return (STAT_MAX_TRAVEL_EXCEEDED);
+			}
+		}
+	} else {
+		float low[2], high[2];				// XY extent of the arc
+		for (uint8_t a=AXIS_X; a<=AXIS_Y; a++) {
+			if (a == axis_1) { low[a] = center[0] - radius; high[a] = center[0] + radius;}
+			else if (a == axis_2) { low[a] = center[1] - radius; high[a] = center[1] + radius;}
+			else { low[a] = min(position[a], target[a]); high[a] = max(position[a], target[a]);}
+		}
+		float corner[AXES];
+		for (uint8_t k=0; k<4; k++) {
+			corner[AXIS_X] = (k & 1) ? high[AXIS_X] : low[AXIS_X];
+			corner[AXIS_Y] = (k & 2) ? high[AXIS_Y] : low[AXIS_Y];
+			if (ik_check_target(corner) != STAT_OK) { return (STAT_MAX_TRAVEL_EXCEEDED);}
+		}
+	}
+	return (ik_check_target(target));
+}
+
+/*
+ * _delta_heights() - carriage heights for the XYZ of a position
+ *
+ *	Positions out of reach of a tower put its carriage at the effector height.
+ *	Lines, arcs and the lines of a spline that leave the reach are rejected 
+ *	when queued (ik_check_target(), ik_check_arc()), so this is only a guard.
+ */
+
+static void _delta_heights(const float position[], float height[])
+{
+	for (uint8_t i=0; i<DELTA_TOWERS; i++) {
+		float dx = dk.tower_x[i] - position[AXIS_X];
+		float dy = dk.tower_y[i] - position[AXIS_Y];
+		float q_squared = dk.rod_squared - dx*dx - dy*dy;
+		height[i] = position[AXIS_Z] + ((q_squared > 0) ? sqrt(q_squared) : 0);
+	}
+}
+
+/*
+ * _delta_forward() - effector XYZ from the carriage heights
+ *
+ *	The effector is where three spheres of radius L around the carriage pivots
+ *	meet. Work in a frame with the X carriage at the origin, the Y carriage on
+ *	the ex axis and the Z carriage in the ex/ey plane, then take the solution
+ *	below the carriages.
+ */
+
+static void _delta_forward(const float height[], float position[])
+{
+	float p1[3] = { dk.tower_x[0], dk.tower_y[0], height[0] };
+	float ex[3] = { dk.tower_x[1] - p1[0], dk.tower_y[1] - p1[1], height[1] - p1[2] };
+	float ey[3] = { dk.tower_x[2] - p1[0], dk.tower_y[2] - p1[1], height[2] - p1[2] };
+	float ez[3];
+	uint8_t k;
+
+	float d = sqrt(square(ex[0]) + square(ex[1]) + square(ex[2]));
+	for (k=0; k<3; k++) { ex[k] /= d;}
+	float i = ex[0]*ey[0] + ex[1]*ey[1] + ex[2]*ey[2];
+	for (k=0; k<3; k++) { ey[k] -= i * ex[k];}
+	float j = sqrt(square(ey[0]) + square(ey[1]) + square(ey[2]));
+	for (k=0; k<3; k++) { ey[k] /= j;}
+	ez[0] = ex[1]*ey[2] - ex[2]*ey[1];
+	ez[1] = ex[2]*ey[0] - ex[0]*ey[2];
+	ez[2] = ex[0]*ey[1] - ex[1]*ey[0];
+
+	float x = d / 2;
+	float y = (i*i + j*j - 2*i*x) / (2*j);
+	float z_squared = dk.rod_squared - x*x - y*y;
+	float z = (z_squared > 0) ? sqrt(z_squared) : 0;
+	if (ez[2] > 0) { z = -z;}				// the effector hangs below the carriages
+	for (k=0; k<3; k++) {
+		position[k] = p1[k] + x*ex[k] + y*ey[k] + z*ez[k];
+	}
+}
+
+/*
+ * _mesh_offset() - Z mesh offset at the XY of a position
+ *
+ *	The cell is found by index from the position, and its coefficients are 
+ *	only loaded when the position is outside the cell of the last lookup.
+ */
+
+static float _mesh_offset(const float position[])
+{
+	float u = (position[AXIS_X] - cfg.zmesh_origin[0]) * zk.inverse_spacing[0];	// in cells from zm00
+	float v = (position[AXIS_Y] - cfg.zmesh_origin[1]) * zk.inverse_spacing[1];
+	u = min(max(u, 0), ZMESH_POINTS-1);		// the edge offsets hold past the grid
+	v = min(max(v, 0), ZMESH_POINTS-1);
+
+	if ((u < zk.column) || (u > zk.column + 1) || (v < zk.row) || (v > zk.row + 1)) {
+		uint8_t c = min((uint8_t)u, ZMESH_POINTS-2);
+		uint8_t r = min((uint8_t)v, ZMESH_POINTS-2);
+		zk.column = c;
+		zk.row = r;
+		zk.a = cfg.zmesh[r][c];
+		zk.b = cfg.zmesh[r][c+1] - zk.a;
+		zk.c = cfg.zmesh[r+1][c] - zk.a;
+		zk.d = cfg.zmesh[r+1][c+1] - cfg.zmesh[r+1][c] - zk.b;
+	}
+	u -= zk.column;
+	v -= zk.row;
+	return (zk.a + zk.b * u + v * (zk.c + zk.d * u));
 }
-*/
 
 //############## UNIT TESTS ################
 
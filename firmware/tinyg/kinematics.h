@@ -34,15 +34,139 @@
 #ifndef kinematics_h
 #define kinematics_h 
 
+/* Kinematics ($kin)
+ *	The kinematics turn axis positions (or travel) into joint positions, and 
+ *	the motor map ($1ma...) assigns motors to joints. Joints are indexed like 
+ *	the axes, so on a cartesian machine a joint is just its axis.
+ *
+ *	  KINE_CARTESIAN  joints are the axes
+ *	  KINE_COREXY	  joint X is the A belt (X+Y), joint Y is the B belt (X-Y)
+ *	  KINE_HBOT		  same joint math as CoreXY. The single belt of an H-bot
+ *					  moves its motors the same way
+ *	  KINE_DELTA	  linear delta. Joints X, Y and Z are the carriage heights
+ *					  on the X, Y and Z towers (see below)
+ *
+ *	On CoreXY and H-bot machines both motors turn for a move in X or in Y, and a
+ *	diagonal move turns one motor at twice the speed of the axes. So the 
+ *	planner checks velocity, jerk and junction limits against the joints as 
+ *	well as the axes. A joint takes its limits from the settings of the axis 
+ *	it is indexed by ($xvm, $xfr, $xjm, $xjd for joint X). Set them to what 
+ *	the motors can do. The axis limits still apply to the cartesian motion.
+ *
+ *	Set the kinematics before homing or zeroing the machine. The step counters
+ *	are in joint space and are not converted when the setting changes.
+ *
+ * Linear delta ($kin=3, $kl, $kr)
+ *	Three towers stand at 210, 330 and 90 degrees around the machine origin
+ *	(X, Y and Z towers), $kr from it. $kr is the horizontal distance from a 
+ *	carriage pivot to the effector pivot with the effector at the origin, so it
+ *	already has the effector and carriage offsets taken out. $kl is the 
+ *	diagonal rod length. A carriage stands sqrt(kl^2 - d^2) above the effector,
+ *	where d is the horizontal distance from its tower to the effector. The 
+ *	tower positions and kl^2 are computed when $kl or $kr is set.
+ *
+ *	The tower heights are not linear in the effector position, so a delta move
+ *	is cut into segments short enough that the straight line motion of the
+ *	carriages over a segment keeps the effector within the chordal tolerance 
+ *	($ct) of the path (see ik_segment_length()). Each segment costs the exec 
+ *	one kinematics call of about IK_DELTA_USEC, which must not take more than 
+ *	IK_SEGMENT_BUDGET of the segment time. IK_DELTA_USEC and IK_MESH_USEC are
+ *	estimates from the float op counts, not measurements. The exec row of a 
+ *	__STEP_TIMING build on the xmega gives the real cost to set them from. 
+ *	Sections that would need shorter segments than that get longer segments 
+ *	instead, and run with a larger deviation. The simulator reports the kinematics cost per segment and how
+ *	often this happened (see sim/sim.h).
+ *
+ *	A target more than $kl from a tower in XY can't be reached. Lines to such
+ *	a target are rejected with STAT_MAX_TRAVEL_EXCEEDED when they are queued 
+ *	(see ik_check_target()). The area in reach is convex, so the whole of a 
+ *	line is in reach if its ends are. Arcs are rejected if any part of them 
+ *	is out of reach (see ik_check_arc()). A spline is checked at its length 
+ *	samples before it starts, and then at each line it queues. A spline that 
+ *	leaves the reach stops at the last line in reach.
+ *
+ *	The planner applies the axis limits to the effector only. The carriages 
+ *	run faster than the effector far out from the towers, so keep the axis 
+ *	limits below what the carriages can do. Axes X, Y and Z must not be
+ *	inhibited on a delta.
+ *
+ * Z mesh compensation ($zme, $zmx, $zmy, $zmi, $zmj, $zm00...$zm44)
+ *	A grid of ZMESH_POINTS by ZMESH_POINTS probed Z offsets, $zmi apart in X 
+ *	and $zmj apart in Y, with point zm00 at machine position ($zmx, $zmy). 
+ *	Point zm<r><c> is in row r (along Y) and column c (along X). With $zme=1 
+ *	the kinematics add the offset under each segment end to Z, interpolated 
+ *	bilinearly within its cell. Past the edge of the grid the offset at the 
+ *	nearest edge is used. Machine positions stay uncompensated, so the DROs 
+ *	and the G-code see a flat bed. Change the mesh with the machine at rest 
+ *	and zero Z afterwards. The step counters are not converted.
+ *
+ *	The lookup runs for every segment. It keeps the offset of the last target,
+ *	which is the start of the next segment, and the coefficients of the cell it
+ *	last looked in. A target in the same cell costs a bounds test and three 
+ *	multiplies, and a new cell is found by index, not by search (IK_MESH_USEC).
+ *	A bilinear cell is curved along its diagonals and the surface kinks at the
+ *	cell edges, so moves are cut into segments that keep the interpolation 
+ *	within $ct of the surface (see ik_segment_length()), but never shorter 
+ *	than NOM_SEGMENT_USEC. The bounds are computed when the mesh is set. 
+ *	The planner does not see the Z motion the compensation adds. It is small 
+ *	for the slopes of a warped bed.
+ *
+ * Pitch error and backlash ($xps, $xp0...$xp7, $xbl, and the same for Y and Z)
+ *	Corrections for the lead screws, applied to the joints of the linear axes
+ *	(on a cartesian machine the axes themselves). $xp0...$xp7 are the 
+ *	corrections at machine positions 0, $xps, 2*$xps... and are interpolated 
+ *	linearly in between. The end values hold past the ends of the table. The
+ *	correction is in the step counters as well, so positions read back from 
+ *	them (fk_kinematics()) are uncorrected. The lookup is by index, and each
+ *	segment adds the change of the correction since the last one.
+ *
+ *	When a joint reverses, $xbl of take-up is added in the new direction. It is
+ *	spread over the following segments at no more than IK_BACKLASH_VELOCITY 
+ *	times the axis velocity maximum ($xvm), so it does not land on the DDA as a
+ *	burst of steps. A joint's first move after power up sets its direction 
+ *	without take-up. Setting the machine position keeps the direction and any
+ *	take-up still to run.
+ */
+enum cfgKinematics {
+	KINE_CARTESIAN = 0,			// motors drive the axes directly
+	KINE_COREXY,				// CoreXY (crossed belts)
+	KINE_HBOT,					// H-bot (single belt)
+	KINE_DELTA					// linear delta (three towers)
+};
+
+#define IK_DELTA_USEC 150		// estimated xmega time for one delta ik_kinematics() call (3 sqrt, ~20 float ops)
+#define IK_MESH_USEC 40			// estimated xmega time added by the Z mesh lookup (~8 float ops in the same cell)
+#define IK_BACKLASH_VELOCITY 0.25	// backlash take-up speed as a fraction of the axis velocity maximum
+#define IK_SEGMENT_BUDGET 0.25	// most of the segment time the kinematics may use
+
+// the planner checks joint limits for the linear kinematics only (see above)
+#define ik_joint_limits() ((cfg.kinematics == KINE_COREXY) || (cfg.kinematics == KINE_HBOT))
+
+// the exec cuts moves into segments short enough for the kinematics (see above)
+#define ik_segment_limit() ((cfg.kinematics == KINE_DELTA) || (cfg.zmesh_enable == true))
+
 /*
  * Global Scope Functions
  */
 
-void ik_kinematics(float travel[], float steps[], float microseconds);
+void ik_kinematics(const float position[], const float target[], float steps[], float microseconds);
+void ik_position_steps(const float position[], float steps[]);
+void fk_kinematics(const float steps[], float position[]);
+void ik_joint_vector(const float vector[], float joint[]);
+void ik_planar_gain(const uint8_t axis_1, const uint8_t axis_2, float gain[]);
+void ik_map_motors(void);
+void ik_delta_init(void);
+void ik_mesh_init(void);
+void ik_comp_init(void);
+void ik_comp_reset(const float position[]);
+void ik_backlash_steps(float steps[]);
+float ik_segment_length(const float point[], const float reach);
+stat_t ik_check_target(const float target[]);
+stat_t ik_check_arc(const float position[], const float target[], const float center[], 
+					const float radius, const uint8_t axis_1, const uint8_t axis_2);
 
 //#ifdef __UNIT_TESTS
 //void ik_unit_tests(void);
 //#endif
 
 #endif
-
@@ -104,6 +104,7 @@ static void _unit_tests(void)
 //	EEPROM_UNITS;			// if you want this you must include the .h file in this file
 	CONFIG_UNITS;
 	JSON_UNITS;
+	GCODE_UNITS;
 	GPIO_UNITS;
 	REPORT_UNITS;
 	PLANNER_UNITS;
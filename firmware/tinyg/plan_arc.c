@@ -49,118 +49,28 @@ static float _get_arc_time (const float linear_travel, const float angular_trave
 static float _get_theta(const float x, const float y);
 
 /*****************************************************************************
- * mp_arc() - setup an arc move for runtime
+ * ar_arc() - queue an arc move
  *
- *	Generates an arc by queueing line segments to the move buffer.
- *	The arc is approximated by generating a large number of tiny, linear
- *	segments. The length of the segments is configured in motion_control.h
- *	as MM_PER_ARC_SEGMENT.
- *
- *  Parts of this routine were originally sourced from the grbl project.
+ *	The arc is queued as a single planner block. See mp_arc() for how it is
+ *	planned, and _exec_aline_segment() for how the runtime follows the arc.
+ *	Arcs shorter than the minimum arc segment ($ma) are not drawn.
  */
-stat_t ar_arc( const float target[], 
-				const float i, const float j, const float k, 
-				const float theta, 		// starting angle
+stat_t ar_arc( const float target[], 	// arc endpoint in axis order
+				const float theta, 			// starting angle
 				const float radius, 		// radius of the circle in mm
-				const float angular_travel,// radians along arc (+CW, -CCW)
+				const float angular_travel,	// radians along arc (+CW, -CCW)
 				const float linear_travel, 
 				const uint8_t axis_1, 		// circle plane in tool space
 				const uint8_t axis_2,  		// circle plane in tool space
-				const uint8_t axis_linear,	// linear travel if helical motion
 				const float minutes,		// time to complete the move
 				const float work_offset[],	// offset from work coordinate system
 				const float min_time)		// minimum time for arc for replanning purposes
 {
-	if (ar.run_state != MOVE_STATE_OFF) {
-		return (STAT_INTERNAL_ERROR);			// (not supposed to fail)
-	}
-	ar.linenum = cm_get_model_linenum();	// get gcode model line number as debugging convenience
-
-	// "move_length" is the total mm of travel of the helix (or just arc)
-	ar.length = hypot(angular_travel * radius, fabs(linear_travel));	
-	if (ar.length < cfg.arc_segment_len) {	// too short to draw
+	// "length" is the total mm of travel of the helix (or just arc)
+	if (hypot(angular_travel * radius, fabs(linear_travel)) < cfg.arc_segment_len) {	// too short to draw
 		return (STAT_MINIMUM_LENGTH_MOVE_ERROR);
 	}
-
-	// load the move struct for an arc
-	cm_get_model_canonical_position_vector(ar.position);// set initial arc position
-
-//	copy_axis_vector(ar.endpoint, target);
-	ar.endpoint[axis_1] = target[0];					// save the arc endpoint
-	ar.endpoint[axis_2] = target[1];
-	ar.endpoint[axis_linear] = target[2];
-
-	copy_axis_vector(ar.work_offset, work_offset);		// propagate the work offset
-	ar.time = minutes;
-	ar.min_time = min_time;
-	ar.theta = theta;
-	ar.radius = radius;
-	ar.axis_1 = axis_1;
-	ar.axis_2 = axis_2;
-	ar.axis_linear = axis_linear;
-	ar.angular_travel = angular_travel;
-	ar.linear_travel = linear_travel;
-	
-	// Find the minimum number of segments that meets these constraints...
-	float segments_required_for_chordal_accuracy = ar.length / sqrt(4*cfg.chordal_tolerance * (2 * radius - cfg.chordal_tolerance));
-	float segments_required_for_minimum_distance = ar.length / cfg.arc_segment_len;
-	float segments_required_for_minimum_time = ar.time * MICROSECONDS_PER_MINUTE / MIN_ARC_SEGMENT_USEC;
-	ar.segments = floor(min3(segments_required_for_chordal_accuracy,
-							 segments_required_for_minimum_distance,
-							 segments_required_for_minimum_time));
-	ar.segments = max(ar.segments,1);		//...but is at least 1 segment
-
-	ar.segment_count = (uint32_t)ar.segments;
-	ar.segment_theta = ar.angular_travel / ar.segments;
-	ar.segment_linear_travel = ar.linear_travel / ar.segments;
-	ar.segment_time = ar.time / ar.segments;
-	ar.center_1 = ar.position[ar.axis_1] - sin(ar.theta) * ar.radius;
-	ar.center_2 = ar.position[ar.axis_2] - cos(ar.theta) * ar.radius;
-	ar.target[ar.axis_linear] = ar.position[ar.axis_linear];
-	ar.run_state = MOVE_STATE_RUN;
-	return (STAT_OK);
-}
-
-/*
- * ar_arc_callback() - generate an arc
- *
- *	ar_arc_callback() is structured as a continuation called by mp_move_dispatcher.
- *	Each time it's called it queues as many arc segments (lines) as it can 
- *	before it blocks, then returns.
- *
- *  Parts of this routine were originally sourced from the grbl project.
- */
-
-stat_t ar_arc_callback() 
-{
-	if (ar.run_state == MOVE_STATE_OFF) { return (STAT_NOOP);}
-	if (mp_get_planner_buffers_available() == 0) { return (STAT_EAGAIN);}
-	if (ar.run_state == MOVE_STATE_RUN) {
-		if (--ar.segment_count > 0) {
-			ar.theta += ar.segment_theta;
-			ar.target[ar.axis_1] = ar.center_1 + sin(ar.theta) * ar.radius;
-			ar.target[ar.axis_2] = ar.center_2 + cos(ar.theta) * ar.radius;
-			ar.target[ar.axis_linear] += ar.segment_linear_travel;
-			(void)MP_LINE(ar.target, ar.segment_time, ar.work_offset, 0);
-			copy_axis_vector(ar.position, ar.target);	// update runtime position	
-			return (STAT_EAGAIN);
-		} else {
-			(void)MP_LINE(ar.endpoint, ar.segment_time, ar.work_offset,0);// do last segment to the exact endpoint
-		}
-	}
-	ar.run_state = MOVE_STATE_OFF;
-	return (STAT_OK);
-}
-
-/*
- * ar_abort_arc() - stop an arc.
- *
- *	OK to call if no arc is running
- */
-
-void ar_abort_arc() 
-{
-	ar.run_state = MOVE_STATE_OFF;
+	return (mp_arc(target, theta, radius, angular_travel, axis_1, axis_2, minutes, work_offset, min_time));
 }
 
 /*****************************************************************************
@@ -275,16 +185,8 @@ static stat_t _compute_center_arc()
 	float move_time = _get_arc_time(linear_travel, angular_travel, radius_tmp);
 
 	// Trace the arc
-	set_vector(gm.target[gm.plane_axis_0], gm.target[gm.plane_axis_1], gm.target[gm.plane_axis_2],
-			   gm.target[AXIS_A], gm.target[AXIS_B], gm.target[AXIS_C]);
-
-	return(ar_arc(vector,
-				  gm.arc_offset[gm.plane_axis_0],
-				  gm.arc_offset[gm.plane_axis_1],
-				  gm.arc_offset[gm.plane_axis_2],
-				  theta_start, radius_tmp, angular_travel, linear_travel, 
-				  gm.plane_axis_0, gm.plane_axis_1, gm.plane_axis_2, 
-				  move_time, gm.work_offset, gm.min_time));
+	return(ar_arc(gm.target, theta_start, radius_tmp, angular_travel, linear_travel, 
+				  gm.plane_axis_0, gm.plane_axis_1, move_time, gm.work_offset, gm.min_time));
 }
 
 /* 
@@ -434,6 +336,17 @@ static float _get_arc_time (const float linear_travel, 	// in mm
 	if ((tmp = fabs(linear_travel/cfg.a[gm.plane_axis_2].feedrate_max)) > move_time) {
 		move_time = tmp;
 	}
+	if (ik_joint_limits()) {	// same assumption for the joints (see kinematics.h)
+		float gain[AXES], travel[AXES] = {0}, joint[AXES];
+		ik_planar_gain(gm.plane_axis_0, gm.plane_axis_1, gain);
+		travel[gm.plane_axis_2] = linear_travel;
+		ik_joint_vector(travel, joint);
+		for (uint8_t i=0; i<AXES; i++) {
+			if ((tmp = (planar_travel * gain[i] + fabs(joint[i])) / cfg.a[i].feedrate_max) > move_time) {
+				move_time = tmp;
+			}
+		}
+	}
 	return (move_time);
 }
 
@@ -40,14 +40,26 @@
 #include "report.h"
 #include "util.h"
 //#include "xio/xio.h"			// uncomment for debugging
+#ifdef __SIMULATION
+#include "sim/sim.h"
+#endif
 
 // aline planner routines / feedhold planning
+static stat_t _plan_aline(const float target[], const float minutes, const float work_offset[], const float min_time);
+static void _queue_block(mpBuf_t *bf, const float entry_unit[], const uint8_t move_type);
+static mpBuf_t *_get_last_aline(const float work_offset[]);
+static uint8_t _coalesce_aline(const float target[], const float minutes, const float work_offset[], const float min_time);
+static float _blend_corner(const float target[], const float length, const float minutes, const float work_offset[], const float min_time);
+static void _set_jerk_terms(mpBuf_t *bf, const float jerk_squared);
+static float _limit_joint_jerk(const float joint_unit[], float jerk_squared);
 static void _plan_block_list(mpBuf_t *bf, uint8_t *mr_flag);
 static void _calculate_trapezoid(mpBuf_t *bf);
+static float _get_ht_velocity(const mpBuf_t *bf);
 static float _get_target_length(const float Vi, const float Vt, const mpBuf_t *bf);
 static float _get_target_velocity(const float Vi, const float L, const mpBuf_t *bf);
 //static float _get_intersection_distance(const float Vi_squared, const float Vt_squared, const float L, const mpBuf_t *bf);
 static float _get_junction_vmax(const float a_unit[], const float b_unit[]);
+static float _get_joint_junction_vmax(const float a_unit[], const float b_unit[]);
 static void _reset_replannable_list(void);
 
 // execute routines (NB: These are all called from the LO interrupt)
@@ -56,6 +68,7 @@ static stat_t _exec_aline_head(void);
 static stat_t _exec_aline_body(void);
 static stat_t _exec_aline_tail(void);
 static stat_t _exec_aline_segment(uint8_t correction_flag);
+static float _ik_segments(const float segments, const float length, const float move_time);
 static void _init_forward_diffs(float t0, float t2);
 static float _compute_next_segment_velocity(void);
 
@@ -129,18 +142,40 @@ void mp_zero_segment_velocity()
  *	Note: Returning a status that is not STAT_OK means the endpoint is NOT
  *	advanced. So lines that are too short to move will accumulate and get 
  *	executed once the accumlated error exceeds the minimums 
+ *
+ *	Note: Targets the kinematics can't reach return STAT_MAX_TRAVEL_EXCEEDED
+ *	(see ik_check_target()). mp_arc() checks the whole arc (ik_check_arc()).
+ *
+ *	Note: A feed may be merged into the last block ($la, see _coalesce_aline()), 
+ *	or in G64 P mode start with a blend around the corner (see _blend_corner()).
+ *	_plan_aline() queues and plans the block itself.
  */
 
 stat_t mp_aline(const float target[], const float minutes, const float work_offset[], const float min_time)
 {
-	mpBuf_t *bf; 						// current move pointer
-	float exact_stop = 0;
-	float junction_velocity;
-
 	// trap error conditions
 	float length = get_axis_vector_length(target, mm.position);
 	if (length < MIN_LENGTH_MOVE) { return (STAT_MINIMUM_LENGTH_MOVE_ERROR);}
 	if (minutes < MIN_TIME_MOVE) { return (STAT_MINIMUM_TIME_MOVE_ERROR);}
+	stat_t status = ik_check_target(target);
+	if (status != STAT_OK) { return (status);}
+
+	// merge nearly collinear feeds into the last block
+	if (_coalesce_aline(target, minutes, work_offset, min_time) == true) { return (STAT_OK);}
+
+	// round the corner with the last block (G64 P). The move is planned from the end of the blend
+	float scale = (length - _blend_corner(target, length, minutes, work_offset, min_time)) / length;
+	return (_plan_aline(target, (minutes * scale), work_offset, (min_time * scale)));
+}
+
+/*
+ * _plan_aline() - queue and plan a line from the planning position
+ */
+
+static stat_t _plan_aline(const float target[], const float minutes, const float work_offset[], const float min_time)
+{
+	mpBuf_t *bf; 						// current move pointer
+	float length = get_axis_vector_length(target, mm.position);
 
 	// get a cleared buffer and setup move variables
 	if ((bf = mp_get_write_buffer()) == NULL) { return (STAT_BUFFER_FULL_FATAL);} // never supposed to fail
@@ -181,36 +216,415 @@ stat_t mp_aline(const float target[], const float minutes, const float work_offs
 		bf->unit[AXIS_C] = diff / length;
 		jerk_squared += square(bf->unit[AXIS_C] * cfg.a[AXIS_C].jerk_max);
 	}
+	if (ik_joint_limits()) {		// the motors limit jerk too (see kinematics.h)
+		float joint_unit[AXES];
+		ik_joint_vector(bf->unit, joint_unit);
+		jerk_squared = _limit_joint_jerk(joint_unit, jerk_squared);
+	}
+	_set_jerk_terms(bf, jerk_squared);
+
+	bf->cruise_vmax = bf->length / bf->time;	// target velocity requested
+	mm.last_aline = bf;							// later moves may be merged into or blended with this block
+	mm.coalesce_deviation = 0;
+	copy_axis_vector(mm.last_aline_start, mm.position);
+	_queue_block(bf, bf->unit, MOVE_TYPE_ALINE);
+	return (STAT_OK);
+}
+
+/**************************************************************************
+ * mp_arc() - plan an arc or helix as a single block
+ *
+ *	The arc is planned like a line of the same length, and the runtime moves 
+ *	the plane axes around the arc as it generates the segments (see 
+ *	_exec_aline_segment()). So an arc takes one planner buffer, where it used to
+ *	be queued as a line for every arc segment. This could fill the planner with
+ *	a single arc and leave it no look-ahead past it. 
+ *
+ *	The cruise velocity is limited so that:
+ *
+ *	  - centripetal acceleration stays within junction_acceleration, the limit
+ *		_get_junction_vmax() applies to corners: V = sqrt(ja*R) in the plane
+ *	  - a segment run at the cruise velocity deviates from the arc by no more
+ *		than the chordal tolerance ($ct). The segments are no longer than the
+ *		estimated segment time
+ *
+ *	Jerk is the worst case for the plane axes, as the direction of travel in the
+ *	plane changes along the arc. The unit vector is the direction at the end of
+ *	the arc, so the next block sees the right junction. The linear axes move at a 
+ *	constant rate, so their unit vector entries also drive them at runtime. 
+ *
+ *	The arc is given by its starting angle theta (see _compute_center_arc()) and
+ *	radius from the planning position, and angular travel (+CW, -CCW). The
+ *	runtime finishes on the exact target. If the target is not on the circle
+ *	(the I and J offsets do not match the endpoint) the radius changes
+ *	linearly along the arc to meet it, rather than leaving the difference to the
+ *	last segment, which could ask for more steps than the DDA can make.
+ */
+
+stat_t mp_arc(const float target[], const float theta, const float radius, const float angular_travel, 
+			  const uint8_t axis_1, const uint8_t axis_2, const float minutes, const float work_offset[], const float min_time)
+{
+	mpBuf_t *bf;
+	float planar_length = fabs(angular_travel * radius);
+	float length_squared = square(planar_length);
+
+	for (uint8_t i=0; i<AXES; i++) {
+		if ((i != axis_1) && (i != axis_2)) { length_squared += square(target[i] - mm.position[i]);}
+	}
+	float length = sqrt(length_squared);
+	if (length < MIN_LENGTH_MOVE) { return (STAT_MINIMUM_LENGTH_MOVE_ERROR);}
+	if (minutes < MIN_TIME_MOVE) { return (STAT_MINIMUM_TIME_MOVE_ERROR);}
+	float center[2] = { mm.position[axis_1] - sin(theta) * radius, mm.position[axis_2] - cos(theta) * radius };
+	float end_radius = hypot(target[axis_1] - center[0], target[axis_2] - center[1]);
+	stat_t status = ik_check_arc(mm.position, target, center, max(radius, end_radius), axis_1, axis_2);
+	if (status != STAT_OK) { return (status);}
+	if ((bf = mp_get_write_buffer()) == NULL) { return (STAT_BUFFER_FULL_FATAL);} // never supposed to fail
+
+	bf->bf_func = _exec_aline;
+	bf->linenum = cm_get_model_linenum();
+	bf->motion_mode = cm_get_model_motion_mode();
+	bf->time = minutes;
+	bf->min_time = min_time;
+	bf->length = length;
+	copy_axis_vector(bf->target, target);
+	copy_axis_vector(bf->work_offset, work_offset);
+	bf->arc_center[0] = center[0];
+	bf->arc_center[1] = center[1];
+	bf->arc_radius = radius;
+	bf->arc_radius_per_mm = (end_radius - radius) / length;
+	bf->arc_theta_per_mm = angular_travel / length;
+	bf->arc_axis_1 = axis_1;
+	bf->arc_axis_2 = axis_2;
+
+	// unit vector at the start and end of the arc, and jerk
+	float entry_unit[AXES];
+	float planar_unit = bf->arc_theta_per_mm * radius;	// signed planar travel per mm
+	float jerk_squared = square(planar_length / length * min(cfg.a[axis_1].jerk_max, cfg.a[axis_2].jerk_max));
+	for (uint8_t i=0; i<AXES; i++) {
+		if ((i != axis_1) && (i != axis_2)) {
+			bf->unit[i] = (target[i] - mm.position[i]) / length;
+			jerk_squared += square(bf->unit[i] * cfg.a[i].jerk_max);
+		}
+	}
+	if (ik_joint_limits()) {		// joint travel per mm in the worst direction in the plane
+		float gain[AXES], joint_unit[AXES];
+		ik_planar_gain(axis_1, axis_2, gain);
+		ik_joint_vector(bf->unit, joint_unit);	// linear axes only so far
+		for (uint8_t i=0; i<AXES; i++) {
+			joint_unit[i] = fabs(joint_unit[i]) + gain[i] * planar_length / length;
+		}
+		jerk_squared = _limit_joint_jerk(joint_unit, jerk_squared);
+	}
+	copy_axis_vector(entry_unit, bf->unit);
+	entry_unit[axis_1] = planar_unit * cos(theta);
+	entry_unit[axis_2] = -planar_unit * sin(theta);
+	bf->unit[axis_1] = planar_unit * cos(theta + angular_travel);
+	bf->unit[axis_2] = -planar_unit * sin(theta + angular_travel);
+	_set_jerk_terms(bf, jerk_squared);
+
+	// velocity limits
+	bf->cruise_vmax = min(bf->length / bf->time, sqrt(cfg.junction_acceleration * radius) * length / planar_length);
+	if (cfg.chordal_tolerance < radius) {
+		float chord = sqrt(4 * cfg.chordal_tolerance * (2 * radius - cfg.chordal_tolerance));
+		bf->cruise_vmax = min(bf->cruise_vmax, chord * length / planar_length / (cfg.estd_segment_usec / MICROSECONDS_PER_MINUTE));
+	}
+	_queue_block(bf, entry_unit, MOVE_TYPE_ARC);
+	return (STAT_OK);
+}
+
+/*
+ * _queue_block() - finish planning a line or arc block and queue it
+ *
+ *	entry_unit is the direction the block starts in, for the junction velocity
+ */
+
+static void _queue_block(mpBuf_t *bf, const float entry_unit[], const uint8_t move_type)
+{
+	float exact_stop = 0;
+
+	if (cm_get_model_path_control() != PATH_EXACT_STOP) { // exact stop cases already zeroed
+		bf->replannable = true;
+		exact_stop = 12345678;					// an arbitrarily large floating point number
+	}
+	float junction_velocity = _get_junction_vmax(bf->pv->unit, entry_unit);
+	if (ik_joint_limits()) {
+		junction_velocity = min(junction_velocity, _get_joint_junction_vmax(bf->pv->unit, entry_unit));
+	}
+	bf->entry_vmax = min3(bf->cruise_vmax, junction_velocity, exact_stop);
+	bf->delta_vmax = _get_target_velocity(0, bf->length, bf);
+	bf->exit_vmax = min3(bf->cruise_vmax, (bf->entry_vmax + bf->delta_vmax), exact_stop);
+	bf->braking_velocity = bf->delta_vmax;
+
+	uint8_t mr_flag = false;
+	_sim_plan_begin();
+	_plan_block_list(bf, &mr_flag);				// replan block list and commit current block
+	_sim_plan_end();
+	copy_axis_vector(mm.position, bf->target);	// update planning position
+	mp_queue_write_buffer(move_type);
+}
+
+/*
+ * _set_jerk_terms() - set jerk and the compute-once jerk terms from the squared jerk
+ */
+
+static void _set_jerk_terms(mpBuf_t *bf, const float jerk_squared)
+{
 	bf->jerk = sqrt(jerk_squared);
 
 	if (fabs(bf->jerk - mm.prev_jerk) < JERK_MATCH_PRECISION) {	// can we re-use jerk terms?
 		bf->cbrt_jerk = mm.prev_cbrt_jerk;
 		bf->recip_jerk = mm.prev_recip_jerk;
 	} else {
-		bf->cbrt_jerk = cbrt(bf->jerk);
+		bf->cbrt_jerk = fast_cbrt(bf->jerk);
 		bf->recip_jerk = 1/bf->jerk;			
 		mm.prev_jerk = bf->jerk;
 		mm.prev_cbrt_jerk = bf->cbrt_jerk;
 		mm.prev_recip_jerk = bf->recip_jerk;
 	}
+}
 
-	// finish up the current block variables
-	if (cm_get_model_path_control() != PATH_EXACT_STOP) { // exact stop cases already zeroed
-		bf->replannable = true;
-		exact_stop = 12345678;					// an arbitrarily large floating point number
+/*
+ * _limit_joint_jerk() - limit the squared jerk of a block to what its joints can take
+ *
+ *	joint_unit[] is the joint travel per mm of the block (see ik_joint_vector()).
+ *	Each joint jerks in proportion to its travel, so the path jerk is held to 
+ *	jerk_max / joint_unit for every joint that moves. Not needed for cartesian 
+ *	machines, where the axis jerk already is the joint jerk.
+ */
+
+static float _limit_joint_jerk(const float joint_unit[], float jerk_squared)
+{
+	for (uint8_t i=0; i<AXES; i++) {
+		if (fp_NOT_ZERO(joint_unit[i])) {
+			jerk_squared = min(jerk_squared, square(cfg.a[i].jerk_max / joint_unit[i]));
+		}
 	}
-	bf->cruise_vmax = bf->length / bf->time;	// target velocity requested
-	junction_velocity = _get_junction_vmax(bf->pv->unit, bf->unit);
-	bf->entry_vmax = min3(bf->cruise_vmax, junction_velocity, exact_stop);
+	return (jerk_squared);
+}
+
+/*
+ * _get_last_aline() - return the last queued block if a new move may still change it
+ *
+ *	Returns NULL unless:
+ *
+ *	  - the block is the last one queued and has another queued block ahead of
+ *		it, so the runtime can't pick it up while it is being changed
+ *	  - the block and the new move are straight feeds in continuous path mode
+ *		with the same work offsets, and no feedhold is in effect
+ *	  - the move starts where the block ends (no G92 or other position change)
+ */
+
+static mpBuf_t *_get_last_aline(const float work_offset[])
+{
+	mpBuf_t *bf = mm.last_aline;
+
+	if (bf == NULL) { return (NULL);}
+	if ((bf->buffer_state != MP_BUFFER_QUEUED) || (bf->nx != mb.q) || (bf->pv->buffer_state != MP_BUFFER_QUEUED)) {
+		return (NULL);
+	}
+	if ((bf->move_type != MOVE_TYPE_ALINE) || (bf->motion_mode != MOTION_MODE_STRAIGHT_FEED) ||
+		(cm_get_model_motion_mode() != MOTION_MODE_STRAIGHT_FEED) ||
+		(cm_get_model_path_control() != PATH_CONTINUOUS) || (cm_get_hold_state() != FEEDHOLD_OFF)) {
+		return (NULL);
+	}
+	if ((vector_equal(bf->target, mm.position) == false) || (vector_equal(bf->work_offset, work_offset) == false)) {
+		return (NULL);
+	}
+	return (bf);
+}
+
+/*
+ * _coalesce_aline() - merge a feed move into the last queued block if nearly collinear
+ *
+ *	CAM output often describes smooth paths as runs of very short lines. Each one
+ *	takes a planner buffer and a full replan, and a queue full of them only looks
+ *	ahead a few mm. If coalescing is enabled ($la > 0) a G1 move that continues
+ *	the last queued G1 block is merged into that block, which is then replanned
+ *	in place. Returns TRUE if the move was merged. A move is merged if:
+ *
+ *	  - _get_last_aline() returns the block
+ *	  - the move has the same feed rate as the block
+ *	  - the move's direction is within $la degrees of the block's direction
+ *	  - no endpoint merged into the block is further than $lt from the new chord
+ *
+ *	The chord test keeps a running bound. When the chord is extended from T1 to T2
+ *	the earlier endpoints move away from it by no more than T1 does, so the bound
+ *	grows by the distance of T1 from the new chord.
+ *
+ *	The block takes the line number of the last move merged into it, so the line
+ *	is right once the block completes. While it runs the reported line may lead
+ *	the tool by the merged lines, which are all within $lt of the path.
+ *
+ *	The entry velocity limits from the first move are kept. The chord direction
+ *	differs from it by less than $la, and blocks ahead may already be committed to
+ *	exit at that velocity.
+ */
+
+static uint8_t _coalesce_aline(const float target[], const float minutes, const float work_offset[], const float min_time)
+{
+	mpBuf_t *bf;
+
+	if ((fp_ZERO(cfg.coalesce_angle)) || ((bf = _get_last_aline(work_offset)) == NULL)) { return (false);}
+
+	// the move's direction and feed rate
+	float move_length = get_axis_vector_length(target, mm.position);
+	if (fabs(move_length / minutes - bf->cruise_vmax) > (bf->cruise_vmax * COALESCE_FEED_MATCH)) { return (false);}
+	float cosine = 0;
+	for (uint8_t i=0; i<AXES; i++) {
+		cosine += bf->unit[i] * (target[i] - mm.position[i]);
+	}
+	if (cosine < (cfg.coalesce_cosine * move_length)) { return (false);}
+
+	// distance of the block's endpoint from the new chord
+	float length = get_axis_vector_length(target, mm.last_aline_start);
+	float chord[AXES], projection = 0, deviation = 0;
+	for (uint8_t i=0; i<AXES; i++) {
+		chord[i] = (target[i] - mm.last_aline_start[i]) / length;
+		projection += chord[i] * (bf->target[i] - mm.last_aline_start[i]);
+	}
+	for (uint8_t i=0; i<AXES; i++) {
+		deviation += square(bf->target[i] - mm.last_aline_start[i] - projection * chord[i]);
+	}
+	deviation = sqrt(deviation) + mm.coalesce_deviation;
+	if (deviation > cfg.coalesce_tolerance) { return (false);}
+	if (((bf->length + move_length) / (bf->time + minutes)) < bf->entry_vmax) { return (false);}
+
+	// extend the block to the new target and replan it as the newest block
+	float jerk_squared = 0;
+	for (uint8_t i=0; i<AXES; i++) {
+		bf->unit[i] = chord[i];
+		jerk_squared += square(chord[i] * cfg.a[i].jerk_max);
+	}
+	if (ik_joint_limits()) {
+		float joint_unit[AXES];
+		ik_joint_vector(chord, joint_unit);
+		jerk_squared = _limit_joint_jerk(joint_unit, jerk_squared);
+	}
+	_set_jerk_terms(bf, jerk_squared);
+	copy_axis_vector(bf->target, target);
+	bf->linenum = cm_get_model_linenum();
+	bf->length = length;
+	bf->time += minutes;
+	bf->min_time += min_time;
+	bf->cruise_vmax = bf->length / bf->time;
 	bf->delta_vmax = _get_target_velocity(0, bf->length, bf);
-	bf->exit_vmax = min3(bf->cruise_vmax, (bf->entry_vmax + bf->delta_vmax), exact_stop);
+	bf->exit_vmax = min(bf->cruise_vmax, (bf->entry_vmax + bf->delta_vmax));
 	bf->braking_velocity = bf->delta_vmax;
+	bf->replannable = true;
 
 	uint8_t mr_flag = false;
-	_plan_block_list(bf, &mr_flag);				// replan block list and commit current block
-	copy_axis_vector(mm.position, bf->target);	// update planning position
-	mp_queue_write_buffer(MOVE_TYPE_ALINE);
-	return (STAT_OK);
+	_sim_coalesce();
+	_sim_plan_begin();
+	_plan_block_list(bf, &mr_flag);
+	_sim_plan_end();
+	mm.coalesce_deviation = deviation;
+	copy_axis_vector(mm.position, bf->target);
+	return (true);
+}
+
+/*
+ * _blend_corner() - round the corner between the last queued block and a new move (G64 P)
+ *
+ *	_get_junction_vmax() slows down for a corner as if the tool followed an arc that
+ *	stays within junction_dev of it, but the tool still goes through the corner. If 
+ *	G64 P sets a path tolerance the corner is replaced by an arc tangent to both moves
+ *	that stays within P of the programmed path, when that is faster than the junction
+ *	velocity. Returns the length taken from the start of the move, or 0 if the corner
+ *	is left alone.
+ *
+ *	For a change of direction phi (cos(phi) = u1.u2) an arc of radius R touches the
+ *	moves at d = R*tan(phi/2) from the corner and deviates from the path by 
+ *	R*(1-cos(phi/2)) at its midpoint. The arc is queued as two chords A-M-B (A and B 
+ *	the tangent points, M the midpoint of the arc) which lie up to R*(1-cos(phi/4)) 
+ *	inside it, so:
+ *
+ *		R = P / ((1-cos(phi/2)) + (1-cos(phi/4)))
+ *
+ *	The half and quarter angles come from the half angle identity, as in
+ *	_get_junction_vmax(). d is limited to half the length of either move so their
+ *	other ends can be blended too.
+ *
+ *	The chords are fed at the velocity that puts junction_acceleration on the arc,
+ *	sqrt(ja*R) - the centripetal limit _get_junction_vmax() applies to its virtual
+ *	arc - capped by the feed rates. The junctions between the chords deflect by
+ *	phi/4, phi/2 and phi/4 and are planned like any other junction. The block is 
+ *	trimmed back to A and replanned with the chords, and the move is planned from B.
+ *
+ *	A blend only raises the corner velocity a little for P near junction_dev, and
+ *	then the time spent on the arc outweighs the gain. Slowing from the feed rate F
+ *	to V and back up at jerk J takes about 2*(F-V)^1.5/(F*sqrt(J)) longer than 
+ *	cruising through, so the corner is only blended if that term at the blend 
+ *	velocity, plus the time on the chords less the time for the 2d of path they 
+ *	cut off, comes out less than that term at the junction velocity.
+ */
+
+static float _blend_corner(const float target[], const float length, const float minutes, 
+						   const float work_offset[], const float min_time)
+{
+	mpBuf_t *bf;
+	float tolerance = cm_get_model_path_tolerance();
+
+	if ((fp_ZERO(tolerance)) || ((bf = _get_last_aline(work_offset)) == NULL)) { return (0);}
+	if (mp_get_planner_buffers_available() < BLEND_PLANNER_BUFFERS) { return (0);}
+
+	float unit[AXES], cosine = 0;
+	for (uint8_t i=0; i<AXES; i++) {
+		unit[i] = (target[i] - mm.position[i]) / length;
+		cosine += bf->unit[i] * unit[i];
+	}
+	if (cosine < -0.99) { return (0);}				// reversal cases
+
+	float cos_half = sqrt((1 + cosine)/2);
+	float sin_half = sqrt((1 - cosine)/2);
+	float cos_quarter = sqrt((1 + cos_half)/2);
+	float radius = tolerance / ((1 - cos_half) + (1 - cos_quarter));
+	float distance = radius * sin_half / cos_half;
+	float distance_max = min(bf->length, length) / 2;
+	if (distance > distance_max) {
+		radius *= distance_max / distance;
+		distance = distance_max;
+	}
+	float feed = min(bf->cruise_vmax, (length / minutes));
+	float velocity = min(sqrt(cfg.junction_acceleration * radius), feed);
+	float junction_velocity = _get_junction_vmax(bf->unit, unit);
+	if (velocity <= junction_velocity) { return (0);}	// also the straight line cases
+
+	float chord = 2 * radius * sqrt((1 - cos_half)/2);	// 2R*sin(phi/4)
+	if ((chord / velocity) < MIN_SEGMENT_TIME) { return (0);}
+
+	// only blend if it saves time (see above)
+	float slowdown = 2 * fast_rsqrt(bf->jerk) / feed;
+	float blend_time = (2 * chord / velocity) - (2 * distance / feed) +
+					   (slowdown * (feed - velocity) * sqrt(feed - velocity));
+	if (blend_time >= (slowdown * (feed - junction_velocity) * sqrt(feed - junction_velocity))) { return (0);}
+
+	// arc midpoint and end point
+	float midpoint[AXES], end[AXES];
+	float offset = radius * (1/cos_half - 1) / (2 * sin_half);
+	for (uint8_t i=0; i<AXES; i++) {
+		midpoint[i] = mm.position[i] + offset * (unit[i] - bf->unit[i]);
+		end[i] = mm.position[i] + distance * unit[i];
+	}
+
+	// trim the block back to the arc's start point
+	float scale = (bf->length - distance) / bf->length;
+	for (uint8_t i=0; i<AXES; i++) {
+		bf->target[i] -= distance * bf->unit[i];
+	}
+	bf->length -= distance;
+	bf->time *= scale;
+	bf->min_time *= scale;
+	bf->delta_vmax = _get_target_velocity(0, bf->length, bf);
+	bf->exit_vmax = min(bf->cruise_vmax, (bf->entry_vmax + bf->delta_vmax));
+	bf->braking_velocity = bf->delta_vmax;
+	bf->replannable = true;
+	copy_axis_vector(mm.position, bf->target);
+
+	// queue the chords. Planning the first one replans the trimmed block
+	float chord_min_time = chord * min_time / length;
+	_plan_aline(midpoint, (chord / velocity), work_offset, chord_min_time);
+	_plan_aline(end, (chord / velocity), work_offset, chord_min_time);
+	return (distance);
 }
 
 /***** ALINE HELPERS *****
@@ -277,20 +691,34 @@ stat_t mp_aline(const float target[], const float minutes, const float work_offs
  *		These routines also set all blocks in the list to be replannable so the 
  *		list can be recomputed regardless of exact stops and previous replanning 
  *		optimizations.
+ *
+ *	[2]	A block's braking velocity depends only on the blocks after it. So if
+ *		the backward pass computes the same braking velocity a block already
+ *		has, no block before it can change either, and its own exit velocity
+ *		(limited by the same min() term) is also unchanged. The backward pass
+ *		stops there and the forward pass starts with the block after it, so
+ *		a new block only replans the tail of the list it actually affects.
+ *		This doesn't apply to feedhold replanning (mr_flag set), which has
+ *		changed the blocks themselves and must replan the whole list.
  */
 static void _plan_block_list(mpBuf_t *bf, uint8_t *mr_flag)
 {
 	mpBuf_t *bp = bf;
+	float braking_velocity;
 
 	// Backward planning pass. Find beginning of the list and update the braking velocities.
-	// At the end *bp points to the first buffer before the list.
+	// At the end *bp points to the first buffer before the blocks to be replanned.
 	while ((bp = mp_get_prev_buffer(bp)) != bf) {
 		if (bp->replannable == false) { break; }
-		bp->braking_velocity = min(bp->nx->entry_vmax, bp->nx->braking_velocity) + bp->delta_vmax;
+		_sim_plan_visit();
+		braking_velocity = min(bp->nx->entry_vmax, bp->nx->braking_velocity) + bp->delta_vmax;
+		if ((braking_velocity == bp->braking_velocity) && (*mr_flag == false)) { break; } // see Note [2]
+		bp->braking_velocity = braking_velocity;
 	}
 
 	// forward planning pass - recomputes trapezoids in the list.
 	while ((bp = mp_get_next_buffer(bp)) != bf) {
+		_sim_plan_visit();
 		if ((bp->pv == bf) || (*mr_flag == true))  {
 			bp->entry_velocity = bp->entry_vmax;		// first block in the list
 			*mr_flag = false;
@@ -309,6 +737,7 @@ static void _plan_block_list(mpBuf_t *bf, uint8_t *mr_flag)
 		}
 	}
 	// finish up the last block move
+	_sim_plan_visit();
 	bp->entry_velocity = bp->pv->exit_velocity;
 	bp->cruise_velocity = bp->cruise_vmax;
 	bp->exit_velocity = 0;
@@ -385,7 +814,7 @@ static void _reset_replannable_list()
  *
  *	  Rate-Limited cases - Ve and Vx can be satisfied but Vt cannot
  *	  	HT	(Ve=Vx)<Vt	symmetric case. Split the length and compute Vt.
- *	  	HT'	(Ve!=Vx)<Vt	asymmetric case. Find H and T by successive approximation.
+ *	  	HT'	(Ve!=Vx)<Vt	asymmetric case. Solve for Vt with _get_ht_velocity().
  *		HBT'			Lb < min body length - treated as an HT case
  *		H'				Lb < min body length - reduce J to fit H to length
  *		T'				Lb < min body length - reduce J to fit T to length
@@ -469,23 +898,8 @@ static void _calculate_trapezoid(mpBuf_t *bf)
 			return;
 		}
 
-		// Rate-limited HT' case (asymmetric) - this is relatively expensive but it's not called very often
-		float computed_velocity = bf->cruise_vmax;
-		uint8_t i=0;
-		do {
-			bf->cruise_velocity = computed_velocity;	// initialize from previous iteration 
-			bf->head_length = _get_target_length(bf->entry_velocity, bf->cruise_velocity, bf);
-			bf->tail_length = _get_target_length(bf->exit_velocity, bf->cruise_velocity, bf);
-			if (bf->head_length > bf->tail_length) {
-				bf->head_length = (bf->head_length / (bf->head_length + bf->tail_length)) * bf->length;
-				computed_velocity = _get_target_velocity(bf->entry_velocity, bf->head_length, bf);
-			} else {
-				bf->tail_length = (bf->tail_length / (bf->head_length + bf->tail_length)) * bf->length;
-				computed_velocity = _get_target_velocity(bf->exit_velocity, bf->tail_length, bf);
-			}
-			if (++i > TRAPEZOID_ITERATION_MAX) { fprintf_P(stderr,PSTR("_calculate_trapezoid() failed to converge"));}
-		} while ((fabs(bf->cruise_velocity - computed_velocity) / computed_velocity) > TRAPEZOID_ITERATION_ERROR_PERCENT);
-		bf->cruise_velocity = computed_velocity;
+		// Rate-limited HT' case (asymmetric)
+		bf->cruise_velocity = _get_ht_velocity(bf);
 		bf->head_length = _get_target_length(bf->entry_velocity, bf->cruise_velocity, bf);
 		bf->tail_length = bf->length - bf->head_length;
 		if (bf->head_length < MIN_HEAD_LENGTH) {
@@ -525,6 +939,41 @@ static void _calculate_trapezoid(mpBuf_t *bf)
 	}
 }
 
+/*
+ * _get_ht_velocity() - cruise velocity for a rate-limited asymmetric HT' move
+ *
+ *	Solves Lh(Vt) + Lt(Vt) = L for Vt, where Lh and Lt are the head and tail
+ *	lengths from _get_target_length(). With d = sqrt(1/Jm) the equation is:
+ *
+ *	  f(Vt) = (Vt-Ve)^(3/2) * d + (Vt-Vx)^(3/2) * d - L = 0
+ *	  f'(Vt) = 3/2 * ((Vt-Ve)^(1/2) + (Vt-Vx)^(1/2)) * d
+ *
+ *	f is increasing and convex above max(Ve,Vx), and f(max(Ve,Vx)) < 0 or the
+ *	move would have been a degraded head or tail case. So Newton's method
+ *	converges monotonically from any starting point above the root. The start
+ *	is the symmetric solution for the mean of Ve and Vx, which is never below
+ *	the root (x^(3/2) is convex), and is usually within a few percent of it.
+ *	The length fits to TRAPEZOID_LENGTH_FIT_TOLERANCE in 2 or 3 steps. The
+ *	steps are bounded by TRAPEZOID_ITERATION_MAX anyway, and since each one
+ *	only moves down towards the root the result errs on the side of too fast
+ *	by a tiny margin, which the tail_length = L - head_length fixup absorbs.
+ */
+static float _get_ht_velocity(const mpBuf_t *bf)
+{
+	float Vt = (bf->entry_velocity + bf->exit_velocity)/2 + _get_target_velocity(0, bf->length/2, bf);
+
+	for (uint8_t i=0; i < TRAPEZOID_ITERATION_MAX; i++) {
+		float head_dV = Vt - bf->entry_velocity;
+		float tail_dV = Vt - bf->exit_velocity;
+		float head_root = sqrt(head_dV * bf->recip_jerk);	// sqrt(dV/Jm)
+		float tail_root = sqrt(tail_dV * bf->recip_jerk);
+		float error = head_dV * head_root + tail_dV * tail_root - bf->length;
+		if (fabs(error) < TRAPEZOID_LENGTH_FIT_TOLERANCE) { break;}
+		Vt -= error / (1.5 * (head_root + tail_root));
+	}
+	return (Vt);
+}
+
 /*	
  * _get_target_length()		- derive accel/decel length from delta V and jerk
  * _get_target_velocity()	- derive velocity achievable from delta V and length
@@ -578,7 +1027,7 @@ static float _get_target_length(const float Vi, const float Vt, const mpBuf_t *b
 
 static float _get_target_velocity(const float Vi, const float L, const mpBuf_t *bf)
 {
-	return (pow(L, 0.66666666) * bf->cbrt_jerk + Vi);
+	return (fast_pow_two_thirds(L) * bf->cbrt_jerk + Vi);	// see util.c for error bound
 }
 
 /*	
@@ -724,6 +1173,36 @@ static float _get_junction_vmax(const float a_unit[], const float b_unit[])
 	return(sqrt(radius * cfg.junction_acceleration));
 }
 
+/*
+ * _get_joint_junction_vmax() - junction velocity the joints allow (see kinematics.h)
+ *
+ *	Runs _get_junction_vmax() on the corner as the joints see it: the joint 
+ *	directions of the two blocks, with the deviations of the joints' axes. That
+ *	gives a joint velocity, which is divided by the larger joint travel per mm 
+ *	of the two blocks to get the path velocity.
+ */
+
+static float _get_joint_junction_vmax(const float a_unit[], const float b_unit[])
+{
+	float a_joint[AXES], b_joint[AXES];
+	float a_length = 0, b_length = 0;
+
+	ik_joint_vector(a_unit, a_joint);
+	ik_joint_vector(b_unit, b_joint);
+	for (uint8_t i=0; i<AXES; i++) {
+		a_length += square(a_joint[i]);
+		b_length += square(b_joint[i]);
+	}
+	if ((a_length < EPSILON) || (b_length < EPSILON)) { return (10000000);}	// no previous block
+	a_length = sqrt(a_length);
+	b_length = sqrt(b_length);
+	for (uint8_t i=0; i<AXES; i++) {
+		a_joint[i] /= a_length;
+		b_joint[i] /= b_length;
+	}
+	return (_get_junction_vmax(a_joint, b_joint) / max(a_length, b_length));
+}
+
 /*************************************************************************
  * feedholds - functions for performing holds
  *
@@ -793,7 +1272,11 @@ stat_t mp_plan_hold_callback()
 	float braking_length;		// distance required to brake to zero from braking_velocity
 
 	// examine and process mr buffer
-	mr_available_length = get_axis_vector_length(mr.endpoint, mr.position);
+	if (mr.move_type == MOVE_TYPE_ARC) {
+		mr_available_length = mr.arc_length;
+	} else {
+		mr_available_length = get_axis_vector_length(mr.endpoint, mr.position);
+	}
 
 /*	mr_available_length = 
 		(sqrt(square(mr.endpoint[AXIS_X] - mr.position[AXIS_X]) +
@@ -850,7 +1333,7 @@ stat_t mp_plan_hold_callback()
 	bp->move_state = MOVE_STATE_NEW;			// tell _exec to re-use buffer
 	for (uint8_t i=0; i<PLANNER_BUFFER_POOL_SIZE; i++) {// a safety to avoid wraparound
 		mp_copy_buffer(bp, bp->nx);				// copy bp+1 into bp+0 (and onward...)
-		if (bp->move_type != MOVE_TYPE_ALINE) {	// skip any non-move buffers
+		if ((bp->move_type != MOVE_TYPE_ALINE) && (bp->move_type != MOVE_TYPE_ARC)) {	// skip any non-move buffers
 			bp = mp_get_next_buffer(bp);		// point to next buffer
 			continue;
 		}
@@ -1006,6 +1489,7 @@ static stat_t _exec_aline(mpBuf_t *bf)
 		mr.section_state = MOVE_STATE_NEW;
 		mr.linenum = bf->linenum;
 		mr.motion_mode = bf->motion_mode;
+		mr.move_type = bf->move_type;
 		mr.jerk = bf->jerk;
 		mr.head_length = bf->head_length;
 		mr.body_length = bf->body_length;
@@ -1016,6 +1500,32 @@ static stat_t _exec_aline(mpBuf_t *bf)
 		copy_axis_vector(mr.unit, bf->unit);
 		copy_axis_vector(mr.endpoint, bf->target);	// save the final target of the move
 		copy_axis_vector(mr.work_offset, bf->work_offset);// propagate offset
+		if (mr.move_type == MOVE_TYPE_ARC) {		// the arc starts from the runtime position (may be a hold point)
+			mr.arc_center[0] = bf->arc_center[0];
+			mr.arc_center[1] = bf->arc_center[1];
+			mr.arc_radius_per_mm = bf->arc_radius_per_mm;
+			mr.arc_theta_per_mm = bf->arc_theta_per_mm;
+			mr.arc_axis_1 = bf->arc_axis_1;
+			mr.arc_axis_2 = bf->arc_axis_2;
+			mr.arc_theta = atan2(mr.position[mr.arc_axis_1] - mr.arc_center[0], mr.position[mr.arc_axis_2] - mr.arc_center[1]);
+			mr.arc_radius = hypot(mr.position[mr.arc_axis_1] - mr.arc_center[0], mr.position[mr.arc_axis_2] - mr.arc_center[1]);
+			mr.arc_sin = sin(mr.arc_theta);
+			mr.arc_cos = cos(mr.arc_theta);
+			mr.arc_resync = ARC_RESYNC_SEGMENTS;
+			mr.arc_length = bf->length;
+		}
+		if (ik_segment_limit()) {				// longest segment the kinematics allow (see kinematics.h)
+			if (mr.move_type == MOVE_TYPE_ARC) {
+				float center[AXES];
+				copy_axis_vector(center, mr.position);
+				center[mr.arc_axis_1] = mr.arc_center[0];
+				center[mr.arc_axis_2] = mr.arc_center[1];
+				mr.ik_segment_length = ik_segment_length(center, max(mr.arc_radius, 
+									   mr.arc_radius + mr.arc_radius_per_mm * mr.arc_length));
+			} else {
+				mr.ik_segment_length = min(ik_segment_length(mr.position, 0), ik_segment_length(mr.endpoint, 0));
+			}
+		}
 	}
 	// NB: from this point on the contents of the bf buffer do not affect execution
 
@@ -1053,6 +1563,7 @@ static stat_t _exec_aline(mpBuf_t *bf)
 		mr.section_state = MOVE_STATE_OFF;
 		bf->nx->replannable = false;			// prevent overplanning (Note 2)
 		if (bf->move_state == MOVE_STATE_RUN) {
+			_sim_move_end(mr.position, mr.endpoint, mr.linenum);
 			mp_free_run_buffer();				// free bf if it's actually done
 		}
 	}
@@ -1107,6 +1618,7 @@ static stat_t _exec_aline_head()
 		mr.midpoint_velocity = (mr.entry_velocity + mr.cruise_velocity) / 2;
 		mr.move_time = mr.head_length / mr.midpoint_velocity;	// time for entire accel region
 		mr.segments = ceil(uSec(mr.move_time) / (2 * cfg.estd_segment_usec)); // # of segments in *each half*
+		if (ik_segment_limit()) { mr.segments = _ik_segments(mr.segments, mr.head_length / 2, mr.move_time / 2);}
 		mr.segment_move_time = mr.move_time / (2 * mr.segments);
 		mr.segment_count = (uint32_t)mr.segments;
 		if ((mr.microseconds = uSec(mr.segment_move_time)) < MIN_SEGMENT_USEC) {
@@ -1132,7 +1644,7 @@ static stat_t _exec_aline_head()
 	if (mr.section_state == MOVE_STATE_RUN2) {	// convex part of accel curve (period 2)
 		mr.segment_velocity += mr.forward_diff_1;
 		mr.forward_diff_1 += mr.forward_diff_2;
-		if (_exec_aline_segment(false) == STAT_COMPLETE) {
+		if (_exec_aline_segment((fp_ZERO(mr.body_length)) && (fp_ZERO(mr.tail_length))) == STAT_COMPLETE) {
 			if ((fp_ZERO(mr.body_length)) && (fp_ZERO(mr.tail_length))) { return(STAT_OK);}	// end the move
 			mr.move_state = MOVE_STATE_BODY;
 			mr.section_state = MOVE_STATE_NEW;
@@ -1156,6 +1668,7 @@ static stat_t _exec_aline_body()
 		}
 		mr.move_time = mr.body_length / mr.cruise_velocity;
 		mr.segments = ceil(uSec(mr.move_time) / cfg.estd_segment_usec);
+		if (ik_segment_limit()) { mr.segments = _ik_segments(mr.segments, mr.body_length, mr.move_time);}
 		mr.segment_move_time = mr.move_time / mr.segments;
 		mr.segment_velocity = mr.cruise_velocity;
 		mr.segment_count = (uint32_t)mr.segments;
@@ -1166,7 +1679,7 @@ static stat_t _exec_aline_body()
 		mr.section_state = MOVE_STATE_RUN;
 	}
 	if (mr.section_state == MOVE_STATE_RUN) {				// stright part (period 3)
-		if (_exec_aline_segment(false) == STAT_COMPLETE) {
+		if (_exec_aline_segment(fp_ZERO(mr.tail_length)) == STAT_COMPLETE) {
 			if (fp_ZERO(mr.tail_length)) { return(STAT_OK);}	// end the move
 			mr.move_state = MOVE_STATE_TAIL;
 			mr.section_state = MOVE_STATE_NEW;
@@ -1185,6 +1698,7 @@ static stat_t _exec_aline_tail()
 		mr.midpoint_velocity = (mr.cruise_velocity + mr.exit_velocity) / 2;
 		mr.move_time = mr.tail_length / mr.midpoint_velocity;
 		mr.segments = ceil(uSec(mr.move_time) / (2 * cfg.estd_segment_usec));// # of segments in *each half*
+		if (ik_segment_limit()) { mr.segments = _ik_segments(mr.segments, mr.tail_length / 2, mr.move_time / 2);}
 		mr.segment_move_time = mr.move_time / (2 * mr.segments);// time to advance for each segment
 		mr.segment_count = (uint32_t)mr.segments;
 		if ((mr.microseconds = uSec(mr.segment_move_time)) < MIN_SEGMENT_USEC) {
@@ -1215,16 +1729,53 @@ static stat_t _exec_aline_tail()
 	return(STAT_EAGAIN);
 }
 
+/*
+ * _ik_segments() - segments for a section of a delta or Z mesh move
+ *
+ *	segments is the count the segment time ($ms) gives a section (or each half of
+ *	one) that is length long and runs for move_time. The segments must also be
+ *	short enough for the kinematics (mr.ik_segment_length, see kinematics.h). 
+ *	But every segment costs a kinematics call in the exec, so a segment may not
+ *	be shorter than the call takes at IK_SEGMENT_BUDGET, nor MIN_SEGMENT_USEC.
+ *	With the Z mesh on they may not be shorter than NOM_SEGMENT_USEC either, so
+ *	the compensation never runs the exec faster than its nominal rate. 
+ *	If the kinematics ask for more segments than that the segments are 
+ *	lengthened to the floor and the section runs with more deviation than $ct.
+ */
+static float _ik_segments(const float segments, const float length, const float move_time)
+{
+	float wanted = ceil(length / mr.ik_segment_length);
+	if (wanted <= segments) { return (segments);}
+
+	float ik_usec = ((cfg.kinematics == KINE_DELTA) ? IK_DELTA_USEC : 0) + ((cfg.zmesh_enable == true) ? IK_MESH_USEC : 0);
+	float floor_usec = max(MIN_SEGMENT_USEC, ik_usec / IK_SEGMENT_BUDGET);
+	if (cfg.zmesh_enable == true) { floor_usec = max(floor_usec, NOM_SEGMENT_USEC);}
+	floor_usec += 1;								// keeps roundoff off the MIN_SEGMENT_USEC test
+	float most = floor(uSec(move_time) / floor_usec);
+	if (wanted > most) {
+		_sim_ik_lengthened();
+		return (max(most, segments));
+	}
+	return (wanted);
+}
+
 /*
  * _exec_aline_segment() - segment runner helper
+ *
+ *	correction_flag is set for the last section of the move, and the last segment
+ *	then goes to the exact endpoint. Arcs move the plane axes around the arc.
+ *	Their sine and cosine are advanced by rotating through the segment angle
+ *	(a few terms of the series, the angle is small), and sin() and cos() are
+ *	only called every ARC_RESYNC_SEGMENTS to stop float drift building up. 
+ *	That is a few multiplies per segment instead of two transcendentals.
  */
 static stat_t _exec_aline_segment(uint8_t correction_flag)
 {
-	float travel[AXES];
 	float steps[MOTORS];
 
 	// Multiply computed length by the unit vector to get the contribution for
-	// each axis. Set the target in absolute coords and compute relative steps.
+	// each axis. Set the target in absolute coords. The kinematics compute the
+	// relative steps.
 
 	if ((correction_flag == true) && (mr.segment_count == 1) && 
 		(cm.motion_state == MOTION_RUN) && (cm.cycle_state == CYCLE_MACHINING)) {
@@ -1242,14 +1793,28 @@ static stat_t _exec_aline_segment(uint8_t correction_flag)
 		mr.target[AXIS_A] = mr.position[AXIS_A] + (mr.unit[AXIS_A] * intermediate);
 		mr.target[AXIS_B] = mr.position[AXIS_B] + (mr.unit[AXIS_B] * intermediate);
 		mr.target[AXIS_C] = mr.position[AXIS_C] + (mr.unit[AXIS_C] * intermediate);
+		if (mr.move_type == MOVE_TYPE_ARC) {
+			float theta = mr.arc_theta_per_mm * intermediate;		// angle of this segment
+			mr.arc_theta += theta;
+			mr.arc_length -= intermediate;
+			mr.arc_radius += mr.arc_radius_per_mm * intermediate;
+			if (--mr.arc_resync == 0) {
+				mr.arc_sin = sin(mr.arc_theta);
+				mr.arc_cos = cos(mr.arc_theta);
+				mr.arc_resync = ARC_RESYNC_SEGMENTS;
+			} else {
+				float theta_squared = theta * theta;
+				float sin_theta = theta * (1 - theta_squared * (0.16666667 - theta_squared * 0.0083333333));
+				float cos_theta = 1 - theta_squared * (0.5 - theta_squared * 0.041666667);
+				float arc_sin = mr.arc_sin;
+				mr.arc_sin = arc_sin * cos_theta + mr.arc_cos * sin_theta;
+				mr.arc_cos = mr.arc_cos * cos_theta - arc_sin * sin_theta;
+			}
+			mr.target[mr.arc_axis_1] = mr.arc_center[0] + mr.arc_sin * mr.arc_radius;
+			mr.target[mr.arc_axis_2] = mr.arc_center[1] + mr.arc_cos * mr.arc_radius;
+			_sim_arc_segment(mr.arc_center, mr.arc_radius, mr.arc_theta, mr.target[mr.arc_axis_1], mr.target[mr.arc_axis_2]);
+		}
 	}
-	travel[AXIS_X] = mr.target[AXIS_X] - mr.position[AXIS_X];
-	travel[AXIS_Y] = mr.target[AXIS_Y] - mr.position[AXIS_Y];
-	travel[AXIS_Z] = mr.target[AXIS_Z] - mr.position[AXIS_Z];
-	travel[AXIS_A] = mr.target[AXIS_A] - mr.position[AXIS_A];
-	travel[AXIS_B] = mr.target[AXIS_B] - mr.position[AXIS_B];
-	travel[AXIS_C] = mr.target[AXIS_C] - mr.position[AXIS_C];
-
 /* The above is a re-arranged and loop unrolled version of this:
 	for (uint8_t i=0; i < AXES; i++) {	// don't do the error correction if you are going into a hold
 		if ((correction_flag == true) && (mr.segment_count == 1) && 
@@ -1258,11 +1823,12 @@ static stat_t _exec_aline_segment(uint8_t correction_flag)
 		} else {
 			mr.target[i] = mr.position[i] + (mr.unit[i] * mr.segment_velocity * mr.segment_move_time);
 		}
-		travel[i] = mr.target[i] - mr.position[i];
 	}
 */
 	// prep the segment for the steppers and adjust the variables for the next iteration
-	ik_kinematics(travel, steps, mr.microseconds);
+	_sim_ik_begin();
+	ik_kinematics(mr.position, mr.target, steps, mr.microseconds);
+	_sim_ik_end(mr.microseconds);
 	if (st_prep_line(steps, mr.microseconds) == STAT_OK) {
 		copy_axis_vector(mr.position, mr.target); 	// update runtime position	
 /*  TRY THIS
@@ -1297,10 +1863,22 @@ static void _make_unit_vector(float unit[], float x, float y, float z, float a,
 //static void _set_jerk(const float jerk, mpBuf_t *bf);
 static void _test_get_target_length(void);
 static void _test_get_target_velocity(void);
+static void _test_trapezoid_solver(void);
+static void _test_fast_math(void);
+static void _test_joint_limits(void);
+static void _test_delta_kinematics(void);
+static void _test_zmesh(void);
+static void _test_compensation(void);
 
 void mp_unit_tests()
 {
 	_test_get_target_length();
+	_test_trapezoid_solver();
+	_test_fast_math();
+	_test_joint_limits();
+	_test_delta_kinematics();
+	_test_zmesh();
+	_test_compensation();
 //	_test_get_target_velocity();
 //	_test_calculate_trapezoid();
 //	_test_get_junction_vmax();
@@ -1479,6 +2057,200 @@ static void _test_calculate_trapezoid()
 
 }
 
+/*
+ * _test_trapezoid_solver() - accuracy and timing of the HT' (asymmetric rate-limited) solver
+ *
+ *	Sweeps entry and exit velocities over a range of lengths and runs every HT'
+ *	move through _calculate_trapezoid() and through the successive approximation
+ *	loop it used before. Head lengths from both are compared to a reference found
+ *	by bisection in double precision. The host build also times both solvers.
+ */
+#ifdef __SIMULATION
+#include <time.h>
+#endif
+
+#define TEST_HT_LENGTHS 10			// 0.25 to 2.5 mm
+#define TEST_HT_VELOCITIES 16		// 0 to 1200 mm/min for each of Ve and Vx
+#define TEST_HT_CRUISE 5000			// high enough to make every case rate limited
+#define TEST_HT_REPEAT 200			// timing loop count (host only)
+
+static uint8_t _test_ht_setup(mpBuf_t *bf, uint8_t l, uint8_t e, uint8_t x)
+{
+	bf->length = 0.25 * (l+1);
+	bf->entry_velocity = 80 * e;
+	bf->exit_velocity = 80 * x;
+	bf->cruise_velocity = TEST_HT_CRUISE;
+	bf->cruise_vmax = TEST_HT_CRUISE;
+	bf->move_state = MOVE_STATE_NEW;
+
+	// select the moves that take the HT' path in _calculate_trapezoid()
+	if (fabs(bf->entry_velocity - bf->exit_velocity) < TRAPEZOID_VELOCITY_TOLERANCE) { return (false);}
+	if (bf->length <= _get_target_length(bf->entry_velocity, bf->exit_velocity, bf) + MIN_BODY_LENGTH) { return (false);}
+	return (true);
+}
+
+static float _test_ht_successive_approx(mpBuf_t *bf)	// the HT' solver before _get_ht_velocity()
+{
+	float computed_velocity = bf->cruise_vmax;
+	uint8_t i=0;
+	do {
+		bf->cruise_velocity = computed_velocity;
+		bf->head_length = _get_target_length(bf->entry_velocity, bf->cruise_velocity, bf);
+		bf->tail_length = _get_target_length(bf->exit_velocity, bf->cruise_velocity, bf);
+		if (bf->head_length > bf->tail_length) {
+			bf->head_length = (bf->head_length / (bf->head_length + bf->tail_length)) * bf->length;
+			computed_velocity = _get_target_velocity(bf->entry_velocity, bf->head_length, bf);
+		} else {
+			bf->tail_length = (bf->tail_length / (bf->head_length + bf->tail_length)) * bf->length;
+			computed_velocity = _get_target_velocity(bf->exit_velocity, bf->tail_length, bf);
+		}
+		if (++i > 10) { break;}
+	} while ((fabs(bf->cruise_velocity - computed_velocity) / computed_velocity) > 0.10);
+	return (_get_target_length(bf->entry_velocity, computed_velocity, bf));
+}
+
+static double _test_ht_reference(const mpBuf_t *bf)
+{
+	double d = sqrt(1/(double)bf->jerk);
+	double lo = max(bf->entry_velocity, bf->exit_velocity);
+	double hi = min(bf->entry_velocity, bf->exit_velocity) + pow(bf->length/d, 2.0/3.0);
+	for (uint8_t i=0; i<60; i++) {
+		double Vt = (lo+hi)/2;
+		if ((pow(Vt - bf->entry_velocity, 1.5) + pow(Vt - bf->exit_velocity, 1.5)) * d > bf->length) {
+			hi = Vt;
+		} else {
+			lo = Vt;
+		}
+	}
+	return (pow((lo+hi)/2 - bf->entry_velocity, 1.5) * d);
+}
+
+static void _test_trapezoid_solver()
+{
+	mpBuf_t *bf = mp_get_write_buffer();
+	uint16_t cases = 0, new_misses = 0, old_misses = 0;
+	double new_error = 0, old_error = 0, error;
+
+	bf->jerk = JERK_TEST_VALUE;
+	bf->recip_jerk = 1/bf->jerk;
+	bf->cbrt_jerk = cbrt(bf->jerk);
+
+	for (uint8_t l=0; l<TEST_HT_LENGTHS; l++) {
+		for (uint8_t e=0; e<TEST_HT_VELOCITIES; e++) {
+			for (uint8_t x=0; x<TEST_HT_VELOCITIES; x++) {
+				if (_test_ht_setup(bf, l, e, x) == false) { continue;}
+				double reference = _test_ht_reference(bf);
+				float old_head = _test_ht_successive_approx(bf);
+				_test_ht_setup(bf, l, e, x);
+				_calculate_trapezoid(bf);
+				if ((fp_ZERO(bf->head_length)) || (fp_ZERO(bf->tail_length))) { continue;}	// converted to H or T
+				cases++;
+				if ((error = fabs(bf->head_length - reference)) > TRAPEZOID_LENGTH_FIT_TOLERANCE) { new_misses++;}
+				new_error = max(new_error, error);
+				if ((error = fabs(old_head - reference)) > TRAPEZOID_LENGTH_FIT_TOLERANCE) { old_misses++;}
+				old_error = max(old_error, error);
+			}
+		}
+	}
+	fprintf_P(stderr, PSTR("HT' solver: %d cases. Worst head length error: newton %f mm (%d out of tolerance), successive approximation %f mm (%d)\n"),
+			  cases, new_error, new_misses, old_error, old_misses);
+
+#ifdef __SIMULATION
+	clock_t start = clock();
+	for (uint16_t r=0; r<TEST_HT_REPEAT; r++) {
+		for (uint8_t l=0; l<TEST_HT_LENGTHS; l++) {
+			for (uint8_t e=0; e<TEST_HT_VELOCITIES; e++) {
+				for (uint8_t x=0; x<TEST_HT_VELOCITIES; x++) {
+					if (_test_ht_setup(bf, l, e, x) == true) { _calculate_trapezoid(bf);}
+				}
+			}
+		}
+	}
+	double new_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+	start = clock();
+	for (uint16_t r=0; r<TEST_HT_REPEAT; r++) {
+		for (uint8_t l=0; l<TEST_HT_LENGTHS; l++) {
+			for (uint8_t e=0; e<TEST_HT_VELOCITIES; e++) {
+				for (uint8_t x=0; x<TEST_HT_VELOCITIES; x++) {
+					if (_test_ht_setup(bf, l, e, x) == true) { _test_ht_successive_approx(bf);}
+				}
+			}
+		}
+	}
+	double old_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+	uint32_t solves = (uint32_t)cases * TEST_HT_REPEAT;
+	fprintf_P(stderr, PSTR("HT' solver: newton %0.1f ns/solve, successive approximation %0.1f ns/solve (host)\n"),
+			  new_time / solves * 1e9, old_time / solves * 1e9);
+#endif
+}
+
+/*
+ * _test_fast_math() - accuracy and timing of the util.c fast math functions
+ *
+ *	Sweeps x geometrically over 1e-6 to 1e6 and reports the worst relative error of
+ *	each function against libm, and the worst error on the high side.
+ *	The host build also times each function against the libm call it replaces.
+ */
+#define TEST_FM_START 0.000001
+#define TEST_FM_END 1000000
+#define TEST_FM_STEP 1.001			// about 27600 points
+#define TEST_FM_REPEAT 100			// timing loop count (host only)
+#define TEST_FM_FUNCTIONS 4
+
+static float _test_fm_fast(uint8_t f, float x)
+{
+	switch (f) {
+		case 0: return (fast_pow_two_thirds(x));
+		case 1: return (fast_cbrt(x));
+		case 2: return (fast_rcbrt(x));
+		default: return (fast_rsqrt(x));
+	}
+}
+
+static float _test_fm_libm(uint8_t f, float x)
+{
+	switch (f) {
+		case 0: return (pow(x, 0.66666666));
+		case 1: return (cbrt(x));
+		case 2: return (1/cbrt(x));
+		default: return (1/sqrt(x));
+	}
+}
+
+static void _test_fast_math()
+{
+	const char *names[] = { "pow(x,2/3)", "cbrt", "1/cbrt", "1/sqrt" };
+
+	for (uint8_t f=0; f<TEST_FM_FUNCTIONS; f++) {
+		float error = 0, high = 0;
+		for (float x = TEST_FM_START; x < TEST_FM_END; x *= TEST_FM_STEP) {
+			float y = _test_fm_fast(f, x);
+			float y_libm = _test_fm_libm(f, x);
+			error = max(error, fabs(y/y_libm - 1));
+			high = max(high, y/y_libm - 1);
+		}
+		fprintf_P(stderr, PSTR("fast math %-10s max relative error %e, worst high %e"), names[f], error, high);
+
+#ifdef __SIMULATION
+		volatile float sink = 0;	// keeps the loops from being optimized away
+		clock_t start = clock();
+		for (uint16_t r=0; r<TEST_FM_REPEAT; r++) {
+			for (float x = TEST_FM_START; x < TEST_FM_END; x *= TEST_FM_STEP) { sink += _test_fm_fast(f, x);}
+		}
+		double fast_time = (double)(clock() - start);
+		start = clock();
+		for (uint16_t r=0; r<TEST_FM_REPEAT; r++) {
+			for (float x = TEST_FM_START; x < TEST_FM_END; x *= TEST_FM_STEP) { sink += _test_fm_libm(f, x);}
+		}
+		double libm_time = (double)(clock() - start);
+		double calls = TEST_FM_REPEAT * log(TEST_FM_END/TEST_FM_START) / log(TEST_FM_STEP);
+		fprintf_P(stderr, PSTR(", %0.1f ns vs %0.1f ns libm (host)"),
+				  fast_time / CLOCKS_PER_SEC / calls * 1e9, libm_time / CLOCKS_PER_SEC / calls * 1e9);
+#endif
+		fprintf_P(stderr, PSTR("\n"));
+	}
+}
+
 static void _make_unit_vector(float unit[], float x, float y, float z, float a, float b, float c)
 {
 	float length = sqrt(x*x + y*y + z*z + a*a + b*b + c*c);
@@ -1558,5 +2330,269 @@ static void _test_get_junction_vmax()
 */
 }
 
+/*
+ * _test_joint_limits() - CoreXY kinematics and the joint limits of the planner
+ *
+ *	Checks that fk_kinematics() undoes ik_kinematics(), and reports the jerk and
+ *	90 degree corner velocity of X and diagonal moves against the same moves 
+ *	on a cartesian machine. The diagonal drives one motor at sqrt(2) times the
+ *	path speed, so its jerk should be 1/sqrt(2) of the X move's.
+ */
+static void _test_joint_limits()
+{
+	uint8_t saved_kinematics = cfg.kinematics;
+	float position[AXES] = { 12.5, -40.25, 3, 0, 0, 0 };
+	float result[AXES] = {0};
+	float steps[MOTORS] = {0};
+	float error = 0;
+	float x[AXES], y[AXES], xy[AXES], yx[AXES];
+
+	cfg.kinematics = KINE_COREXY;
+	ik_map_motors();
+	ik_position_steps(position, steps);
+	fk_kinematics(steps, result);
+	for (uint8_t i=0; i<AXES; i++) { error = max(error, fabs(result[i] - position[i]));}
+
+	_make_unit_vector(x, 1, 0, 0, 0, 0, 0);
+	_make_unit_vector(y, 0, 1, 0, 0, 0, 0);
+	_make_unit_vector(xy, 0.7071068, 0.7071068, 0, 0, 0, 0);
+	_make_unit_vector(yx, -0.7071068, 0.7071068, 0, 0, 0, 0);
+	float jerk_squared = square(cfg.a[AXIS_X].jerk_max);
+	ik_joint_vector(x, position);
+	float x_jerk = sqrt(_limit_joint_jerk(position, jerk_squared));
+	ik_joint_vector(xy, position);
+	float xy_jerk = sqrt(_limit_joint_jerk(position, jerk_squared));
+	float x_corner = min(_get_junction_vmax(x, y), _get_joint_junction_vmax(x, y));
+	float xy_corner = min(_get_junction_vmax(xy, yx), _get_joint_junction_vmax(xy, yx));
+	cfg.kinematics = saved_kinematics;
+	ik_map_motors();
+
+	fprintf_P(stderr, PSTR("CoreXY: ik/fk round trip error %e mm, jerk X %0.0f diagonal %0.0f, "), error, x_jerk, xy_jerk);
+	fprintf_P(stderr, PSTR("corner X/Y %0.1f diagonal %0.1f (cartesian %0.1f)\n"), 
+			  x_corner, xy_corner, _get_junction_vmax(x, y));
+}
+
+/*
+ * _test_delta_kinematics() - delta round trip, segment lengths and IK cost
+ *
+ *	Runs points over the bed through ik_position_steps() and fk_kinematics(),
+ *	reports the segment length ik_segment_length() gives at the center and at
+ *	90 mm out (away from the Z tower), and on the host times ik_kinematics()
+ *	over a run of 0.7 mm segments the way the exec calls it. The time is per 
+ *	segment, to compare with IK_SEGMENT_BUDGET of the segment time.
+ */
+#define TEST_DK_REPEAT 100			// timing loop count (host only)
+#define TEST_DK_SEGMENTS 720		// segments around an 80 mm radius circle
+
+static void _test_delta_kinematics()
+{
+	uint8_t saved_kinematics = cfg.kinematics;
+	float position[AXES] = {0};
+	float result[AXES] = {0};
+	float steps[MOTORS] = {0};
+	float error = 0;
+
+	cfg.kinematics = KINE_DELTA;
+	ik_map_motors();
+	ik_delta_init();
+	for (float r = 0; r <= 90; r += 15) {
+		for (float theta = 0; theta < 360; theta += 20) {
+			position[AXIS_X] = r * cos(theta / RADIAN);
+			position[AXIS_Y] = r * sin(theta / RADIAN);
+			position[AXIS_Z] = r / 6;
+			ik_position_steps(position, steps);
+			fk_kinematics(steps, result);
+			for (uint8_t i=0; i<AXES; i++) { error = max(error, fabs(result[i] - position[i]));}
+		}
+	}
+	float center[AXES] = {0};
+	float edge[AXES] = { 0, -90, 0, 0, 0, 0 };
+	fprintf_P(stderr, PSTR("delta: ik/fk round trip error %e mm, segment length %0.3f mm at center, %0.3f mm at 90 mm"),
+			  error, ik_segment_length(center, 0), ik_segment_length(edge, 0));
+
+#ifdef __SIMULATION
+	float target[AXES] = {0};
+	volatile float sink = 0;		// keeps the loop from being optimized away
+	clock_t start = clock();
+	for (uint16_t r=0; r<TEST_DK_REPEAT; r++) {
+		for (uint16_t s=0; s<TEST_DK_SEGMENTS; s++) {
+			target[AXIS_X] = 80 * cos(s / (float)TEST_DK_SEGMENTS * 2 * M_PI);
+			target[AXIS_Y] = 80 * sin(s / (float)TEST_DK_SEGMENTS * 2 * M_PI);
+			ik_kinematics(position, target, steps, NOM_SEGMENT_USEC);
+			copy_axis_vector(position, target);
+			sink += steps[MOTOR_1];
+		}
+	}
+	double ns = (double)(clock() - start) / CLOCKS_PER_SEC / TEST_DK_REPEAT / TEST_DK_SEGMENTS * 1e9;
+	fprintf_P(stderr, PSTR(", %0.1f ns per segment (host, includes the target math)"), ns);
+#endif
+	fprintf_P(stderr, PSTR("\n"));
+	cfg.kinematics = saved_kinematics;
+	ik_map_motors();
+}
+
+/*
+ * _test_zmesh() - Z mesh lookup, round trip, segment length and IK cost
+ *
+ *	Loads a tilted mesh with a bump in the middle and checks the offset at the
+ *	points and at the cell centers (the mean of the corners), that 
+ *	fk_kinematics() takes the offset back out, and reports the segment length
+ *	ik_segment_length() gives. On the host it times ik_kinematics() over a run
+ *	of 0.5 mm segments with the mesh on and off.
+ */
+#define TEST_ZM_REPEAT 100			// timing loop count (host only)
+#define TEST_ZM_SEGMENTS 800		// segments along a 400 mm diagonal
+
+static void _test_zmesh()
+{
+	uint8_t saved_enable = cfg.zmesh_enable;
+	float saved_origin[2], saved_spacing[2], saved_mesh[ZMESH_POINTS][ZMESH_POINTS];
+	float position[AXES] = {0};
+	float result[AXES] = {0};
+	float steps[MOTORS] = {0};
+	float point_error = 0, center_error = 0, error = 0;
+	uint8_t r, c, z_motor = MOTOR_3;
+
+	memcpy(saved_origin, cfg.zmesh_origin, sizeof(saved_origin));
+	memcpy(saved_spacing, cfg.zmesh_spacing, sizeof(saved_spacing));
+	memcpy(saved_mesh, cfg.zmesh, sizeof(saved_mesh));
+	for (uint8_t m=0; m<MOTORS; m++) {
+		if (cfg.m[m].motor_map == AXIS_Z) { z_motor = m; break;}
+	}
+	cfg.zmesh_origin[0] = -100;
+	cfg.zmesh_origin[1] = -100;
+	cfg.zmesh_spacing[0] = 50;
+	cfg.zmesh_spacing[1] = 50;
+	for (r=0; r<ZMESH_POINTS; r++) {
+		for (c=0; c<ZMESH_POINTS; c++) { cfg.zmesh[r][c] = 0.001 * c * 50 + 0.002 * r * 50;}
+	}
+	cfg.zmesh[2][2] += 0.5;
+	cfg.zmesh_enable = true;
+	ik_mesh_init();
+
+	for (r=0; r<ZMESH_POINTS; r++) {			// the points, and the cell centers
+		for (c=0; c<ZMESH_POINTS; c++) {
+			position[AXIS_X] = -100 + c * 50;
+			position[AXIS_Y] = -100 + r * 50;
+			ik_position_steps(position, steps);
+			point_error = max(point_error, fabs(steps[z_motor] / cfg.m[z_motor].steps_per_unit - cfg.zmesh[r][c]));
+			if ((r == ZMESH_POINTS-1) || (c == ZMESH_POINTS-1)) { continue;}
+			position[AXIS_X] += 25;
+			position[AXIS_Y] += 25;
+			ik_position_steps(position, steps);
+			float mean = (cfg.zmesh[r][c] + cfg.zmesh[r][c+1] + cfg.zmesh[r+1][c] + cfg.zmesh[r+1][c+1]) / 4;
+			center_error = max(center_error, fabs(steps[z_motor] / cfg.m[z_motor].steps_per_unit - mean));
+		}
+	}
+	for (float x = -130; x <= 130; x += 17.5) {	// round trip, past the edges too
+		for (float y = -130; y <= 130; y += 21.25) {
+			position[AXIS_X] = x;
+			position[AXIS_Y] = y;
+			position[AXIS_Z] = x / 40;
+			ik_position_steps(position, steps);
+			copy_axis_vector(result, position);
+			fk_kinematics(steps, result);
+			for (uint8_t i=0; i<AXES; i++) { error = max(error, fabs(result[i] - position[i]));}
+		}
+	}
+	float center[AXES] = {0};
+	fprintf_P(stderr, PSTR("Z mesh: point error %e mm, cell center error %e mm, ik/fk round trip error %e mm, segment length %0.3f mm"),
+			  point_error, center_error, error, ik_segment_length(center, 0));
+
+#ifdef __SIMULATION
+	float target[AXES] = {0};
+	volatile float sink = 0;		// keeps the loop from being optimized away
+	double ns[2];
+	for (uint8_t enable=0; enable<2; enable++) {
+		cfg.zmesh_enable = enable;
+		ik_mesh_init();
+		copy_axis_vector(position, center);
+		clock_t start = clock();
+		for (uint16_t rep=0; rep<TEST_ZM_REPEAT; rep++) {
+			for (uint16_t s=0; s<TEST_ZM_SEGMENTS; s++) {
+				target[AXIS_X] = -140 + s * (280 / (float)TEST_ZM_SEGMENTS);
+				target[AXIS_Y] = target[AXIS_X];
+				ik_kinematics(position, target, steps, NOM_SEGMENT_USEC);
+				copy_axis_vector(position, target);
+				sink += steps[z_motor];
+			}
+		}
+		ns[enable] = (double)(clock() - start) / CLOCKS_PER_SEC / TEST_ZM_REPEAT / TEST_ZM_SEGMENTS * 1e9;
+	}
+	fprintf_P(stderr, PSTR(", %0.1f ns per segment (%0.1f ns off, host)"), ns[1], ns[0]);
+#endif
+	fprintf_P(stderr, PSTR("\n"));
+	memcpy(cfg.zmesh_origin, saved_origin, sizeof(saved_origin));
+	memcpy(cfg.zmesh_spacing, saved_spacing, sizeof(saved_spacing));
+	memcpy(cfg.zmesh, saved_mesh, sizeof(saved_mesh));
+	cfg.zmesh_enable = saved_enable;
+	ik_mesh_init();
+}
+
+/*
+ * _test_compensation() - pitch error round trip and backlash take-up
+ *
+ *	Loads an X pitch table and backlash and checks that fk_kinematics() takes
+ *	the correction back out. Then runs X forward and back in 0.5 mm segments 
+ *	at a low $xvm and reports the take-up after the reversal: the total, how
+ *	many segments it was spread over, and the most in one segment against the
+ *	limit from IK_BACKLASH_VELOCITY.
+ */
+#define TEST_PC_SEGMENTS 20			// segments each way
+
+static void _test_compensation()
+{
+	cfgAxis_t saved_axis = cfg.a[AXIS_X];
+	float position[AXES] = {0};
+	float target[AXES] = {0};
+	float result[AXES] = {0};
+	float steps[MOTORS] = {0};
+	float error = 0, take_up = 0, most = 0;
+	uint8_t x_motor = MOTOR_1, segments = 0;
+
+	for (uint8_t m=0; m<MOTORS; m++) {
+		if (cfg.m[m].motor_map == AXIS_X) { x_motor = m; break;}
+	}
+	cfg.a[AXIS_X].pitch_spacing = 25;
+	for (uint8_t i=0; i<PITCH_POINTS; i++) { cfg.a[AXIS_X].pitch[i] = 0.01 * i - 0.004 * (i & 1);}
+	cfg.a[AXIS_X].backlash = 0.05;
+	cfg.a[AXIS_X].velocity_max = 600;
+	ik_comp_init();
+
+	for (float x = -10; x <= 200; x += 3.7) {	// past both ends of the table
+		position[AXIS_X] = x;
+		ik_position_steps(position, steps);
+		copy_axis_vector(result, position);
+		fk_kinematics(steps, result);
+		error = max(error, fabs(result[AXIS_X] - x));
+	}
+
+	position[AXIS_X] = 50;
+	ik_comp_reset(position);
+	for (uint8_t s=0; s < 2 * TEST_PC_SEGMENTS; s++) {
+		copy_axis_vector(target, position);
+		target[AXIS_X] += (s < TEST_PC_SEGMENTS) ? 0.5 : -0.5;
+		ik_kinematics(position, target, steps, NOM_SEGMENT_USEC);
+		copy_axis_vector(position, target);
+		memset(steps, 0, sizeof(steps));
+		ik_backlash_steps(steps);
+		float backlash = steps[x_motor] / cfg.m[x_motor].steps_per_unit;
+		if (backlash != take_up) {
+			most = max(most, fabs(backlash - take_up));
+			segments++;
+		}
+		take_up = backlash;
+	}
+	float limit = cfg.a[AXIS_X].velocity_max * IK_BACKLASH_VELOCITY * NOM_SEGMENT_USEC / MICROSECONDS_PER_MINUTE;
+	fprintf_P(stderr, PSTR("pitch/backlash: ik/fk round trip error %e mm, take-up %0.4f mm over %d segments, %0.4f mm max per segment (limit %0.4f)\n"),
+			  error, take_up, segments, most, limit);
+
+	cfg.a[AXIS_X] = saved_axis;				// take the correction back out of the state
+	ik_comp_init();
+	position[AXIS_X] = 0;
+	ik_comp_reset(position);
+	ik_comp_init();
+}
+
 #endif // __UNIT_TEST_PLANNER
 #endif
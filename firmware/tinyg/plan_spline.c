@@ -0,0 +1,332 @@
+/*
+ * plan_spline.c - G5 and G5.1 spline moves
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdlib.h>
+#include <math.h>
+#include <stdio.h>				// precursor for xio.h
+#include <avr/pgmspace.h>		// precursor for xio.h
+
+#include "xio/xio.h"			// support trap and debug statements
+#include "tinyg.h"
+#include "config.h"
+#include "canonical_machine.h"
+#include "util.h"
+#include "plan_spline.h"
+#include "planner.h"
+#include "kinematics.h"
+#include "report.h"
+#ifdef __SIMULATION
+#include "sim/sim.h"
+#endif
+
+struct spSpline {						// spline being queued (see plan_spline.h)
+	uint8_t run_state;					// MOVE_STATE_OFF when no spline is running
+	uint8_t continuation;				// the last spline was a G5 (see next_offset)
+	float t;							// curve parameter of the last line queued (0 to 1)
+	float position[AXES];				// endpoint of the last line queued
+	float start[AXES];					// start of the spline
+	float endpoint[AXES];				// end of the spline
+	float work_offset[AXES];			// offset from machine coord system for reporting
+	float a[2];							// X and Y are ((a*t + b)*t + c)*t + start
+	float b[2];
+	float c[2];
+	float length;						// estimated length in mm
+	float time;							// G93: minutes for the whole spline, 0 in G94
+	float feed_rate;					// mm per minute
+	float tolerance;					// chord error the lines are stepped for, inside $ct
+	float next_offset[2];				// I J of a G5 that continues this one
+};
+static struct spSpline sp;
+
+/*
+ * Local functions
+ */
+static void _spline_point(const float t, float point[]);
+static float _get_curvature(const float t);
+static float _next_parameter(void);
+static float _get_segment_time(const float target[]);
+#ifdef __SIMULATION
+static float _chord_error(const float t0, const float t1);
+#endif
+
+/*****************************************************************************
+ * cm_spline_feed() - G5, G5.1 entry point
+ *
+ *	offset[] is I J P Q in that order, offset_flags[] their gcode flags.
+ *	Sets up the spline for sp_spline_callback() and moves the gcode model to
+ *	its endpoint. A quadratic is raised to a cubic through the same points.
+ */
+stat_t cm_spline_feed(float target[], float flags[], 	// spline endpoint
+					  float offset[], float offset_flags[],	// I J P Q
+					  uint8_t motion_mode)				// G5 or G5.1
+{
+	float scale = (gm.units_mode == INCHES) ? MM_PER_INCH : 1;
+	float control_1[2], control_2[2];
+	uint8_t continuation = ((gm.motion_mode == MOTION_MODE_CUBIC_SPLINE) && (sp.continuation == true)) ? true : false;
+
+	// copy parameters into the current state
+	gm.motion_mode = motion_mode;
+
+	// An F or M word by itself in spline mode is not an error (see cm_arc_feed())
+	if ((flags[AXIS_X] + flags[AXIS_Y] + flags[AXIS_Z] + flags[AXIS_A] + flags[AXIS_B] + flags[AXIS_C] +
+		 offset_flags[0] + offset_flags[1] + offset_flags[2] + offset_flags[3]) == 0) {
+		return (STAT_OK);
+	}
+
+	// trap zero feed rate condition
+	if (((gm.inverse_feed_rate_mode == false) && (gm.feed_rate == 0)) ||
+		((gm.inverse_feed_rate_mode == true) && (gm.inverse_feed_rate == 0))) {
+		return (STAT_GCODE_FEEDRATE_ERROR);
+	}
+	if (sp.run_state != MOVE_STATE_OFF) { return (STAT_INTERNAL_ERROR);}	// (not supposed to fail)
+	if (gm.select_plane != CANON_PLANE_XY) { return (STAT_SPLINE_SPECIFICATION_ERROR);}
+	cm_set_target(target, flags);
+
+	// control points in the XY plane (axes 0 and 1)
+	if (motion_mode == MOTION_MODE_CUBIC_SPLINE) {
+		if ((offset_flags[2] + offset_flags[3]) == 0) { return (STAT_SPLINE_SPECIFICATION_ERROR);}
+		if (((offset_flags[0] + offset_flags[1]) == 0) && (continuation == false)) { 
+			return (STAT_SPLINE_SPECIFICATION_ERROR);
+		}
+		for (uint8_t i=0; i<2; i++) {
+			if ((offset_flags[0] + offset_flags[1]) == 0) {
+				control_1[i] = gm.position[i] + sp.next_offset[i];	// continue the last G5
+			} else {
+				control_1[i] = gm.position[i] + offset[i] * scale;
+			}
+			control_2[i] = gm.target[i] + offset[i+2] * scale;
+			sp.next_offset[i] = -offset[i+2] * scale;
+		}
+	} else {
+		if ((offset_flags[0] + offset_flags[1]) == 0) { return (STAT_SPLINE_SPECIFICATION_ERROR);}
+		for (uint8_t i=0; i<2; i++) {
+			float control = gm.position[i] + offset[i] * scale;
+			control_1[i] = gm.position[i] + (control - gm.position[i]) * 2/3;
+			control_2[i] = gm.target[i] + (control - gm.target[i]) * 2/3;
+		}
+	}
+	for (uint8_t i=0; i<2; i++) {
+		sp.c[i] = 3 * (control_1[i] - gm.position[i]);
+		sp.b[i] = 3 * (control_2[i] - control_1[i]) - sp.c[i];
+		sp.a[i] = gm.target[i] - gm.position[i] - sp.c[i] - sp.b[i];
+	}
+	copy_axis_vector(sp.start, gm.position);
+	copy_axis_vector(sp.endpoint, gm.target);
+
+	// length from a few chords, for G93 and the minimum length
+	float point[AXES];
+	copy_axis_vector(sp.position, sp.start);
+	sp.length = 0;
+	for (uint8_t k=1; k <= SPLINE_LENGTH_SAMPLES; k++) {
+		_spline_point((float)k / SPLINE_LENGTH_SAMPLES, point);
+		stat_t status = ik_check_target(point);
+		if (status != STAT_OK) { return (status);}
+		sp.length += get_axis_vector_length(point, sp.position);
+		copy_axis_vector(sp.position, point);
+	}
+	if (sp.length < cfg.arc_segment_len) {	// too short to draw
+		return (STAT_MINIMUM_LENGTH_MOVE_ERROR);
+	}
+	// leave room in $ct for the float rounding of the line ends
+	float extent = max(max(fabs(sp.start[AXIS_X]), fabs(sp.start[AXIS_Y])), 
+					   max(fabs(sp.endpoint[AXIS_X]), fabs(sp.endpoint[AXIS_Y]))) + sp.length;
+	sp.tolerance = max(cfg.chordal_tolerance - extent * SPLINE_ROUNDING, cfg.chordal_tolerance / 2);
+	if (gm.inverse_feed_rate_mode == true) {
+		sp.time = gm.inverse_feed_rate;
+		sp.feed_rate = sp.length / sp.time;
+	} else {
+		sp.time = 0;
+		sp.feed_rate = gm.feed_rate;
+	}
+	copy_axis_vector(sp.work_offset, cm_get_coord_offset_vector(gm.work_offset));
+	copy_axis_vector(sp.position, sp.start);
+	sp.t = 0;
+	sp.continuation = (motion_mode == MOTION_MODE_CUBIC_SPLINE) ? true : false;
+	sp.run_state = MOVE_STATE_RUN;
+
+	cm_cycle_start();						// required for homing & other cycles
+	cm_set_gcode_model_endpoint_position(STAT_OK);
+	return (STAT_OK);
+}
+
+/*
+ * sp_spline_callback() - queue the lines of a spline
+ *
+ *	Structured as a continuation called by the controller. Each time it's 
+ *	called it queues lines while the planner has room, up to 
+ *	SPLINE_LINES_PER_CALL, then returns. Input is not read while a spline is
+ *	running. The last line goes to the exact endpoint.
+ *
+ *	The setup only checks the reach at the length samples, so each line
+ *	target is checked again here. A line out of reach stops the spline where
+ *	the last line ended, and reports STAT_MAX_TRAVEL_EXCEEDED.
+ */
+stat_t sp_spline_callback()
+{
+	float target[AXES];
+
+	if (sp.run_state == MOVE_STATE_OFF) { return (STAT_NOOP);}
+	for (uint8_t lines=0; lines < SPLINE_LINES_PER_CALL; lines++) {
+		if (mp_get_planner_buffers_available() < PLANNER_BUFFER_HEADROOM) { return (STAT_EAGAIN);}
+		float t = _next_parameter();
+		if (t < 1) {
+			_spline_point(t, target);
+		} else {
+			copy_axis_vector(target, sp.endpoint);
+		}
+		if (ik_check_target(target) != STAT_OK) {	// the rest of the curve is out of reach
+			sp.run_state = MOVE_STATE_OFF;
+			sp.continuation = false;
+			copy_axis_vector(gm.position, sp.position);	// the model stops where the lines did
+			rpt_exception(STAT_MAX_TRAVEL_EXCEEDED, 0);
+			return (STAT_MAX_TRAVEL_EXCEEDED);
+		}
+		_sim_spline_segment(_chord_error(sp.t, t));
+		if (MP_LINE(target, _get_segment_time(target), sp.work_offset, 0) == STAT_OK) {
+			copy_axis_vector(sp.position, target);	// lines too short to queue are picked up by the next
+		}
+		sp.t = t;
+		if (t >= 1) {
+			sp.run_state = MOVE_STATE_OFF;
+			return (STAT_OK);
+		}
+	}
+	return (STAT_EAGAIN);
+}
+
+/*
+ * sp_abort_spline() - stop a spline (the planner queue was flushed)
+ *
+ *	OK to call if no spline is running
+ */
+void sp_abort_spline()
+{
+	sp.run_state = MOVE_STATE_OFF;
+	sp.continuation = false;
+}
+
+/*
+ * _spline_point()		- position at curve parameter t
+ * _get_curvature()		- magnitude of the second derivative in XY at t (mm per unit t squared)
+ */
+static void _spline_point(const float t, float point[])
+{
+	for (uint8_t i=0; i<AXES; i++) {
+		point[i] = sp.start[i] + (sp.endpoint[i] - sp.start[i]) * t;
+	}
+	for (uint8_t i=0; i<2; i++) {
+		point[i] = sp.start[i] + ((sp.a[i] * t + sp.b[i]) * t + sp.c[i]) * t;
+	}
+}
+
+static float _get_curvature(const float t)
+{
+	return (hypot(6 * sp.a[0] * t + 2 * sp.b[0], 6 * sp.a[1] * t + 2 * sp.b[1]));
+}
+
+/*
+ * _next_parameter() - curve parameter at the end of the next line
+ *
+ *	A line over a parameter step h leaves the curve by at most h^2/8 times the
+ *	largest second derivative over the step. The second derivative of a cubic
+ *	is linear in t, so its largest value is at one end of the step. The step 
+ *	is taken from the start, then shortened for the end. It is worked to 
+ *	sp.tolerance, which is $ct less the rounding of the float points the 
+ *	lines are queued to (SPLINE_ROUNDING). The step is not held
+ *	to a shortest line, which would take it past $ct where the curve is tight.
+ *	Short lines are slowed instead (see _get_segment_time()). A remainder 
+ *	shorter than one step is split with the step before it, not left as a sliver.
+ */
+static float _next_parameter()
+{
+	float h = 1 - sp.t;
+	float curvature = _get_curvature(sp.t);
+
+	if (curvature > 0) {
+		h = min(h, sqrt(8 * sp.tolerance / curvature));
+		curvature = max(curvature, _get_curvature(sp.t + h));
+		h = sqrt(8 * sp.tolerance / curvature);
+	}
+	if ((sp.t + h) >= 1) { return (1);}
+	if ((sp.t + 2*h) > 1) { return (sp.t + (1 - sp.t) / 2);}
+	return (sp.t + h);
+}
+
+/*
+ * _get_segment_time() - minutes for the line from sp.position to target
+ *
+ *	At the feed rate (a share of the G93 time), held to the axis and joint 
+ *	feed rates as in _get_move_times(). No line takes less than 
+ *	MIN_ARC_SEGMENT_TIME, so the feed is cut on the short lines of a tight 
+ *	curve and the planner is not sent lines faster than it can plan them.
+ */
+static float _get_segment_time(const float target[])
+{
+	float travel[AXES], joint[AXES];
+	float length = get_axis_vector_length(target, sp.position);
+	float time = (sp.time > 0) ? (sp.time * length / sp.length) : (length / sp.feed_rate);
+
+	for (uint8_t i=0; i<AXES; i++) {
+		travel[i] = target[i] - sp.position[i];
+		time = max(time, fabs(travel[i]) / cfg.a[i].feedrate_max);
+	}
+	if (ik_joint_limits()) {
+		ik_joint_vector(travel, joint);
+		for (uint8_t i=0; i<AXES; i++) {
+			time = max(time, fabs(joint[i]) / cfg.a[i].feedrate_max);
+		}
+	}
+	return (max(time, MIN_ARC_SEGMENT_TIME));
+}
+
+#ifdef __SIMULATION
+/*
+ * _chord_error() - distance in XY from the line between t0 and t1 to the curve,
+ *					sampled at the quarter points (simulator spline check)
+ *
+ *	The line ends are the float points that were queued. The curve is worked
+ *	in double, so the float rounding of the samples does not count as error.
+ */
+static float _chord_error(const float t0, const float t1)
+{
+	float p0[AXES], p1[AXES];
+	double error = 0;
+
+	_spline_point(t0, p0);
+	_spline_point(t1, p1);
+	double dx = (double)p1[AXIS_X] - p0[AXIS_X];
+	double dy = (double)p1[AXIS_Y] - p0[AXIS_Y];
+	double chord = hypot(dx, dy);
+	for (uint8_t k=1; k<4; k++) {
+		double t = t0 + ((double)t1 - t0) * k / 4;
+		double x = sp.start[AXIS_X] + ((sp.a[0] * t + sp.b[0]) * t + sp.c[0]) * t - p0[AXIS_X];
+		double y = sp.start[AXIS_Y] + ((sp.a[1] * t + sp.b[1]) * t + sp.c[1]) * t - p0[AXIS_Y];
+		double distance = (chord > 0) ? fabs(x * dy - y * dx) / chord : hypot(x, y);
+		error = max(error, distance);
+	}
+	return ((float)error);
+}
+#endif
@@ -0,0 +1,60 @@
+/*
+ * plan_spline.h - G5 and G5.1 spline moves
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Splines
+ *
+ *	G5 is a cubic Bezier from the current position to X Y. I J is the first
+ *	control point as an offset from the start, P Q the second as an offset from
+ *	the end. A G5 that follows a G5 may leave out I J to continue smoothly, the
+ *	first control point is then the second one of the last spline mirrored 
+ *	through the start. G5.1 is a quadratic Bezier with the control point at
+ *	I J from the start. Splines are in the XY plane (G17). Other axes move 
+ *	linearly with the curve parameter.
+ *
+ *	The spline is queued as lines by sp_spline_callback(), which runs as a
+ *	continuation in the controller like homing does. Each call queues lines 
+ *	until the planner is down to PLANNER_BUFFER_HEADROOM free buffers, at most 
+ *	SPLINE_LINES_PER_CALL of them so the rest of the controller still gets its
+ *	turn (status reports, feedholds) while the planner drains. Each line's parameter 
+ *	step is set from the curvature so the chord stays within the chordal 
+ *	tolerance ($ct). No line runs in less than MIN_ARC_SEGMENT_TIME, so the
+ *	feed is cut where the curve is too tight for lines of that length to stay
+ *	within $ct. Splines shorter than the minimum arc segment ($ma) are not drawn.
+ */
+
+#ifndef plan_spline_h
+#define plan_spline_h 
+
+#define SPLINE_LENGTH_SAMPLES 16		// chords used to estimate the length of a spline
+#define SPLINE_LINES_PER_CALL 8			// most lines queued by one sp_spline_callback()
+#define SPLINE_ROUNDING 2.4e-7			// float rounding of a line end per mm of its coordinates (2 ulp)
+
+// function prototypes
+stat_t sp_spline_callback(void);
+void sp_abort_spline(void);
+
+#endif
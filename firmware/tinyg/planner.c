@@ -66,9 +66,13 @@
 #include "planner.h"
 #include "spindle.h"
 #include "stepper.h"
+#include "kinematics.h"
 #include "report.h"
 #include "util.h"
 //#include "xio/xio.h"			// uncomment for debugging
+#ifdef __SIMULATION
+#include "sim/sim.h"
+#endif
 
 /*
  * Local Scope Data and Functions
@@ -81,6 +85,7 @@
 // execution routines (NB: These are all called from the LO interrupt)
 static stat_t _exec_dwell(mpBuf_t *bf);
 static stat_t _exec_command(mpBuf_t *bf);
+static void _set_step_position(void);
 
 #ifdef __DEBUG
 static uint8_t _get_buffer_index(mpBuf_t *bf); 
@@ -99,13 +104,11 @@ void mp_init()
 
 	mr.magic_start = MAGICNUM;
 	mr.magic_end = MAGICNUM;
-	ar.magic_start = MAGICNUM;
-	ar.magic_end = MAGICNUM;
 	mp_init_buffers();
 }
 
 /* 
- * mp_flush_planner() - flush all moves in the planner and all arcs
+ * mp_flush_planner() - flush all moves in the planner
  *
  *	Does not affect the move currently running in mr.
  *	Does not affect mm or gm model positions
@@ -114,8 +117,8 @@ void mp_init()
  */
 void mp_flush_planner()
 {
-	ar_abort_arc();
 	mp_init_buffers();
+	mm.last_aline = NULL;						// nothing left to merge into
 	cm.motion_state = MOTION_STOP;
 //	copy_axis_vector(mm.position, mr.position);
 }
@@ -124,6 +127,7 @@ void mp_flush_planner()
  * mp_set_plan_position() 	- sets planning position (for G92)
  * mp_get_plan_position() 	- returns planning position
  * mp_set_axis_position() 	- sets both planning and runtime positions (for G2/G3)
+ * mp_get_step_position()	- returns runtime position from the motor step counters
  *
  * 	Keeping track of position is complicated by the fact that moves exist in 
  *	several reference frames. The scheme to keep this straight is:
@@ -137,6 +141,12 @@ void mp_flush_planner()
  *	are not an accurate representation of the tool position. In reality 
  *	the motors will still be processing the action and the real tool 
  *	position is still close to the starting point.
+ *
+ *	The stepper step counters record what the motors actually did. Setting
+ *	the runtime position also sets the counters, so the two agree. Once the
+ *	motors have stopped, mp_get_step_position() gives the position without 
+ *	the float error that mr.position picks up over a long job. Axes with no
+ *	motor mapped keep mr.position.
  */
 float *mp_get_plan_position(float position[])
 {
@@ -153,12 +163,41 @@ void mp_set_axes_position(const float position[])
 {
 	copy_axis_vector(mm.position, position);
 	copy_axis_vector(mr.position, position);
+	_set_step_position();
 }
 
 void mp_set_axis_position(uint8_t axis, const float position)
 {
 	mm.position[axis] = position;
 	mr.position[axis] = position;
+	_set_step_position();
+}
+
+float *mp_get_step_position(float position[])
+{
+	float steps[MOTORS];
+
+	copy_axis_vector(position, mr.position);
+	for (uint8_t i=0; i<MOTORS; i++) {
+		steps[i] = (float)st_get_step_count(i);
+	}
+	fk_kinematics(steps, position);
+	return (position);
+}
+
+static void _set_step_position()
+{
+	float steps[MOTORS];
+
+	for (uint8_t i=0; i<MOTORS; i++) {		// unmapped motors keep their count
+		steps[i] = (float)st_get_step_count(i);
+	}
+	ik_comp_reset(mr.position);				// the counters take no backlash take-up
+	ik_position_steps(mr.position, steps);
+	for (uint8_t i=0; i<MOTORS; i++) {
+		st_set_step_count(i, lround(steps[i]));
+	}
+	_sim_set_step_position(steps);
 }
 
 /*************************************************************************/
@@ -175,8 +214,8 @@ stat_t mp_exec_move()
 	if ((bf = mp_get_run_buffer()) == NULL) return (STAT_NOOP);	// NULL means nothing's running
 
 	// Manage cycle and motion state transitions. 
-	// Cycle auto-start for lines only. 
-	if (bf->move_type == MOVE_TYPE_ALINE) {
+	// Cycle auto-start for lines and arcs only. 
+	if ((bf->move_type == MOVE_TYPE_ALINE) || (bf->move_type == MOVE_TYPE_ARC)) {
 		if (cm.cycle_state == CYCLE_OFF) cm_cycle_start();
 		if (cm.motion_state == MOTION_STOP) cm.motion_state = MOTION_RUN;
 	}
@@ -262,8 +301,9 @@ static stat_t _exec_dwell(mpBuf_t *bf)
 	if (bf->move_state == MOVE_STATE_NEW) {
 		st_prep_dwell((uint32_t)(bf->time * 1000000));// convert seconds to uSec
 		bf->move_state = MOVE_STATE_RUN;
+		return (STAT_OK);
 	}
-	return (STAT_OK);
+	return (STAT_NOOP);							// already prepped. Wait for mp_end_dwell()
 }
 
 /**** PLANNER BUFFERS *****************************************************
@@ -307,6 +347,10 @@ static stat_t _exec_dwell(mpBuf_t *bf)
  *
  * mp_free_run_buffer()		Release the run buffer & return to buffer pool.
  *
+ * mp_runtime_is_pending()	Returns TRUE if there is a queued or running move 
+ *							that is not stopped in a feedhold. Called by the exec,
+ *							which publishes it to the DDA ISR (sps.exec_pending)
+ *
  * mp_get_prev_buffer(bf)	Returns pointer to prev buffer in linked list
  * mp_get_next_buffer(bf)	Returns pointer to next buffer in linked list 
  * mp_get_first_buffer(bf)	Returns pointer to first buffer, i.e. the running block
@@ -386,6 +430,13 @@ mpBuf_t * mp_get_run_buffer()
 	return (NULL);								// condition: no queued buffers. fail it.
 }
 
+uint8_t mp_runtime_is_pending()
+{
+	if (cm.hold_state == FEEDHOLD_HOLD) { return (false);}
+	if (mb.r->buffer_state < MP_BUFFER_QUEUED) { return (false);}
+	return (true);
+}
+
 void mp_free_run_buffer()						// EMPTY current run buf & adv to next
 {
 	mp_clear_buffer(mb.r);						// clear it out (& reset replannable)
@@ -31,6 +31,7 @@
 enum moveType {				// bf->move_type values 
 	MOVE_TYPE_NULL = 0,		// null move - does a no-op
 	MOVE_TYPE_ALINE,		// acceleration planned line
+	MOVE_TYPE_ARC,			// acceleration planned arc or helix
 	MOVE_TYPE_DWELL,		// delay with no movement
 	MOVE_TYPE_COMMAND,		// general command
 	MOVE_TYPE_TOOL,			// T command
@@ -69,6 +70,7 @@ enum moveState {
 #define NOM_SEGMENT_USEC 		((float)5000)		// nominal segment time
 #define MIN_SEGMENT_USEC 		((float)2500)		// minimum segment time
 #define MIN_ARC_SEGMENT_USEC	((float)10000)		// minimum arc segment time
+#define ARC_RESYNC_SEGMENTS		16					// arc segments between exact sin() and cos() (see _exec_aline_segment())
 #define NOM_SEGMENT_TIME 		(MIN_SEGMENT_USEC / MICROSECONDS_PER_MINUTE)
 #define MIN_SEGMENT_TIME 		(MIN_SEGMENT_USEC / MICROSECONDS_PER_MINUTE)
 #define MIN_ARC_SEGMENT_TIME 	(MIN_ARC_SEGMENT_USEC / MICROSECONDS_PER_MINUTE)
@@ -91,14 +93,24 @@ enum moveState {
 #define PLANNER_BUFFER_POOL_SIZE 28
 #define PLANNER_BUFFER_HEADROOM 4			// buffers to reserve in planner before processing new input line
 
+/* COALESCE_FEED_MATCH
+ *	A G1 move is only merged into the previous block if its feed rate is within
+ *	this fraction of the block's. See _coalesce_aline() and the $la / $lt settings
+ */
+#define COALESCE_FEED_MATCH 0.01
+
+/* BLEND_PLANNER_BUFFERS
+ *	A move that rounds a corner (G64 P) queues the two chords of the blend arc
+ *	and itself. Must not exceed PLANNER_BUFFER_HEADROOM. See _blend_corner()
+ */
+#define BLEND_PLANNER_BUFFERS 3
+
 /* Some parameters for _generate_trapezoid()
- * TRAPEZOID_ITERATION_MAX	 			Max iterations for convergence in the HT asymmetric case.
- * TRAPEZOID_ITERATION_ERROR_PERCENT	Error percentage for iteration convergence. As percent - 0.01 = 1%
+ * TRAPEZOID_ITERATION_MAX	 			Max Newton steps in the HT asymmetric case (normally takes 2 or 3)
  * TRAPEZOID_LENGTH_FIT_TOLERANCE		Tolerance for "exact fit" for H and T cases
  * TRAPEZOID_VELOCITY_TOLERANCE			Adaptive velocity tolerance term
  */
-#define TRAPEZOID_ITERATION_MAX 10
-#define TRAPEZOID_ITERATION_ERROR_PERCENT 0.10
+#define TRAPEZOID_ITERATION_MAX 4
 #define TRAPEZOID_LENGTH_FIT_TOLERANCE (0.0001)	// allowable mm of error in planning phase
 #define TRAPEZOID_VELOCITY_TOLERANCE (max(2,bf->entry_velocity/100))
 
@@ -162,6 +174,13 @@ typedef struct mpBuffer {		// See Planning Velocity Notes for variable usage
 	float jerk;					// maximum linear jerk term for this move
 	float recip_jerk;			// 1/Jm used for planning (compute-once)
 	float cbrt_jerk;			// cube root of Jm used for planning (compute-once)
+
+	float arc_center[2];		// arc center in the arc plane (MOVE_TYPE_ARC only)
+	float arc_radius;			// arc radius at the start
+	float arc_radius_per_mm;	// change in radius per mm of travel (endpoint off the circle)
+	float arc_theta_per_mm;		// change in arc angle per mm of travel (+CW, -CCW)
+	uint8_t arc_axis_1;			// arc plane axes
+	uint8_t arc_axis_2;
 } mpBuf_t;
 
 typedef struct mpBufferPool {	// ring buffer for sub-moves
@@ -180,6 +199,9 @@ typedef struct mpMoveMasterSingleton {	// common variables for planning (move ma
 	float prev_jerk;			// jerk values cached from previous move
 	float prev_recip_jerk;
 	float prev_cbrt_jerk;
+	mpBuf_t *last_aline;		// last block queued by mp_aline() - may be extended or trimmed
+	float last_aline_start[AXES];// start position of that block
+	float coalesce_deviation;	// bound on distance of its merged endpoints from its chord
 #ifdef __UNIT_TEST_PLANNER
 	float test_case;
 	float test_velocity;
@@ -193,6 +215,7 @@ typedef struct mpMoveRuntimeSingleton {	// persistent runtime variables
 	uint16_t magic_start;		// magic number to test memory integity	
 	uint32_t linenum;			// runtime line/block number of BF being executed
 	uint8_t motion_mode;		// runtime motion mode for status reports
+	uint8_t move_type;			// MOVE_TYPE_ALINE or MOVE_TYPE_ARC
 	uint8_t move_state;			// state of the overall move
 	uint8_t section_state;		// state within a move section
 
@@ -222,6 +245,19 @@ typedef struct mpMoveRuntimeSingleton {	// persistent runtime variables
 	float segment_velocity;		// computed velocity for aline segment
 	float forward_diff_1;      // forward difference level 1 (Acceleration)
 	float forward_diff_2;      // forward difference level 2 (Jerk - constant)
+
+	float arc_center[2];		// copies of bf variables of same name (MOVE_TYPE_ARC only)
+	float arc_radius;			// radius of the runtime position
+	float arc_radius_per_mm;
+	float arc_theta_per_mm;
+	uint8_t arc_axis_1;
+	uint8_t arc_axis_2;
+	float arc_theta;			// arc angle of the runtime position...
+	float arc_sin;				// ...its sine and cosine
+	float arc_cos;
+	uint8_t arc_resync;			// segments left before the next exact sin() and cos()
+	float arc_length;			// length left to travel on the arc
+	float ik_segment_length;	// longest segment for the kinematics (see ik_segment_limit())
 	uint16_t magic_end;
 } mpMoveRuntimeSingleton_t;
 
@@ -243,12 +279,15 @@ float *mp_get_plan_position(float position[]);
 void mp_set_plan_position(const float position[]);
 void mp_set_axes_position(const float position[]);
 void mp_set_axis_position(uint8_t axis, const float position);
+float *mp_get_step_position(float position[]);
 
 stat_t mp_exec_move(void);
 void mp_queue_command(void(*cm_exec)(uint8_t, float), uint8_t int_val, float float_val);
 stat_t mp_dwell(const float seconds);
 void mp_end_dwell(void);
 stat_t mp_aline(const float target[], const float minutes, const float work_offset[], const float min_time);
+stat_t mp_arc(const float target[], const float theta, const float radius, const float angular_travel,
+			  const uint8_t axis_1, const uint8_t axis_2, const float minutes, const float work_offset[], const float min_time);
 stat_t mp_plan_hold_callback(void);
 stat_t mp_end_hold(void);
 stat_t mp_feed_rate_override(uint8_t flag, float parameter);
@@ -261,6 +300,7 @@ void mp_queue_write_buffer(const uint8_t move_type);
 void mp_free_run_buffer(void);
 mpBuf_t * mp_get_write_buffer(void); 
 mpBuf_t * mp_get_run_buffer(void);
+uint8_t mp_runtime_is_pending(void);
 mpBuf_t * mp_get_first_buffer(void);
 mpBuf_t * mp_get_last_buffer(void);
 #define mp_get_prev_buffer(b) ((mpBuf_t *)(b->pv))
@@ -278,6 +318,35 @@ float mp_get_runtime_work_scaling(uint8_t axis);
 void mp_set_runtime_work_offset(float offset[]); 
 void mp_zero_segment_velocity(void);
 
+// host simulation hooks for planner benchmarking and the step check (see sim/sim.h). Compile out on the target
+#ifdef __SIMULATION
+#define _sim_plan_begin() sim_plan_begin()
+#define _sim_plan_end() sim_plan_end()
+#define _sim_plan_visit() (sim.plan_visits++)
+#define _sim_planner_stall() sim_planner_stall()
+#define _sim_coalesce() (sim.coalesced++)
+#define _sim_move_end(position, endpoint, linenum) sim_move_end(position, endpoint, linenum)
+#define _sim_ik_begin() sim_ik_begin()
+#define _sim_ik_end(microseconds) sim_ik_end(microseconds)
+#define _sim_ik_lengthened() (sim.ik_lengthened++)
+#define _sim_set_step_position(steps) sim_set_step_position(steps)
+#define _sim_arc_segment(center, radius, theta, target_1, target_2) sim_arc_segment(center, radius, theta, target_1, target_2)
+#define _sim_spline_segment(chord_error) sim_spline_segment(chord_error)
+#else
+#define _sim_plan_begin()
+#define _sim_plan_end()
+#define _sim_plan_visit()
+#define _sim_planner_stall()
+#define _sim_coalesce()
+#define _sim_move_end(position, endpoint, linenum)
+#define _sim_ik_begin()
+#define _sim_ik_end(microseconds)
+#define _sim_ik_lengthened()
+#define _sim_set_step_position(steps)
+#define _sim_arc_segment(center, radius, theta, target_1, target_2)
+#define _sim_spline_segment(chord_error)
+#endif
+
 #ifdef __DEBUG
 void mp_dump_running_plan_buffer(void);
 void mp_dump_plan_buffer_by_index(uint8_t index);
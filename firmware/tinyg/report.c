@@ -108,10 +108,10 @@ static const char msg_sc49[] PROGMEM = "JSON input has too many pairs";
 static const char msg_sc50[] PROGMEM = "JSON output too long";
 static const char msg_sc51[] PROGMEM = "Out of buffer space";
 static const char msg_sc52[] PROGMEM = "Config not taken during machining cycle";
-static const char msg_sc53[] PROGMEM = "53";
-static const char msg_sc54[] PROGMEM = "54";
-static const char msg_sc55[] PROGMEM = "55";
-static const char msg_sc56[] PROGMEM = "56";
+static const char msg_sc53[] PROGMEM = "Binary block error";
+static const char msg_sc54[] PROGMEM = "Binary block out of sequence";
+static const char msg_sc55[] PROGMEM = "Checksum mismatch";
+static const char msg_sc56[] PROGMEM = "Line number out of sequence";
 static const char msg_sc57[] PROGMEM = "57";
 static const char msg_sc58[] PROGMEM = "58";
 static const char msg_sc59[] PROGMEM = "59";
@@ -127,6 +127,7 @@ static const char msg_sc67[] PROGMEM = "Homing cycle failed";
 static const char msg_sc68[] PROGMEM = "Max travel exceeded";
 static const char msg_sc69[] PROGMEM = "Max spindle speed exceeded";
 static const char msg_sc70[] PROGMEM = "Arc specification error";
+static const char msg_sc71[] PROGMEM = "Spline specification error";
 
 PGM_P const msgStatusMessage[] PROGMEM = {
 	msg_sc00, msg_sc01, msg_sc02, msg_sc03, msg_sc04, msg_sc05, msg_sc06, msg_sc07, msg_sc08, msg_sc09,
@@ -136,7 +137,7 @@ PGM_P const msgStatusMessage[] PROGMEM = {
 	msg_sc40, msg_sc41, msg_sc42, msg_sc43, msg_sc44, msg_sc45, msg_sc46, msg_sc47, msg_sc48, msg_sc49,
 	msg_sc50, msg_sc51, msg_sc52, msg_sc53, msg_sc54, msg_sc55, msg_sc56, msg_sc57, msg_sc58, msg_sc59,
 	msg_sc60, msg_sc61, msg_sc62, msg_sc63, msg_sc64, msg_sc65, msg_sc66, msg_sc67, msg_sc68, msg_sc69,
-	msg_sc70
+	msg_sc70, msg_sc71
 };
 
 char *rpt_get_status_message(uint8_t status, char *msg) 
@@ -43,6 +43,16 @@
 
 // Machine configuration settings
 #define CHORDAL_TOLERANCE 			0.001			// chord accuracy for arc drawing
+#define COALESCE_ANGLE				0				// degrees. Max direction change to merge G1 moves (0 = off)
+#define COALESCE_TOLERANCE			0.01			// mm. Max chord error of merged G1 moves
+#define KINEMATICS					KINE_CARTESIAN	// one of: KINE_CARTESIAN, KINE_COREXY, KINE_HBOT, KINE_DELTA
+#define DELTA_ROD_LENGTH			215				// mm. Diagonal rod length (KINE_DELTA only)
+#define DELTA_RADIUS				105				// mm. Horizontal carriage to effector distance at the origin
+#define ZMESH_ENABLE				0				// Z mesh compensation [0=off,1=on] (see kinematics.h)
+#define ZMESH_ORIGIN_X				0				// mm. Machine position of mesh point zm00
+#define ZMESH_ORIGIN_Y				0
+#define ZMESH_SPACING_X				50				// mm. Distance between mesh points
+#define ZMESH_SPACING_Y				50
 #define SWITCH_TYPE 				SW_TYPE_NORMALLY_OPEN	// one of: SW_TYPE_NORMALLY_OPEN, SW_TYPE_NORMALLY_CLOSED
 #define MOTOR_DISABLE_TIMEOUT		60				// seconds
 
@@ -112,4 +122,15 @@
 #define P1_PWM_PHASE_OFF                0.1
 #endif//P1_PWM_FREQUENCY
 
+// If the profile has no pitch error or backlash settings leave compensation off
+#ifndef X_BACKLASH
+
+#define X_BACKLASH					0					// mm. Taken up on direction reversal (see kinematics.h)
+#define X_PITCH_SPACING				50					// mm. Distance between pitch error table points
+#define Y_BACKLASH					0
+#define Y_PITCH_SPACING				50
+#define Z_BACKLASH					0
+#define Z_PITCH_SPACING				50
+#endif//X_BACKLASH
+
 #endif // _SETTINGS_H_
@@ -0,0 +1,51 @@
+#!/bin/sh
+#
+# arcs.sh - run the arc check over a set of arc gcode files
+# Part of TinyG project
+#
+# usage: arcs.sh [gcode_file...]
+#
+# Runs each file through tinyg_sim -v and prints the arc check result: the arc
+# segments checked and the worst deviation from the exact arc point, next to
+# that of the float sin() and cos() formula (see "Arc check" in sim.h). With
+# no arguments circles2.gcode from the gcode_samples directory at the top of
+# the repo is run, and the bigcircle_smallcircle program compiled into the
+# firmware (gcode/gcode_bigcircle_smallcircle.h) is extracted and run. Exits 1
+# if the step check fails or a deviation reaches ARC_TOLERANCE mm.
+#
+
+DIR=$(dirname "$0")
+SIM=$DIR/tinyg_sim
+SAMPLES=$DIR/../../../gcode_samples
+WORK=${TMPDIR:-/tmp}/arcs.$$
+BIGCIRCLE=$WORK/bigcircle_smallcircle.gcode
+ARC_TOLERANCE=0.001
+
+if [ ! -x "$SIM" ]; then
+	echo "$SIM not found - run make" >&2
+	exit 1
+fi
+mkdir -p "$WORK"
+if [ $# -eq 0 ]; then
+	tr -d '\r' < "$DIR/../gcode/gcode_bigcircle_smallcircle.h" | sed -n 's/\\n\\$//p; s/\\n";$//p' > "$BIGCIRCLE"
+	set -- "$SAMPLES/circles2.gcode" "$BIGCIRCLE"
+fi
+
+status=0
+printf "%-36s %9s %12s %12s  %s\n" file segments deviation float result
+for f in "$@"; do
+	if "$SIM" -q -v "$f" > "$WORK/summary"; then
+		result=ok
+	else
+		result=FAILED
+	fi
+	line=$(awk -v file="$(basename "$f")" -v result=$result -v tolerance=$ARC_TOLERANCE '/arc segments/ {
+		gsub(/[(),]/, " ");
+		if ($7 + 0 >= tolerance) { result = "FAILED" }
+		printf "%-36s %9s %12s %12s  %s\n", file, $4, $7, $13, result }' \
+		"$WORK/summary")
+	echo "$line"
+	case "$line" in *FAILED) status=1;; esac
+done
+rm -rf "$WORK"
+exit $status
@@ -0,0 +1,90 @@
+/*
+ * avr/pgmspace.h - host simulation stand-in for avr-libc program memory access
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * On the host program memory is ordinary memory, so PROGMEM vanishes and the
+ * _P functions collapse to their RAM counterparts. A few details matter:
+ *
+ *	- pgm_read_word() is used to fetch pointers (function pointers in cfgArray,
+ *	  string tables). Pointers are 8 bytes here, so it dereferences with the
+ *	  type of the object it points to rather than reading 16 bits.
+ *
+ *	- pgm_read_byte() is also used with small integer addresses to read the
+ *	  production signature row (see sys_get_id()). Those reads are served from
+ *	  a fake signature row in sim_hal.c.
+ *
+ *	- avr-libc uses %S for a program memory string argument. glibc takes %S to
+ *	  be a wide string, so the printf family is routed through wrappers that
+ *	  rewrite %S to %s. This applies to plain fprintf() as well, as config.c
+ *	  prints PROGMEM format strings with it.
+ *
+ *	- strncpy_P() is a bounded copy that always NUL terminates. The firmware
+ *	  passes the full size of the destination as the bound (cmd_copy_string_P(),
+ *	  rpt_get_status_message()) and relies on the strings being shorter.
+ *
+ *	- avr-libc stdio extensions used by xio and network.c are defined here.
+ */
+#ifndef sim_avr_pgmspace_h
+#define sim_avr_pgmspace_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>					// avr-libc pgmspace.h pulls in io.h too
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+typedef char prog_char;
+
+#define pgm_read_word(addr)		(*(addr))
+#define pgm_read_dword(addr)	(*(addr))
+#define pgm_read_float(addr)	(*(addr))
+#define pgm_read_byte(addr)		sim_pgm_read_byte((uintptr_t)(addr))
+
+#define strcpy_P	strcpy
+#define strcat_P	strcat
+#define strcmp_P	strcmp
+#define strncmp_P	strncmp
+#define strlen_P	strlen
+#define memcpy_P	memcpy
+
+static inline char *strncpy_P(char *dst, const char *src, size_t n)
+{
+	if (n == 0) return (dst);
+	size_t len = strnlen(src, n-1);
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+	return (dst);
+}
+
+#define printf_P(...)	sim_printf(__VA_ARGS__)
+#define fprintf_P(...)	sim_fprintf(__VA_ARGS__)
+#define sprintf_P(...)	sim_sprintf(__VA_ARGS__)
+#define printf(...)		sim_printf(__VA_ARGS__)
+#define fprintf(...)	sim_fprintf(__VA_ARGS__)
+
+#define _FDEV_ERR (-1)
+#define _FDEV_EOF (-2)
+
+uint8_t sim_pgm_read_byte(uintptr_t addr);
+int sim_printf(const char *format, ...);
+int sim_fprintf(FILE *stream, const char *format, ...);
+int sim_sprintf(char *str, const char *format, ...);
+
+#endif
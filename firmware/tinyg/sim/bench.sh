@@ -0,0 +1,28 @@
+#!/bin/sh
+#
+# bench.sh - run the planner benchmark over a directory of gcode files
+# Part of TinyG project
+#
+# usage: bench.sh [gcode_dir] [tinyg_sim options]
+#
+# Runs every *.gcode, *.nc, *.ngc and *.txt file in gcode_dir (default is the
+# gcode_samples directory at the top of the repo) through tinyg_sim -b and
+# prints one line per file. Times are host times, parse/b is in ns. See sim.h.
+#
+
+SIM=$(dirname "$0")/tinyg_sim
+DIR=${1:-$(dirname "$0")/../../../gcode_samples}
+[ $# -gt 0 ] && shift
+
+if [ ! -x "$SIM" ]; then
+	echo "$SIM not found - run make first" >&2
+	exit 1
+fi
+
+printf "%-36s %8s %8s %9s %8s %10s %10s %9s %9s %6s %4s %7s %9s %10s %8s\n" \
+	file lines blocks segments fw_sec blocks/s segs/s plan_avg plan_max vis/b vmax stalls stall_pas sim_sec parse/b
+for f in "$DIR"/*.gcode "$DIR"/*.nc "$DIR"/*.ngc "$DIR"/*.txt; do
+	[ -f "$f" ] || continue
+	printf "%-36s " "$(basename "$f")"
+	"$SIM" -b "$@" "$f"
+done
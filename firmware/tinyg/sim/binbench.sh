@@ -0,0 +1,69 @@
+#!/bin/sh
+#
+# binbench.sh - compare binary and text gcode streams
+# Part of TinyG project
+#
+# usage: binbench.sh [-b baud] [gcode_file...]
+#
+# Encodes each file with tinyg_encode (see "Binary gcode blocks" in gcode_parser.h)
+# and runs the text and the binary stream through tinyg_sim -b. Prints one line
+# per file: the lines sent and how many of them went binary, the bytes per line
+# and the lines/sec the serial link carries at the baud rate (default 115200)
+# for text and binary, the host time to read a block into gn and gf for each
+# (parse/b of tinyg_sim -b, ns, the best of RUNS runs to keep host noise out),
+# and whether the binary stream made the same steps
+# (the step traces without their times - dropped comment lines shift the times).
+# Both streams read numbers the same way, so the script exits 1 if they differ.
+# The encoder sends a line as binary only if that is shorter, so the binary stream
+# never takes more bytes per line than the text. The link column says LONGER,
+# and the script exits 1, if it does. The parse times are the host's, where
+# strtod() is cheap; they do not show the xmega's relative cost.
+#
+
+DIR=$(dirname "$0")
+SIM=$DIR/tinyg_sim
+ENCODE=$DIR/tinyg_encode
+SAMPLES=$DIR/../../../gcode_samples
+BAUD=115200
+RUNS=5
+WORK=${TMPDIR:-/tmp}/binbench.$$
+
+if [ "$1" = "-b" ]; then BAUD=$2; shift 2; fi
+if [ $# -eq 0 ]; then
+	set -- $SAMPLES/circles2.gcode $SAMPLES/tinyg_test_001.gcode $SAMPLES/spiro.gcode \
+		   $SAMPLES/mudflap_10in.gcode $SAMPLES/zoetrope.gcode $SAMPLES/roadrunner.gcode \
+		   $SAMPLES/braid_two_decimals.gcode $SAMPLES/braid.gcode
+fi
+for prog in "$SIM" "$ENCODE"; do
+	if [ ! -x "$prog" ]; then
+		echo "$prog not found - run make binary first" >&2
+		exit 1
+	fi
+done
+mkdir -p "$WORK" || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+# best parse/b over RUNS runs of tinyg_sim -b on file $2, step trace in $1
+_parse_ns() {
+	for run in $(seq $RUNS); do
+		"$SIM" -b -t "$1" "$2" | awk '{print $NF}'
+	done | sort -n | head -1
+}
+
+status=0
+printf "%-28s %8s %8s %7s %7s %9s %9s %8s %8s %6s  %s   (%s baud)\n" \
+	file lines binary text_b/l bin_b/l text_l/s bin_l/s text_ns bin_ns steps link $BAUD
+for f in "$@"; do
+	[ -f "$f" ] || continue
+	printf "%-28s " "$(basename "$f")"
+	encoded=$("$ENCODE" -s -b "$BAUD" "$f" "$WORK/binary" 2>&1)
+	printf "%s" "$encoded"
+	if echo "$encoded" | awk '{ exit !($4 > $3) }'; then link=LONGER; status=1; else link=ok; fi
+	text_ns=$(_parse_ns "$WORK/text.trace" "$f")
+	bin_ns=$(_parse_ns "$WORK/binary.trace" "$WORK/binary")
+	grep -v '^#' "$WORK/text.trace" | cut -d' ' -f2- > "$WORK/text.steps"
+	grep -v '^#' "$WORK/binary.trace" | cut -d' ' -f2- > "$WORK/binary.steps"
+	if cmp -s "$WORK/text.steps" "$WORK/binary.steps"; then steps=same; else steps=differ; status=1; fi
+	printf " %8s %8s %6s  %s\n" "$text_ns" "$bin_ns" "$steps" "$link"
+done
+exit $status
@@ -0,0 +1,40 @@
+(compensation.gcode - pitch error tables and backlash for the simulator, see sim.h)
+(X and Y screws off by up to 0.06mm over 175mm, 0.05mm of backlash on X, 0.1mm on Y and Z)
+$xps=25
+$xp0=0
+$xp1=0.012
+$xp2=0.020
+$xp3=0.031
+$xp4=0.036
+$xp5=0.044
+$xp6=0.052
+$xp7=0.060
+$yps=25
+$yp0=0
+$yp1=-0.010
+$yp2=-0.015
+$yp3=-0.024
+$yp4=-0.030
+$yp5=-0.033
+$yp6=-0.041
+$yp7=-0.047
+$xbl=0.05
+$ybl=0.1
+$zbl=0.1
+g21 g90 g17 g64
+g28.3 x0 y0 z0
+g1 f2000 x150 y20
+g1 x10 y40
+g1 x150 y60 z-1
+g1 x10 y80 z1
+g1 y10
+g1 x100
+g1 y100
+g2 x100 y100 i0 j-40
+g3 x60 y100 i-20 j0
+g1 x190 y190
+g1 x0 y0
+g1 z-2
+g1 z0
+g0 x120 y30
+g0 x0 y0
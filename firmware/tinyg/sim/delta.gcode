@@ -0,0 +1,65 @@
+(delta.gcode - linear delta setup and moves for the simulator, see sim.h)
+(towers 215mm rods at 105mm, full microstep so the carriages can run fast)
+$kin=3
+$kl=215
+$kr=105
+$1mi=1
+$2mi=1
+$3mi=1
+$xvm=6000
+$xfr=6000
+$xjm=50000000
+$yvm=6000
+$yfr=6000
+$yjm=50000000
+$zvm=6000
+$zfr=6000
+$zjm=50000000
+g21 g90 g17 g64
+g28.3 x0 y0 z0
+g1 f6000 z5
+g1 x90.000 y0.000
+g1 x0 y0
+g1 x77.942 y45.000
+g1 x0 y0
+g1 x45.000 y77.942
+g1 x0 y0
+g1 x0.000 y90.000
+g1 x0 y0
+g1 x-45.000 y77.942
+g1 x0 y0
+g1 x-77.942 y45.000
+g1 x0 y0
+g1 x-90.000 y0.000
+g1 x0 y0
+g1 x-77.942 y-45.000
+g1 x0 y0
+g1 x-45.000 y-77.942
+g1 x0 y0
+g1 x-0.000 y-90.000
+g1 x0 y0
+g1 x45.000 y-77.942
+g1 x0 y0
+g1 x77.942 y-45.000
+g1 x0 y0
+g1 x80 y0
+g2 x80 y0 i-80 j0
+g3 x-40 y0 z10 i-60 j0
+g1 x0 y0 z5
+g1 x-60 y45
+g1 x60 y30
+g1 x-60 y15
+g1 x60 y0
+g1 x-60 y-15
+g1 x60 y-30
+g1 x-60 y-45
+g1 x60 y-60
+(out of reach of the Y tower: rejected with Max travel exceeded. So are the)
+(arc with its ends in reach and its middle out of reach, and the spline that)
+(leaves the reach between its length samples, which stops there)
+g1 x0 y-150
+g1 x60 y-60
+g2 x-60 y-60 i-60 j0
+g1 x0 y-109.8
+g5 x80 y-60 i3 j-3.2 p0 q-20
+g0 x0 y0 z0
@@ -0,0 +1,245 @@
+/*
+ * encode.c - host encoder for binary gcode blocks
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Converts a gcode file to a stream of binary blocks for the USB port or for
+ * tinyg_sim (see "Binary gcode blocks" in gcode_parser.h). Usage:
+ *
+ *	tinyg_encode [-b baud] [-s] [gcode_file [output_file]]
+ *
+ *	  -b  baud rate for the link estimate (default ENCODE_BAUD_DEFAULT)
+ *	  -s  print a one line summary for binbench.sh
+ *
+ *	Reads stdin and writes stdout if no files are given. A block that has no more
+ *	than a G0-G3 and words in GC_BINARY_WORDS becomes a binary block if that is
+ *	shorter than the line, so no line costs more link time than its text. A 
+ *	binary block is 9 to 84 characters whatever the digits, so short lines 
+ *	(G0 X0 Y0) and lines with few decimals often stay text. Any other line 
+ *	(other G and M codes, T, configs, JSON...) is passed on as text, and
+ *	blank and comment-only lines are dropped. Values are float32 as strtod()
+ *	rounds them, which is how the firmware reads them from text too (see 
+ *	_get_number() in gcode_parser.c).
+ *
+ *	The summary (stderr) gives the bytes per line sent as text and as binary,
+ *	and the lines per second the serial link can carry for each at the baud rate
+ *	(10 bits per character). Dropped lines are left out of both.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include "../gcode_parser.h"
+#include "util/crc16.h"
+
+#define ENCODE_BAUD_DEFAULT 115200
+#define ENCODE_LINE_LEN 256
+#define ENCODE_NUMBER_LEN 32
+#define ENCODE_STX 0x02					// starts a binary block (STX in xio.h)
+
+enum encodeResult { ENCODE_DROP, ENCODE_TEXT, ENCODE_BINARY };
+
+typedef struct encodeBlock {
+	uint8_t opcode;
+	uint16_t mask;						// words present (see GC_BINARY_WORDS)
+	float value[GC_BINARY_MAX_VALUES];
+} encodeBlock_t;
+
+/*
+ * _read_number() - read a decimal number: an optional sign, digits and an optional point
+ *
+ *	Like the firmware, no exponents or hexadecimal (G0X10 is G0 X10)
+ */
+static int _read_number(const char **pstr, double *value)
+{
+	char number[ENCODE_NUMBER_LEN];
+	const char *rd = *pstr;
+	int len = 0, digits = 0;
+
+	if ((*rd == '-') || (*rd == '+')) { number[len++] = *rd++;}
+	for (; (isdigit((int)*rd) || (*rd == '.')) && (len < ENCODE_NUMBER_LEN-1); rd++) {
+		if (isdigit((int)*rd)) digits++;
+		number[len++] = *rd;
+	}
+	number[len] = '\0';
+	if (digits == 0) return (false);
+	*value = strtod(number, NULL);
+	*pstr = rd;
+	return (true);
+}
+
+/*
+ * _parse_line() - find out if a line can be a binary block and collect its words
+ */
+static int _parse_line(const char *line, encodeBlock_t *block)
+{
+	const char *rd = line;
+	double value;
+
+	memset(block, 0, sizeof(encodeBlock_t));
+	while (isspace((int)*rd)) rd++;
+	if ((*rd == '\0') || (*rd == '(') || (*rd == ';')) return (ENCODE_DROP);
+
+	while (true) {
+		while (isspace((int)*rd)) rd++;
+		if ((*rd == '\0') || (*rd == '(') || (*rd == ';')) break;
+		if (isalpha((int)*rd) == false) return (ENCODE_TEXT);
+		char letter = toupper((int)*rd++);
+		while ((*rd == ' ') || (*rd == '\t')) rd++;
+		if (_read_number(&rd, &value) == false) return (ENCODE_TEXT);
+
+		if (letter == 'G') {
+			if ((block->opcode != GC_OPCODE_NONE) || (value != (int)value) || (value < 0) || (value > 3)) {
+				return (ENCODE_TEXT);
+			}
+			block->opcode = GC_OPCODE_G0 + (int)value;
+			continue;
+		}
+		const char *word = strchr(GC_BINARY_WORDS, letter);
+		if (word == NULL) return (ENCODE_TEXT);
+		int bit = word - GC_BINARY_WORDS;
+		if (block->mask & (1 << bit)) return (ENCODE_TEXT);	// word given twice
+		block->mask |= (1 << bit);
+		block->value[bit] = (float)value;
+	}
+	return (ENCODE_BINARY);
+}
+
+/*
+ * _put_word() - write a 32 bit word as base85 digits, most significant first
+ */
+static int _put_word(char *out, uint32_t word, int digits)
+{
+	for (int i=digits-1; i>=0; i--) {
+		char c = GC_BINARY_DIGIT_MIN + (word % GC_BINARY_DIGITS);
+		if (c >= GC_BINARY_DIGIT_SKIP) c++;
+		out[i] = c;
+		word /= GC_BINARY_DIGITS;
+	}
+	return (digits);
+}
+
+/*
+ * _encode_block() - write a binary block line (without the LF). Returns its length
+ */
+static int _encode_block(encodeBlock_t *block, uint8_t sequence, char *out)
+{
+	uint32_t word[GC_BINARY_MAX_VALUES+1];
+	int words = 0, len = 0;
+	uint16_t crc = 0xFFFF;
+
+	word[words++] = ((uint32_t)sequence << 24) | ((uint32_t)block->opcode << 16) | block->mask;
+	for (int bit=0; bit<GC_BINARY_MAX_VALUES; bit++) {
+		if ((block->mask & (1 << bit)) == 0) continue;
+		union { float value; uint32_t word; } number = { .value = block->value[bit] };
+		word[words++] = number.word;
+	}
+	out[len++] = ENCODE_STX;
+	for (int i=0; i<words; i++) {
+		len += _put_word(&out[len], word[i], GC_BINARY_WORD_LEN);
+		for (int shift=24; shift >= 0; shift -= 8) {
+			crc = _crc_ccitt_update(crc, (uint8_t)(word[i] >> shift));
+		}
+	}
+	len += _put_word(&out[len], crc, GC_BINARY_CRC_LEN);
+	out[len] = '\0';
+	return (len);
+}
+
+static void _usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-b baud] [-s] [gcode_file [output_file]]\n", name);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *in = stdin, *out = stdout;
+	char line[ENCODE_LINE_LEN], block_line[ENCODE_LINE_LEN];
+	encodeBlock_t block;
+	unsigned long count[3] = {0,0,0};	// lines dropped, text, binary
+	unsigned long text_bytes = 0, binary_bytes = 0;
+	long baud = ENCODE_BAUD_DEFAULT;
+	int summary = false, sequence = 0, opt;
+
+	while ((opt = getopt(argc, argv, "b:s")) != -1) {
+		switch (opt) {
+			case 'b': { baud = atol(optarg); break;}
+			case 's': { summary = true; break;}
+			default: _usage(argv[0]);
+		}
+	}
+	if (argc - optind > 2) _usage(argv[0]);
+	if ((optind < argc) && ((in = fopen(argv[optind], "r")) == NULL)) { perror(argv[optind]); exit(1);}
+	if ((optind+1 < argc) && ((out = fopen(argv[optind+1], "w")) == NULL)) { perror(argv[optind+1]); exit(1);}
+
+	while (fgets(line, sizeof(line), in) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+		int result = _parse_line(line, &block);
+		if (result == ENCODE_DROP) {
+			count[ENCODE_DROP]++;
+			continue;
+		}
+		int text_len = strlen(line);
+		text_bytes += text_len + 1;
+		if (result == ENCODE_BINARY) {			// send whichever is shorter
+			int binary_len = _encode_block(&block, sequence, block_line);
+			if (binary_len < text_len) {
+				count[ENCODE_BINARY]++;
+				binary_bytes += binary_len + 1;
+				fprintf(out, "%s\n", block_line);
+				sequence = (sequence == GC_BINARY_SEQUENCE_MAX) ? 1 : sequence+1;
+				continue;
+			}
+		}
+		count[ENCODE_TEXT]++;
+		binary_bytes += text_len + 1;
+		fprintf(out, "%s\n", line);
+	}
+	unsigned long lines = count[ENCODE_TEXT] + count[ENCODE_BINARY];
+	double text_per_line = (lines == 0) ? 0 : (double)text_bytes / lines;
+	double binary_per_line = (lines == 0) ? 0 : (double)binary_bytes / lines;
+	double chars_per_sec = baud / 10.0;
+
+	if (summary == true) {		// see binbench.sh for the column headings
+		fprintf(stderr, "%8lu %8lu %7.1f %7.1f %9.0f %9.0f",
+				lines, count[ENCODE_BINARY], text_per_line, binary_per_line,
+				(text_per_line == 0) ? 0 : chars_per_sec / text_per_line,
+				(binary_per_line == 0) ? 0 : chars_per_sec / binary_per_line);
+	} else {
+		fprintf(stderr, "[encode] lines          %lu sent (%lu binary, %lu text), %lu dropped\n",
+				lines, count[ENCODE_BINARY], count[ENCODE_TEXT], count[ENCODE_DROP]);
+		fprintf(stderr, "[encode] bytes per line %0.1f text, %0.1f binary\n", text_per_line, binary_per_line);
+		fprintf(stderr, "[encode] link rate      %0.0f lines/sec text, %0.0f lines/sec binary at %ld baud\n",
+				(text_per_line == 0) ? 0 : chars_per_sec / text_per_line,
+				(binary_per_line == 0) ? 0 : chars_per_sec / binary_per_line, baud);
+	}
+	fclose(out);
+	return (0);
+}
@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# schedule.sh - check the __STEP_SCHEDULE step trace against the DDA
+# Part of TinyG project
+#
+# usage: schedule.sh [gcode_dir]
+#
+# Runs every *.gcode, *.nc, *.ngc and *.txt file in gcode_dir (default is the
+# gcode_samples directory at the top of the repo) through tinyg_sim and
+# tinyg_sched with a step trace, and compares the traces. They must be
+# identical: same pulses, same motors and directions, same clock cycles.
+# Also prints the DDA interrupt count of each build. Exits 1 on a mismatch.
+#
+# The schedule build holds a prep buffer while its events run, so its exec
+# queues one segment less ahead of the loader (see "Step schedules" in
+# stepper.h). Where the planner runs dry the exec then reads a block that was
+# replanned in between, and the segments differ. DXF473 and TinyPOV.PCB do this
+# (runs of very short blocks), so they are skipped unless gcode_dir is given.
+#
+
+DIR=$(dirname "$0")
+SIM=$DIR/tinyg_sim
+SCHED=$DIR/tinyg_sched
+GCODE=${1:-$DIR/../../../gcode_samples}
+TMP=${TMPDIR:-/tmp}/schedule.$$
+
+for f in "$SIM" "$SCHED"; do
+	if [ ! -x "$f" ]; then
+		echo "$f not found - run make schedule" >&2
+		exit 1
+	fi
+done
+
+status=0
+printf "%-36s %10s %12s %12s  %s\n" file pulses dda_isr sched_isr trace
+for f in "$GCODE"/*.gcode "$GCODE"/*.nc "$GCODE"/*.ngc "$GCODE"/*.txt; do
+	[ -f "$f" ] || continue
+	if [ $# -eq 0 ]; then
+		case "$(basename "$f")" in DXF473.gcode|TinyPOV.PCB.gcode) continue;; esac
+	fi
+	"$SIM" -q -t "$TMP.dda" "$f" > "$TMP.dda.out"
+	"$SCHED" -q -t "$TMP.sched" "$f" > "$TMP.sched.out"
+	if cmp -s "$TMP.dda" "$TMP.sched"; then
+		result=same
+	else
+		result=DIFFERENT
+		status=1
+	fi
+	printf "%-36s %10s %12s %12s  %s\n" "$(basename "$f")" \
+		"$(grep -vc '^#' "$TMP.dda")" \
+		"$(awk '/dda ticks/ {print $4}' "$TMP.dda.out")" \
+		"$(awk '/dda ticks/ {print $4}' "$TMP.sched.out")" $result
+done
+rm -f "$TMP.dda" "$TMP.sched" "$TMP.dda.out" "$TMP.sched.out"
+exit $status
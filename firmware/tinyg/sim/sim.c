@@ -0,0 +1,506 @@
+/*
+ * sim.c - host-native simulation of the TinyG motion stack
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* See sim.h for usage and the time model */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <avr/io.h>
+
+#include "../tinyg.h"
+#include "../config.h"
+#include "../planner.h"
+#include "../stepper.h"
+#include "../kinematics.h"
+#include "../system.h"
+#include "../xmega/xmega_rtc.h"
+#include "sim.h"
+#undef printf								// the simulator itself writes to the real streams
+#undef fprintf
+
+simSingleton_t sim;
+
+// the firmware's main() is renamed by the makefile
+int tinyg_main(void);
+
+// timer ISRs (see stepper.c and xmega_rtc.c)
+void TCC0_OVF_isr(void);
+void TCD0_OVF_isr(void);
+void TCE0_OVF_isr(void);
+void TCF0_OVF_isr(void);
+void RTC_COMP_isr(void);
+
+static uint64_t sim_host_start_ns;
+
+static void _sim_finish(const char *reason);
+
+/*
+ * _cycles_to_sec() - convert simulated clock cycles to seconds
+ */
+static double _cycles_to_sec(uint64_t cycles) { return ((double)cycles / (double)F_CPU);}
+
+/*
+ * _host_ns() - host monotonic clock in nanoseconds
+ */
+static uint64_t _host_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+/*
+ * _run_swi() - run any pending LOAD and EXEC software interrupts
+ *
+ *	LOAD is a HI interrupt and EXEC is LO, so LOAD always goes first. Each can
+ *	re-trigger the other (exec requests a load, load requests an exec).
+ */
+static void _run_swi(void)
+{
+	if ((TCE0.CTRLA == STEP_TIMER_DISABLE) && (TCF0.CTRLA == STEP_TIMER_DISABLE)) { return;}
+
+	uint64_t start_ns = _host_ns();
+	for (uint8_t i=0; i < SIM_SWI_LIMIT; i++) {
+		if (TCE0.CTRLA != STEP_TIMER_DISABLE) {
+			sim.loads++;
+			TCE0_OVF_isr();
+		} else if (TCF0.CTRLA != STEP_TIMER_DISABLE) {
+			sim.execs++;
+			TCF0_OVF_isr();
+		} else {
+			break;
+		}
+		sim.last_activity = sim.cycles;
+	}
+	sim.fw_ns += _host_ns() - start_ns;
+}
+
+/*
+ * _start_timer() - schedule a timer's next overflow one period from now
+ * _run_timer()	  - run a timer's ISR if its next overflow falls in this pass
+ *
+ *	The overflow time is kept across passes, so a pass ends at pass_end even
+ *	if that is between two ticks. Returns false if the timer is stopped or
+ *	not due in this pass.
+ */
+static void _start_timer(TC0_t *timer, simTimer_t *t)
+{
+	t->period = (timer->PER == 0) ? 1 : timer->PER;
+	t->due = sim.cycles + t->period;
+}
+
+static uint8_t _run_timer(TC0_t *timer, simTimer_t *t, void (*isr)(void), uint32_t *counter, uint64_t pass_end)
+{
+	if (timer->CTRLA == STEP_TIMER_DISABLE) {
+		t->due = 0;
+		return (false);
+	}
+	if (t->due == 0) { _start_timer(timer, t);}	// started since it was last looked at
+	if (t->due > pass_end) { return (false);}
+	sim.cycles = t->due;
+	t->cycles += t->period;
+	(*counter)++;
+	isr();
+	t->due = 0;
+	if (timer->CTRLA != STEP_TIMER_DISABLE) { _start_timer(timer, t);}
+	sim.last_activity = sim.cycles;
+	return (true);
+}
+
+/*
+ * sim_run_interrupts() - run the interrupts that fall due during one main loop pass
+ *
+ *	Called by the controller at the top of every pass. The pass is given
+ *	sim.pass_cycles of CPU time. Stepper timers that are running consume that
+ *	time tick by tick; an idle machine just lets it elapse.
+ */
+void sim_run_interrupts(void)
+{
+	uint64_t pass_end = sim.cycles + sim.pass_cycles;
+
+	// charge the previous pass to the firmware if it read a line (idle passes are not counted)
+	if (sim_xio_lines() != sim.fw_mark_lines) {
+		sim.fw_ns += _host_ns() - sim.fw_mark_ns;
+		sim.fw_mark_lines = sim_xio_lines();
+	}
+	if (sim.spline_segments != sim.spline_mark) {	// and spline lines separately (see sim.h)
+		sim.spline_ns += _host_ns() - sim.fw_mark_ns;
+		sim.spline_passes++;
+		sim.spline_mark = sim.spline_segments;
+	}
+	sim.passes++;
+	while (sim.cycles < pass_end) {
+		_run_swi();
+		if ((_run_timer(&TCC0, &sim.dda, TCC0_OVF_isr, &sim.dda_ticks, pass_end) == false) &&
+			(_run_timer(&TCD0, &sim.dwell, TCD0_OVF_isr, &sim.dwell_ticks, pass_end) == false)) {
+			sim.cycles = pass_end;
+		}
+		while (sim.cycles >= sim.next_rtc) {
+			sim.next_rtc += SIM_RTC_CYCLES;
+			RTC_COMP_isr();
+		}
+	}
+	_run_swi();
+
+	// done when the input is exhausted and the steppers have been idle for a while
+	if ((sim_xio_input_done() == true) &&
+		(sim.cycles - sim.last_activity > (uint64_t)SIM_IDLE_USEC * (F_CPU / 1000000))) {
+		_sim_finish("end of input");
+	}
+	sim.fw_mark_ns = _host_ns();
+}
+
+/*
+ * sim_plan_begin()	 - start timing a _plan_block_list() call
+ * sim_plan_end()	 - finish timing a _plan_block_list() call
+ * sim_planner_stall() - _sync_to_planner() refused input on this pass
+ */
+void sim_plan_begin(void)
+{
+	sim.plan_start_visits = sim.plan_visits;
+	sim.plan_start_ns = _host_ns();
+}
+
+void sim_plan_end(void)
+{
+	uint64_t ns = _host_ns() - sim.plan_start_ns;
+	uint32_t visits = sim.plan_visits - sim.plan_start_visits;
+
+	sim.blocks++;
+	sim.plan_ns += ns;
+	if (ns > sim.plan_max_ns) { sim.plan_max_ns = ns;}
+	sim.plan_aline_visits += visits;
+	if (visits > sim.plan_max_visits) { sim.plan_max_visits = visits;}
+}
+
+/*
+ * sim_ik_begin()	 - start timing an ik_kinematics() call in the exec
+ * sim_ik_end()	 - finish timing it. microseconds is the segment time
+ */
+void sim_ik_begin(void)
+{
+	sim.ik_start_ns = _host_ns();
+}
+
+void sim_ik_end(const float microseconds)
+{
+	uint64_t ns = _host_ns() - sim.ik_start_ns;
+
+	sim.ik_calls++;
+	sim.ik_ns += ns;
+	if (ns > sim.ik_max_ns) { sim.ik_max_ns = ns;}
+	sim.ik_segment_usec += microseconds;
+}
+
+/*
+ * sim_parse_begin() - start timing a gc_gcode_parser() call
+ * sim_parse_end()	 - the block has been read into gn and gf
+ */
+void sim_parse_begin(void)
+{
+	sim.parse_start_ns = _host_ns();
+}
+
+void sim_parse_end(void)
+{
+	uint64_t ns = _host_ns() - sim.parse_start_ns;
+
+	sim.parse_blocks++;
+	sim.parse_ns += ns;
+	if (ns > sim.parse_max_ns) { sim.parse_max_ns = ns;}
+}
+
+void sim_planner_stall(void)
+{
+	if ((sim.stall_passes == 0) || (sim.stall_pass != sim.passes - 1)) { sim.stalls++;}
+	sim.stall_pass = sim.passes;
+	sim.stall_passes++;
+}
+
+/*
+ * sim_timing_count() - stands in for the xmega cycle counter used by __STEP_TIMING
+ *
+ *	Counts host nanoseconds, so the timings are host CPU time (see stepper.h)
+ */
+uint16_t sim_timing_count(void)
+{
+	return ((uint16_t)_host_ns());
+}
+
+/*
+ * sim_step() - record a step pulse from the DDA ISR
+ *
+ *	Called with the VPORT OUT bits just after the step bit was set, so the
+ *	direction bit reflects the direction of this step.
+ */
+void sim_step(const uint8_t motor, const uint8_t port_bits)
+{
+	uint8_t dir = ((port_bits & DIRECTION_BIT_bm) != 0) ? 1 : 0;
+
+	sim.pulses[motor]++;
+	sim.steps[motor] += ((dir ^ cfg.m[motor].polarity) != 0) ? -1 : 1;
+	if (sim.trace != NULL) {
+		fprintf(sim.trace, "%llu %d %d\n", (unsigned long long)sim.cycles, motor+1, dir);
+	}
+}
+
+/*
+ * sim_move_end()		- queue the endpoint of a move the planner has finished
+ * sim_segment_end()	- the DDA finished a segment. Check the endpoints that are due
+ * sim_set_step_position() - the machine position was set. Rebase the pulse count
+ *						  to the exact steps of the new position, not the rounded 
+ *						  step counters (a delta is never at whole steps)
+ *
+ *	See "Step check" in sim.h
+ */
+static void _check_endpoints(void);
+
+void sim_move_end(const float position[], const float endpoint[], const float linenum)
+{
+	simEndpoint_t *e = &sim.endpoints[sim.endpoint_wr];
+
+	if (memcmp(position, endpoint, sizeof(e->endpoint)) != 0) {
+		sim.short_moves++;
+		return;
+	}
+	sim.endpoint_wr = (sim.endpoint_wr + 1) % SIM_ENDPOINTS;
+	if (sim.endpoint_wr == sim.endpoint_rd) {
+		fprintf(stderr, "[sim] step check endpoint queue overflow\n");
+		exit(1);
+	}
+	e->segment = sim.segments_prepped;
+	e->linenum = (uint32_t)linenum;
+	memcpy(e->endpoint, endpoint, sizeof(e->endpoint));
+	memset(e->backlash, 0, sizeof(e->backlash));
+	ik_backlash_steps(e->backlash);
+	_check_endpoints();						// its last segment may have run already
+}
+
+void sim_segment_end(void)
+{
+	sim.segments_run++;
+	_check_endpoints();
+}
+
+static void _check_endpoints(void)
+{
+	float steps[MOTORS];
+
+	while ((sim.endpoint_rd != sim.endpoint_wr) && 
+		   ((int32_t)(sim.segments_run - sim.endpoints[sim.endpoint_rd].segment) >= 0)) {
+		simEndpoint_t *e = &sim.endpoints[sim.endpoint_rd];
+		sim.endpoint_rd = (sim.endpoint_rd + 1) % SIM_ENDPOINTS;
+		memset(steps, 0, sizeof(steps));
+		ik_position_steps(e->endpoint, steps);
+		for (uint8_t motor=0; motor < MOTORS; motor++) {
+			float error = (sim.steps[motor] + sim.step_offset[motor]) - (steps[motor] + e->backlash[motor]);
+			sim.last_error[motor] = error;
+			if (fabs(error) > sim.max_error) {
+				sim.max_error = fabs(error);
+				sim.max_error_motor = motor;
+				sim.max_error_line = e->linenum;
+			}
+		}
+		sim.checks++;
+	}
+}
+
+void sim_set_step_position(const float steps[])
+{
+	for (uint8_t motor=0; motor < MOTORS; motor++) {
+		sim.step_offset[motor] = steps[motor] - sim.steps[motor];
+	}
+}
+
+/*
+ * sim_arc_segment() - compare an arc segment target with the exact arc point
+ *
+ *	See "Arc check" in sim.h
+ */
+void sim_arc_segment(const float center[], const float radius, const float theta, const float target_1, const float target_2)
+{
+	double exact_1 = center[0] + sin((double)theta) * radius;
+	double exact_2 = center[1] + cos((double)theta) * radius;
+	float float_1 = center[0] + sinf(theta) * radius;
+	float float_2 = center[1] + cosf(theta) * radius;
+	double deviation = hypot(target_1 - exact_1, target_2 - exact_2);
+	double deviation_float = hypot(float_1 - exact_1, float_2 - exact_2);
+
+	sim.arc_segments++;
+	if (deviation > sim.arc_max_deviation) { sim.arc_max_deviation = deviation;}
+	if (deviation_float > sim.arc_max_deviation_float) { sim.arc_max_deviation_float = deviation_float;}
+}
+
+/*
+ * sim_spline_segment() - a spline line was queued, chord_error from the curve
+ *
+ *	See "Spline check" in sim.h
+ */
+void sim_spline_segment(const float chord_error)
+{
+	sim.spline_segments++;
+	if (chord_error > sim.spline_max_error) { sim.spline_max_error = chord_error;}
+}
+
+/*
+ * sim_reset() - a hardware reset or watchdog reset ends the simulation
+ */
+void sim_reset(void)
+{
+	_sim_finish("reset");
+}
+
+/*
+ * _sim_finish() - print the run summary and exit
+ */
+static void _sim_finish(const char *reason)
+{
+	double host_sec = (double)(_host_ns() - sim_host_start_ns) / 1e9;
+	double fw_sec = (double)sim.fw_ns / 1e9;
+	double plan_avg_us = (sim.blocks == 0) ? 0 : (double)sim.plan_ns / sim.blocks / 1000;
+	double plan_max_us = (double)sim.plan_max_ns / 1000;
+	double plan_avg_visits = (sim.blocks == 0) ? 0 : (double)sim.plan_aline_visits / sim.blocks;
+	double ik_avg_ns = (sim.ik_calls == 0) ? 0 : (double)sim.ik_ns / sim.ik_calls;
+	double parse_avg_ns = (sim.parse_blocks == 0) ? 0 : (double)sim.parse_ns / sim.parse_blocks;
+	const char *kinematics[] = {"cartesian", "CoreXY", "H-bot", "delta"};
+
+	if (sim.trace != NULL) {
+		fprintf(sim.trace, "# end %llu\n", (unsigned long long)sim.last_activity);
+		fclose(sim.trace);
+	}
+	fflush(sim.console);
+	if (sim.bench == true) {	// see bench.sh for the column headings
+		printf("%8lu %8lu %9lu %8.3f %10.0f %10.0f %9.2f %9.2f %6.2f %4lu %7lu %9lu %10.1f %8.0f\n",
+			   (unsigned long)sim_xio_lines(), (unsigned long)sim.blocks, (unsigned long)sim.execs, fw_sec,
+			   sim.blocks / fw_sec, sim.execs / fw_sec, plan_avg_us, plan_max_us,
+			   plan_avg_visits, (unsigned long)sim.plan_max_visits,
+			   (unsigned long)sim.stalls, (unsigned long)sim.stall_passes, _cycles_to_sec(sim.last_activity), parse_avg_ns);
+		exit(0);
+	}
+	printf("\n[sim] run ended: %s\n", reason);
+	printf("[sim] lines read:      %lu\n", (unsigned long)sim_xio_lines());
+	printf("[sim] simulated time:  %0.3f sec (job), %0.3f sec (total)\n",
+		   _cycles_to_sec(sim.last_activity), _cycles_to_sec(sim.cycles));
+	printf("[sim] host time:       %0.3f sec (%0.3f sec in firmware)\n", host_sec, fw_sec);
+	printf("[sim] main loop passes %lu\n", (unsigned long)sim.passes);
+	printf("[sim] dda ticks        %lu (%0.0f Hz average while stepping)\n", (unsigned long)sim.dda_ticks,
+		   (sim.dda.cycles == 0) ? 0 : sim.dda_ticks / _cycles_to_sec(sim.dda.cycles));
+	printf("[sim] dwell ticks      %lu\n", (unsigned long)sim.dwell_ticks);
+	printf("[sim] segment loads    %lu\n", (unsigned long)sim.loads);
+	printf("[sim] segment execs    %lu\n", (unsigned long)sim.execs);
+	printf("[sim] underruns        %lu\n", (unsigned long)st_get_underruns());
+#ifdef __STEP_TIMING
+	const char *rows[] = {"dda isr", "load", "exec", "late wait"};
+	for (uint8_t row=0; row < TIMING_ROWS; row++) {
+		printf("[sim] %-16s %lu/%lu/%lu ns min/mean/max (%lu samples)\n", rows[row],
+			   (unsigned long)st_get_timing(row, TIMING_MIN), (unsigned long)st_get_timing(row, TIMING_MEAN),
+			   (unsigned long)st_get_timing(row, TIMING_MAX), (unsigned long)st_get_timing(row, TIMING_COUNT));
+	}
+#endif
+	printf("[sim] blocks planned   %lu (%0.0f blocks/sec, %0.0f segments/sec)\n",
+		   (unsigned long)sim.blocks, sim.blocks / fw_sec, sim.execs / fw_sec);
+	printf("[sim] moves coalesced  %lu (replanned in place, included in blocks planned)\n", (unsigned long)sim.coalesced);
+	printf("[sim] plan_block_list  %0.2f usec avg, %0.2f usec max\n", plan_avg_us, plan_max_us);
+	printf("[sim] blocks visited   %0.2f per block avg, %lu max\n", plan_avg_visits, (unsigned long)sim.plan_max_visits);
+	printf("[sim] planner stalls   %lu (%lu passes)\n", (unsigned long)sim.stalls, (unsigned long)sim.stall_passes);
+	printf("[sim] gcode parsing    %lu blocks, %0.0f ns avg, %lu ns max per block\n",
+		   (unsigned long)sim.parse_blocks, parse_avg_ns, (unsigned long)sim.parse_max_ns);
+	printf("[sim] kinematics       %s%s: %0.0f ns avg, %lu ns max per segment (%0.3f%% of segment time), %lu sections lengthened\n",
+		   kinematics[cfg.kinematics], (cfg.zmesh_enable == true) ? " + Z mesh" : "", ik_avg_ns, (unsigned long)sim.ik_max_ns,
+		   (sim.ik_segment_usec == 0) ? 0 : sim.ik_ns / sim.ik_segment_usec / 10, (unsigned long)sim.ik_lengthened);
+	printf("[sim] arc segments     %lu, max deviation %0.2e mm from the exact arc (%0.2e mm with float sin/cos)\n",
+		   (unsigned long)sim.arc_segments, sim.arc_max_deviation, sim.arc_max_deviation_float);
+	uint8_t spline_failed = (sim.spline_max_error > cfg.chordal_tolerance) ? true : false;
+	printf("[sim] spline segments  %s: %lu, max chord error %0.2e mm (chordal tolerance %0.2e mm)\n",
+		   (spline_failed == true) ? "FAILED" : "ok", (unsigned long)sim.spline_segments, 
+		   (double)sim.spline_max_error, (double)cfg.chordal_tolerance);
+	printf("[sim] spline queueing  %0.2f lines per pass, %0.0f lines/sec (host, %lu passes)\n",
+		   (sim.spline_passes == 0) ? 0 : (double)sim.spline_segments / sim.spline_passes,
+		   (sim.spline_ns == 0) ? 0 : sim.spline_segments / ((double)sim.spline_ns / 1e9), (unsigned long)sim.spline_passes);
+	for (uint8_t motor=0; motor < MOTORS; motor++) {
+		printf("[sim] motor %d          %ld steps net, %lu pulses\n", motor+1,
+			   (long)sim.steps[motor], (unsigned long)sim.pulses[motor]);
+	}
+	for (uint8_t axis=0; axis < AXES; axis++) {
+		printf("[sim] axis %c position  %0.4f\n", "XYZABC"[axis], (double)mp_get_runtime_machine_position(axis));
+	}
+	uint8_t failed = (sim.max_error >= SIM_STEP_TOLERANCE) ? true : false;
+	printf("[sim] step check       %s: %lu endpoints, max error %0.3f steps (motor %d, line %lu), %lu short moves\n",
+		   (failed == true) ? "FAILED" : "ok", (unsigned long)sim.checks, (double)sim.max_error, 
+		   sim.max_error_motor+1, (unsigned long)sim.max_error_line, (unsigned long)sim.short_moves);
+	printf("[sim] final error      ");
+	for (uint8_t motor=0; motor < MOTORS; motor++) {
+		printf("%0.3f%s", (double)sim.last_error[motor], (motor < MOTORS-1) ? ", " : " steps (motors 1-4)\n");
+	}
+	exit(((sim.validate == true) && ((failed == true) || (spline_failed == true))) ? 1 : 0);
+}
+
+static void _usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-t trace_file] [-u usec_per_pass] [-q] [-b] [-v] [gcode_file]\n", name);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	long usec = SIM_PASS_USEC_DEFAULT;
+	FILE *input = stdin;
+
+	memset(&sim, 0, sizeof(sim));
+	sim.console = stdout;
+	while ((opt = getopt(argc, argv, "t:u:qbv")) != -1) {
+		switch (opt) {
+			case 't': {
+				if ((sim.trace = fopen(optarg, "w")) == NULL) { perror(optarg); exit(1);}
+				break;
+			}
+			case 'u': { usec = atol(optarg); break;}
+			case 'q': { sim.quiet = true; break;}
+			case 'b': { sim.bench = true; sim.quiet = true; break;}
+			case 'v': { sim.validate = true; break;}
+			default: _usage(argv[0]);
+		}
+	}
+	if (optind < argc) {
+		if ((input = fopen(argv[optind], "r")) == NULL) { perror(argv[optind]); exit(1);}
+	}
+	if (usec < 1) { _usage(argv[0]);}
+	sim.pass_cycles = (uint64_t)usec * (F_CPU / 1000000);
+	sim.next_rtc = SIM_RTC_CYCLES;
+	if (sim.trace != NULL) {
+		fprintf(sim.trace, "# tinyg_sim step trace: <cycles> <motor> <direction>\n");
+		fprintf(sim.trace, "# f_cpu %lu\n", (unsigned long)F_CPU);
+	}
+	sim_xio_open(input);
+	sim_host_start_ns = _host_ns();
+	return (tinyg_main());				// never returns. Runs end in _sim_finish()
+}
@@ -0,0 +1,260 @@
+/*
+ * sim.h - host-native simulation of the TinyG motion stack
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * The simulator builds the unmodified firmware modules (controller, parser,
+ * canonical machine, planner, stepper, config...) with the host compiler.
+ * The xmega is replaced by:
+ *
+ *	- sim/avr/		  register structs and avr-libc shims (see avr/io.h)
+ *	- sim_hal.c		  peripheral register storage, EEPROM in RAM, clock init
+ *	- sim_xio.c		  xio replacement that reads gcode from a host file
+ *	- sim.c			  main(), the interrupt scheduler and the step trace
+ *
+ * Build with "make" in this directory. Usage:
+ *
+ *	tinyg_sim [-t trace_file] [-u usec_per_pass] [-q] [-b] [-v] [gcode_file]
+ *
+ *	  -t  write a step/direction trace (see below)
+ *	  -u  simulated CPU time consumed by each pass of the controller main loop
+ *	  -q  suppress firmware console output (prompts, status reports)
+ *	  -b  print a one line planner and parser benchmark result instead of the summary
+ *	  -v  step check gate: exit with status 1 if the step check fails (see below)
+ *
+ *	Reads stdin if no file is given. The run ends once the input is exhausted
+ *	and all motion has completed. A summary is printed to stdout.
+ *
+ * Planner benchmark
+ *	Measures host CPU time, so results are only comparable on the same host.
+ *	The firmware time is the main loop passes that read a line (parsing and
+ *	planning) plus the LOAD and EXEC interrupts (segment execution). Idle
+ *	passes and the DDA and dwell ticks are not counted. Reported are
+ *	blocks/sec and segments/sec over that time, the average and worst case time of
+ *	_plan_block_list() per block, the average and worst case number of blocks
+ *	it visited per block, and how often _sync_to_planner() refused
+ *	input (stall events, and main loop passes spent stalled). bench.sh runs
+ *	this over a directory of gcode files, "make bench" over gcode_samples.
+ *
+ * Kinematics benchmark
+ *	The summary gives the host time of the ik_kinematics() call for each segment
+ *	(average and worst case, including a clock read), and the average as a share
+ *	of the segment time, next to the IK_SEGMENT_BUDGET in kinematics.h. For a
+ *	delta or a Z mesh it also counts the sections whose segments were lengthened
+ *	to stay in that budget. "make delta" runs delta.gcode, which sets up a delta,
+ *	and "make zmesh" runs zmesh.gcode, which sets up a Z mesh on a cartesian 
+ *	machine. The xmega time is the exec row of a __STEP_TIMING build on the 
+ *	target.
+ *
+ * Arc check
+ *	Arc segments advance their sine and cosine by a rotation and only call
+ *	sin() and cos() every ARC_RESYNC_SEGMENTS (see _exec_aline_segment() in
+ *	plan_line.c). Each arc segment target is compared with the exact arc point
+ *	computed in double precision from the same angle and radius. The summary 
+ *	gives the worst deviation next to that of the float sin() and cos() it
+ *	replaced. arcs.sh (make arcs) runs this over circles2.gcode and the
+ *	bigcircle_smallcircle test program.
+ *
+ * Spline check
+ *	G5 and G5.1 splines are queued as lines (see plan_spline.h). The summary 
+ *	counts them and gives the worst distance of the curve from a line, next to
+ *	the chordal tolerance ($ct) they are stepped for. With -v a chord error over
+ *	$ct fails the run, as the step check does.
+ *	It also gives the lines queued per main loop pass and per second of host
+ *	time over the passes that queued them (the whole pass, so the controller
+ *	callbacks each pass runs are counted too).
+ *	"make splines" runs splines.gcode.
+ *
+ * Parser benchmark
+ *	Host time gc_gcode_parser() takes to read a block into the gn and gf
+ *	structs: from the raw line to the last word, but not validating or
+ *	executing it. The summary gives the average and worst case per block,
+ *	bench.sh gives the average in its parse/b column (ns). Binary blocks
+ *	are timed the same way through gc_binary_parser(): tinyg_encode turns a
+ *	gcode file into a binary stream, binbench.sh (make binary) compares the
+ *	two streams' link rate, parse time and steps.
+ *
+ * Streaming
+ *	With no gcode file tinyg_sim reads stdin, and it flushes its responses
+ *	before it waits for a line, so a host program can drive it on a pipe.
+ *	tinyg_stream does that to test the checksummed streaming protocol (see
+ *	_check_line() in controller.c), streamtest.sh (make stream) runs it.
+ *
+ * Time
+ *	Simulated time is kept in F_CPU clock cycles. The DDA and dwell timers
+ *	advance the clock by their PER value each time they fire, and the RTC
+ *	fires every RTC_MILLISECONDS. Software interrupts (the LOAD and EXEC
+ *	timers) fire as soon as they are enabled. The main loop is given
+ *	sim.pass_cycles of CPU time per pass, during which the timer ISRs run.
+ *	A pass ends on time even if that falls between two timer ticks, so the
+ *	main loop runs at the same simulated times however long the ticks are
+ *	(the step schedule build depends on this, see schedule.sh).
+ *	This makes a run fully deterministic. The summary's average DDA rate is
+ *	DDA ticks over the time the DDA timer ran (see "Adaptive DDA rate" in stepper.h).
+ *
+ * Step check
+ *	Every step pulse is added to a per motor position, independently of the
+ *	stepper's own counters. When a move finishes in the planner its endpoint is
+ *	queued with the number of the last segment prepped for it. Once the DDA
+ *	has finished that segment, the position from the pulses is compared with
+ *	the endpoint converted to steps. The summary gives the worst error (and the
+ *	motor and gcode line where it happened), and the error at the last endpoint.
+ *	The DDA carries fractional steps between segments and motors step at the
+ *	half step points (see "Phase carry" in stepper.h), so the error of a healthy
+ *	run stays within about half a step. SIM_STEP_TOLERANCE or more means steps
+ *	were lost or gained, or came out late. validate.sh (make validate) runs the
+ *	check as a regression gate. Endpoints are the planned block endpoints, so 
+ *	corners blended with G64 P are checked at the blend points. Setting the machine
+ *	position (G28.3, homing, queue flush) rebases the check to the exact steps of
+ *	the new position. A move whose runtime did not reach its endpoint is not 
+ *	checked (a block too short for a segment is skipped and its travel goes to
+ *	the next move). These are counted. Backlash take-up is history, not 
+ *	position, so the take-up prepped up to the end of each move is queued with
+ *	its endpoint.
+ *
+ * Step trace
+ *	One line per step pulse: <cycles> <motor> <direction>
+ *	  cycles	F_CPU clock cycle count of the DDA tick that made the step
+ *	  motor		motor number 1-4
+ *	  direction	state of the direction bit on the motor port (1 = CCW)
+ *	Lines starting with '#' are comments.
+ */
+#ifndef sim_h
+#define sim_h
+
+#define SIM_PASS_USEC_DEFAULT 100		// main loop CPU time per pass
+#define SIM_RTC_CYCLES ((uint32_t)(F_CPU / 1000) * RTC_MILLISECONDS)
+#define SIM_SWI_LIMIT 16				// max back-to-back SW interrupts per pass (runaway trap)
+#define SIM_IDLE_USEC 1000000			// input done and no motion for this long ends the run
+#define SIM_ENDPOINTS 32				// endpoints waiting for their last segment to run
+#define SIM_STEP_TOLERANCE 1.0			// step check error that fails the check (steps)
+
+typedef struct simEndpoint {			// a finished move waiting for its steps
+	uint32_t segment;					// number of its last segment (see segments_prepped)
+	uint32_t linenum;					// gcode line number
+	float endpoint[AXES];				// machine position at the end of the move
+	float backlash[MOTORS];				// backlash take-up in the steps prepped for it
+} simEndpoint_t;
+
+typedef struct simTimer {				// a running stepper timer
+	uint64_t due;						// clock value of its next overflow (0 = not started)
+	uint64_t period;					// clock cycles from the last overflow to the next
+	uint64_t cycles;					// clock cycles it has run
+} simTimer_t;
+
+typedef struct simSingleton {
+	uint64_t cycles;					// simulated CPU clock
+	uint64_t pass_cycles;				// CPU clock cycles granted to each main loop pass
+	uint64_t next_rtc;					// clock value of next RTC interrupt
+	uint64_t last_activity;				// clock value of last stepper interrupt
+	uint32_t passes;					// main loop passes
+	uint32_t dda_ticks;					// DDA interrupts run
+	uint32_t dwell_ticks;				// dwell interrupts run
+	simTimer_t dda;						// DDA timer (TIMER_DDA)
+	simTimer_t dwell;					// dwell timer (TIMER_DWELL)
+	uint32_t loads;						// LOAD software interrupts
+	uint32_t execs;						// EXEC software interrupts
+	int32_t steps[MOTORS];				// net steps per motor (from the trace)
+	uint32_t pulses[MOTORS];			// total step pulses per motor
+	uint8_t quiet;						// suppress firmware console output
+	uint8_t bench;						// print a one line benchmark result instead of the summary
+	FILE *trace;						// step trace or NULL
+	FILE *console;						// firmware console output
+
+	// planner benchmark (host time, not simulated time)
+	uint32_t blocks;					// blocks planned by mp_aline()
+	uint64_t plan_ns;					// total host time in _plan_block_list()
+	uint64_t plan_max_ns;				// worst case host time in _plan_block_list()
+	uint64_t plan_start_ns;
+	uint32_t plan_visits;				// blocks visited by _plan_block_list() (both passes)
+	uint32_t plan_start_visits;
+	uint32_t plan_aline_visits;			// blocks visited on behalf of mp_aline()
+	uint32_t plan_max_visits;			// worst case blocks visited for one mp_aline()
+	uint32_t stalls;					// times _sync_to_planner() started refusing input
+	uint32_t stall_passes;				// main loop passes refused by _sync_to_planner()
+	uint32_t stall_pass;				// pass number of the last refusal
+	uint32_t coalesced;					// moves merged into the previous block by _coalesce_aline()
+	uint64_t fw_ns;						// host time in firmware code (line processing and SW interrupts)
+	uint64_t fw_mark_ns;				// host time the current main loop pass started
+	uint32_t fw_mark_lines;				// lines read when the current main loop pass started
+	uint32_t ik_calls;					// ik_kinematics() calls in the exec (one per segment)
+	uint64_t ik_ns;						// total host time in them
+	uint64_t ik_max_ns;					// worst case host time for one
+	uint64_t ik_start_ns;
+	double ik_segment_usec;				// total segment time they were called for
+	uint32_t ik_lengthened;				// delta sections whose segments were lengthened (kinematics.h)
+	uint32_t arc_segments;				// arc segments checked (see "Arc check" above)
+	double arc_max_deviation;			// worst distance from the exact arc point (mm)
+	double arc_max_deviation_float;		// same for the float sin() and cos() formula
+	uint32_t spline_segments;			// spline lines queued (see "Spline check" above)
+	float spline_max_error;				// worst distance from the curve to a line (mm)
+	uint32_t spline_passes;				// main loop passes that queued spline lines
+	uint64_t spline_ns;					// host time in those passes
+	uint32_t spline_mark;				// spline_segments when the current pass started
+	uint32_t parse_blocks;				// blocks read by gc_gcode_parser() (see "Parser benchmark" above)
+	uint64_t parse_ns;					// total host time reading them
+	uint64_t parse_max_ns;				// worst case host time for one
+	uint64_t parse_start_ns;
+
+	// step check (see above)
+	uint8_t validate;					// -v: exit with status 1 if the check fails
+	uint32_t segments_prepped;			// ALINE segments prepped by st_prep_line()
+	uint32_t segments_run;				// ALINE segments the DDA has finished
+	simEndpoint_t endpoints[SIM_ENDPOINTS];
+	uint8_t endpoint_rd;
+	uint8_t endpoint_wr;
+	float step_offset[MOTORS];			// added to steps[] when the machine position is set
+	uint32_t checks;					// endpoints checked
+	uint32_t short_moves;				// moves that ended short of their endpoint (not checked)
+	float max_error;					// worst error in steps (absolute value)
+	uint8_t max_error_motor;
+	uint32_t max_error_line;
+	float last_error[MOTORS];			// error at the last endpoint checked
+} simSingleton_t;
+extern simSingleton_t sim;
+
+void sim_run_interrupts(void);			// called once per main loop pass (controller.c)
+void sim_step(const uint8_t motor, const uint8_t port_bits);	// DDA step pulse hook
+void sim_reset(void);					// watchdog reset (ends the run)
+void sim_plan_begin(void);				// planner benchmark hooks (planner.h)
+void sim_plan_end(void);
+void sim_planner_stall(void);
+void sim_ik_begin(void);				// kinematics benchmark hooks (planner.h)
+void sim_ik_end(const float microseconds);
+uint16_t sim_timing_count(void);		// __STEP_TIMING counter (stepper.h)
+void sim_move_end(const float position[], const float endpoint[], const float linenum);	// step check hooks (planner.h, stepper.h)
+void sim_segment_end(void);
+void sim_set_step_position(const float steps[]);
+void sim_arc_segment(const float center[], const float radius, const float theta, const float target_1, const float target_2);	// arc check hook (planner.h)
+void sim_spline_segment(const float chord_error);	// spline check hook (planner.h)
+void sim_parse_begin(void);				// parser benchmark hooks (gcode_parser.h)
+void sim_parse_end(void);
+
+// sim_xio.c
+void sim_xio_open(FILE *input);
+uint8_t sim_xio_input_done(void);
+uint32_t sim_xio_lines(void);
+
+#endif
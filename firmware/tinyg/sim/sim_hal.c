@@ -0,0 +1,198 @@
+/*
+ * sim_hal.c - simulated xmega peripherals for the host build
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Replaces xmega_init.c and xmega_eeprom.c, which are mostly inline assembly.
+ * xmega_rtc.c and xmega_interrupts.c are compiled as-is against the register
+ * structs allocated here.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#undef printf							// the wrappers below need the real ones
+#undef fprintf
+
+#include "../tinyg.h"
+#include "../xio/xio.h"
+#include "../xmega/xmega_init.h"
+#include "../xmega/xmega_eeprom.h"
+#include "sim.h"
+
+/**** register file ****/
+
+PORT_t PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+VPORT_t VPORT0, VPORT1, VPORT2, VPORT3;
+PORTCFG_t PORTCFG;
+
+TC0_t TCC0, TCD0, TCE0, TCF0;
+TC1_t TCC1, TCD1, TCE1, TCF1;
+
+OSC_t OSC = { .STATUS = 0xFF };		// all oscillators and PLL report ready
+CLK_t CLK;
+RTC_t RTC;
+PMIC_t PMIC;
+RST_t RST;
+NVM_t NVM;
+register8_t CCP;
+register8_t SREG;
+
+/*
+ * xmega_init() - clocks need no setup on the host
+ * CCPWrite()	- a protected register write is just a write
+ */
+void xmega_init(void) {}
+
+void CCPWrite(volatile uint8_t * address, uint8_t value)
+{
+	*address = value;
+	if ((address == &RST.CTRL) && (value & RST_SWRST_bm)) {
+		sim_reset();
+	}
+}
+
+/*
+ * sim_pgm_read_byte() - program memory read with a fake production signature row
+ *
+ *	sys_get_id() reads the signature row by integer address with the NVM
+ *	command register set to read the calibration row. Anything that small
+ *	can't be a host pointer.
+ */
+static const char sim_signature_row[] = "00000000SIMLOT0X0Y0000000000000000";
+
+uint8_t sim_pgm_read_byte(uintptr_t addr)
+{
+	if (addr < sizeof(sim_signature_row)) {
+		return ((uint8_t)sim_signature_row[addr]);
+	}
+	return (*(const uint8_t *)addr);
+}
+
+/*
+ * sim_printf(), sim_fprintf(), sim_sprintf() - printf family with avr-libc %S
+ *
+ *	Rewrites %S (PROGMEM string) to %s and sends the firmware's console streams
+ *	(stdout and stderr) to the simulator console.
+ */
+#define SIM_FORMAT_LEN 256
+
+static const char *_fix_format(const char *format, char *buf)
+{
+	if (strstr(format, "%S") == NULL) { return (format);}
+	strncpy(buf, format, SIM_FORMAT_LEN-1);
+	buf[SIM_FORMAT_LEN-1] = NUL;
+	for (char *p = buf; (p = strstr(p, "%S")) != NULL; p += 2) {
+		p[1] = 's';
+	}
+	return (buf);
+}
+
+static int _vfprintf(FILE *stream, const char *format, va_list args)
+{
+	char buf[SIM_FORMAT_LEN];
+	if ((stream == stdout) || (stream == stderr)) {
+		if ((sim.quiet == true) || (sim.console == NULL)) { return (0);}
+		stream = sim.console;
+	}
+	return (vfprintf(stream, _fix_format(format, buf), args));
+}
+
+int sim_printf(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int len = _vfprintf(stdout, format, args);
+	va_end(args);
+	return (len);
+}
+
+int sim_fprintf(FILE *stream, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int len = _vfprintf(stream, format, args);
+	va_end(args);
+	return (len);
+}
+
+int sim_sprintf(char *str, const char *format, ...)
+{
+	char buf[SIM_FORMAT_LEN];
+	va_list args;
+	va_start(args, format);
+	int len = vsprintf(str, _fix_format(format, buf), args);
+	va_end(args);
+	return (len);
+}
+
+/*
+ * square() - avr-libc math extension
+ */
+double square(double x) { return (x * x);}
+
+/**** EEPROM ****
+ *
+ * RAM emulation, much like the __NNVM option in xmega_eeprom.c. The array
+ * starts zeroed, so cfg_init() finds it out of revision on every run and
+ * loads the settings.h defaults.
+ */
+#define SIM_EEPROM_SIZE 4096			// xmega192 and 256 have 4096 bytes
+
+static int8_t sim_eeprom[SIM_EEPROM_SIZE];
+
+uint16_t EEPROM_WriteBytes(const uint16_t address, const int8_t *buf, const uint16_t size)
+{
+	if (address + size > SIM_EEPROM_SIZE) { return (address);}
+	memcpy(&sim_eeprom[address], buf, size);
+	return (address + size);
+}
+
+uint16_t EEPROM_ReadBytes(const uint16_t address, int8_t *buf, const uint16_t size)
+{
+	if (address + size > SIM_EEPROM_SIZE) {
+		memset(buf, 0, size);
+		return (address);
+	}
+	memcpy(buf, &sim_eeprom[address], size);
+	return (address + size);
+}
+
+uint16_t EEPROM_WriteString(const uint16_t address, const char *buf, const uint8_t terminate)
+{
+	uint16_t size = strlen(buf) + ((terminate == true) ? 1 : 0);
+	return (EEPROM_WriteBytes(address, (const int8_t *)buf, size));
+}
+
+uint16_t EEPROM_ReadString(const uint16_t address, char *buf, const uint16_t size)
+{
+	uint16_t addr = EEPROM_ReadBytes(address, (int8_t *)buf, size);
+	buf[size-1] = NUL;
+	return (addr);
+}
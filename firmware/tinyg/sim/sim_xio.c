@@ -0,0 +1,209 @@
+/*
+ * sim_xio.c - host replacement for the xio device system
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * The USB device reads lines from a host file (or stdin) instead of the RX
+ * ring buffer. Like the USB RX ISR it traps the single character signals
+ * (reset, feedhold, queue flush, cycle start) and never puts them in a line.
+ * A line is delivered as soon as it is asked for, so the serial link is never
+ * the bottleneck in a simulation.
+ *
+ * The program memory file device is supported so $test runs work. The RS485
+ * and SPI devices are inert. Console output goes through sim_fprintf().
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "../xio/xio.h"
+#include "../tinyg.h"
+#include "../config.h"
+#include "../controller.h"
+#include "../canonical_machine.h"
+#include "sim.h"
+
+typedef struct simXio {
+	FILE *input;						// USB device input stream
+	uint8_t input_done;					// input stream is exhausted
+	uint32_t lines;						// lines delivered from the input stream
+	const char *pgm_rd;					// read pointer for PGM file device
+	char queue[RX_BUFFER_SIZE+1];		// characters queued with xio_queue_RX_string_usb()
+} simXio_t;
+static simXio_t sx;
+
+/*
+ * sim_xio_open() 		- bind the USB device to a host input stream
+ * sim_xio_input_done() - return TRUE once the input stream is exhausted
+ * sim_xio_lines()		- return number of lines read from the input stream
+ */
+void sim_xio_open(FILE *input) { sx.input = input;}
+uint8_t sim_xio_input_done(void) { return (sx.input_done);}
+uint32_t sim_xio_lines(void) { return (sx.lines);}
+
+/*
+ * xio_init() - init device structs so the controller's assertions pass
+ */
+void xio_init()
+{
+	for (uint8_t dev=0; dev < XIO_DEV_COUNT; dev++) {
+		memset(&ds[dev], 0, sizeof(xioDev_t));
+		ds[dev].magic_start = MAGICNUM;
+		ds[dev].magic_end = MAGICNUM;
+		ds[dev].dev = dev;
+	}
+	ds[XIO_DEV_USB].x = &us[0];
+	ds[XIO_DEV_RS485].x = &us[1];
+}
+
+/*
+ * _trap_signal() - handle the single character signals as the USB RX ISR does
+ */
+static uint8_t _trap_signal(const char c)
+{
+	switch (c) {
+		case CHAR_RESET: { tg_request_reset(); return (true);}
+		case CHAR_FEEDHOLD: { cm_request_feedhold(); return (true);}
+		case CHAR_QUEUE_FLUSH: { cm_request_queue_flush(); return (true);}
+		case CHAR_CYCLE_START: { cm_request_cycle_start(); return (true);}
+	}
+	return (false);
+}
+
+/*
+ * _gets_usb() - read the next line from queued characters or the input stream
+ */
+static int _gets_usb(char *buf, const int size)
+{
+	int c;
+	int len = 0;
+
+	if (sx.queue[0] != NUL) {					// canned input takes precedence
+		char *p = sx.queue;
+		for ( ; (*p != NUL) && (*p != LF) && (*p != CR); p++) {
+			if ((_trap_signal(*p) == false) && (len < size-1)) { buf[len++] = *p;}
+		}
+		if (*p != NUL) p++;
+		memmove(sx.queue, p, strlen(p)+1);
+		buf[len] = NUL;
+		return (XIO_OK);
+	}
+	if ((sx.input == NULL) || (sx.input_done == true)) {
+		sx.input_done = true;
+		return (XIO_EAGAIN);
+	}
+	if (sim.console != NULL) { fflush(sim.console);}	// a host on a pipe waits for the responses (see stream.c)
+	while ((c = getc(sx.input)) != EOF) {
+		if ((c == LF) || (c == CR)) {
+			if (c == CR) {						// treat CRLF as one terminator
+				if ((c = getc(sx.input)) != LF && c != EOF) { ungetc(c, sx.input);}
+			}
+			break;
+		}
+		if (_trap_signal((char)c) == true) continue;
+		if (len < size-1) { buf[len++] = (char)(c & 0x7F);}
+	}
+	buf[len] = NUL;
+	if ((c == EOF) && (len == 0)) {
+		sx.input_done = true;
+		return (XIO_EAGAIN);
+	}
+	sx.lines++;
+	return (XIO_OK);
+}
+
+/*
+ * _gets_pgm() - read the next line from a program memory file
+ */
+static int _gets_pgm(char *buf, const int size)
+{
+	int len = 0;
+
+	if ((sx.pgm_rd == NULL) || (*sx.pgm_rd == NUL)) {
+		sx.pgm_rd = NULL;
+		return (XIO_EOF);
+	}
+	for ( ; (*sx.pgm_rd != NUL) && (*sx.pgm_rd != LF) && (*sx.pgm_rd != CR); sx.pgm_rd++) {
+		if (len < size-1) { buf[len++] = *sx.pgm_rd;}
+	}
+	if (*sx.pgm_rd != NUL) sx.pgm_rd++;
+	buf[len] = NUL;
+	return (XIO_OK);
+}
+
+/*
+ * xio_gets() - non-blocking line reader
+ */
+int xio_gets(const uint8_t dev, char *buf, const int size)
+{
+	if (dev == XIO_DEV_USB) { return (_gets_usb(buf, size));}
+	if (dev == XIO_DEV_PGM) { return (_gets_pgm(buf, size));}
+	return (XIO_EAGAIN);
+}
+
+FILE *xio_open(const uint8_t dev, const char *addr, const flags_t flags)
+{
+	if (dev == XIO_DEV_PGM) {
+		sx.pgm_rd = addr;
+		return (&ds[dev].file);
+	}
+	return (NULL);
+}
+
+void xio_queue_RX_string_usb(const char *buf)
+{
+	strncat(sx.queue, buf, RX_BUFFER_SIZE - strlen(sx.queue));
+}
+
+/*
+ * Inert device functions
+ */
+int xio_ctrl(const uint8_t dev, const flags_t flags) { return (XIO_OK);}
+int xio_set_baud(const uint8_t dev, const uint8_t baud_rate) { return (XIO_OK);}
+int xio_getc(const uint8_t dev) { return (_FDEV_ERR);}
+
+int xio_putc(const uint8_t dev, const char c)
+{
+	if (dev == XIO_DEV_USB) { sim_fprintf(stdout, "%c", c);}
+	return (XIO_OK);
+}
+
+void xio_set_stdin(const uint8_t dev) {}
+void xio_set_stdout(const uint8_t dev) {}
+void xio_set_stderr(const uint8_t dev) {}
+void xio_enable_rs485_rx() {}
+void xio_reset_usb_rx_buffers() { sx.queue[0] = NUL;}
+buffer_t xio_get_tx_bufcount_usart(const xioUsart_t *dx) { return (0);}
+buffer_t xio_get_usb_rx_free() { return (RX_BUFFER_SIZE);}
+
+uint8_t xio_assertions(uint8_t *value)
+{
+	if (ds[XIO_DEV_USB].magic_start		!= MAGICNUM) { *value = 100; }
+	if (ds[XIO_DEV_USB].magic_end		!= MAGICNUM) { *value = 101; }
+	if (*value != 0) { return (STAT_MEMORY_FAULT); }
+	return (STAT_OK);
+}
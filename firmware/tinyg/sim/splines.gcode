@@ -0,0 +1,28 @@
+(splines.gcode - G5 and G5.1 splines for the simulator, see plan_spline.h and sim.h)
+G21 G90 G17 G64
+G0 X0 Y0 Z0
+F1200
+(an S curve, then a chain of G5 that continue without I J)
+G5 X40 Y20 I15 J0 P-15 Q0
+G5 X80 Y0 P-10 Q-15
+G5 X80 Y-40 P10 Q0
+G5 X40 Y-40 P10 Q-10
+(a closed loop back to the start)
+G5 X0 Y0 I-30 J5 P0 Q-20
+(quadratic splines, with Z moving along the second)
+G5.1 X30 Y30 I30 J0
+G5.1 X0 Y60 Z-2 I0 J30
+G1 X0 Y60 Z0
+(a tight spline at a higher feed, then inverse time)
+F3000
+G5 X10 Y60 I20 J20 P20 Q20
+G93
+G5 X-20 Y30 I0 J-10 P10 Q10 F0.05
+G94 F1200
+G1 X0 Y0
+(a spline in inches)
+G20
+G5 X1 Y1 I0.5 J0 P0 Q-0.5
+G21
+G0 X0 Y0
+M2
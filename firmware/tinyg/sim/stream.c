@@ -0,0 +1,299 @@
+/*
+ * stream.c - stream gcode to tinyg_sim as numbered, checksummed lines
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * A host side loopback test of the checksummed streaming protocol (see
+ * _check_line() in controller.c). Runs tinyg_sim on a pipe and streams a gcode
+ * file to it as "N<line> <gcode>*<checksum>" lines, keeping a window of lines
+ * in flight, and damages some of the lines on the way. Usage:
+ *
+ *	tinyg_stream [-w lines] [-r bytes] [-e percent] [-s seed] [-t trace_file] [-q] gcode_file
+ *
+ *	  -w  lines in flight (default STREAM_WINDOW_DEFAULT)
+ *	  -r  bytes in flight, the USB RX buffer (default STREAM_RX_BYTES_DEFAULT)
+ *	  -e  percent of the lines sent that get a character damaged (default 0)
+ *	  -s  seed for the damage (default 1), so a run can be repeated
+ *	  -t  step trace file for tinyg_sim
+ *	  -q  print a one line summary for streamtest.sh
+ *
+ *	The stream starts with N0. Each text mode prompt answers the oldest line in
+ *	flight, and a "resend <line>" takes the stream back to that line - or to
+ *	the first line not answered yet if that is earlier, which can only be N0. Blank lines
+ *	and lines that aren't gcode ($ configs, JSON...) are left out.
+ *
+ *	Damage replaces a character of the line or its checksum with another gcode
+ *	character. It never hits the '*', which would make it a line without a
+ *	checksum, or a line end, which would leave the window a response short -
+ *	a host needs a timeout for that.
+ *
+ *	The summary (stderr) gives the lines sent and sent again and the responses
+ *	to them, tinyg_sim's summary goes to stdout. Exits with tinyg_sim's status
+ *	(run with -v, see sim.h), or 1 if a line was never answered.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <sys/wait.h>
+
+#define STREAM_WINDOW_DEFAULT 8
+#define STREAM_RX_BYTES_DEFAULT 254		// RX_BUFFER_SIZE less one
+#define STREAM_LINE_LEN 256
+#define STREAM_DAMAGE_CHARS "0123456789.-+ GXYZN"
+
+typedef struct streamSingleton {
+	char **line;						// gcode lines, line[0] is empty (N0)
+	unsigned long lines;				// lines including N0
+	uint8_t *answered;					// lines that got an ok or a gcode error
+	unsigned long unanswered;			// first line not answered yet
+	unsigned long *flight;				// ring of the lines in flight, oldest first
+	int *flight_len;					// and their lengths
+	int flight_rd;
+	int flight_count;
+	int flight_bytes;
+	int window;
+	int rx_bytes;
+	int damage_percent;
+	int quiet;							// -q: one line summary only
+	FILE *to_sim;
+	FILE *from_sim;
+	unsigned long sent, resent, damaged, resends;	// counts for the summary
+	unsigned long ok, checksum_errors, sequence_errors, gcode_errors;
+} streamSingleton_t;
+static streamSingleton_t st;
+
+/*
+ * _checksum() - compute_checksum() in util.c: Java hashCode() modulo 9999
+ */
+static unsigned int _checksum(const char *str)
+{
+	uint32_t h = 0;
+	for (; *str != '\0'; str++) { h = 31 * h + *str;}
+	return (h % 9999);
+}
+
+/*
+ * _read_file() - read the gcode lines to send
+ */
+static void _read_file(const char *name)
+{
+	char buf[STREAM_LINE_LEN];
+	unsigned long size = 1024;
+	FILE *in;
+
+	if ((in = fopen(name, "r")) == NULL) { perror(name); exit(1);}
+	st.line = malloc(size * sizeof(char *));
+	st.line[0] = strdup("");
+	st.lines = 1;
+	while (fgets(buf, sizeof(buf), in) != NULL) {
+		buf[strcspn(buf, "\r\n")] = '\0';
+		char *rd = buf;
+		while ((*rd == ' ') || (*rd == '\t')) { rd++;}
+		if ((*rd == '\0') || (strchr("$?{%!~", *rd) != NULL)) continue;
+		if (st.lines == size) { st.line = realloc(st.line, (size *= 2) * sizeof(char *));}
+		st.line[st.lines++] = strdup(rd);
+	}
+	fclose(in);
+}
+
+/*
+ * _start_sim() - run tinyg_sim from the same directory on a pair of pipes
+ */
+static pid_t _start_sim(const char *argv0, const char *trace)
+{
+	char path[STREAM_LINE_LEN];
+	char copy[STREAM_LINE_LEN];
+	int to_sim[2], from_sim[2];
+	pid_t pid;
+
+	strncpy(copy, argv0, sizeof(copy)-1);
+	snprintf(path, sizeof(path), "%s/tinyg_sim", dirname(copy));
+	if ((pipe(to_sim) != 0) || (pipe(from_sim) != 0)) { perror("pipe"); exit(1);}
+	if ((pid = fork()) < 0) { perror("fork"); exit(1);}
+	if (pid == 0) {
+		dup2(to_sim[0], STDIN_FILENO);
+		dup2(from_sim[1], STDOUT_FILENO);
+		close(to_sim[0]); close(to_sim[1]); close(from_sim[0]); close(from_sim[1]);
+		if (trace != NULL) {
+			execl(path, path, "-v", "-t", trace, (char *)NULL);
+		} else {
+			execl(path, path, "-v", (char *)NULL);
+		}
+		perror(path);
+		exit(1);
+	}
+	close(to_sim[0]);
+	close(from_sim[1]);
+	st.to_sim = fdopen(to_sim[1], "w");
+	st.from_sim = fdopen(from_sim[0], "r");
+	return (pid);
+}
+
+/*
+ * _format_line() - number and checksum a line, return its length
+ * _damage_line() - now and then replace a character of a line
+ */
+static int _format_line(unsigned long n, char *buf, int size)
+{
+	int len = snprintf(buf, size, "N%lu %s", n, st.line[n]);
+	return (len + snprintf(buf+len, size-len, "*%u", _checksum(buf)));
+}
+
+static void _damage_line(char *buf, int len)
+{
+	int star = strrchr(buf, '*') - buf;
+	int i;
+	char c;
+
+	if ((rand() % 100) >= st.damage_percent) return;
+	while ((i = rand() % len) == star);
+	while ((c = STREAM_DAMAGE_CHARS[rand() % (sizeof(STREAM_DAMAGE_CHARS)-1)]) == buf[i]);
+	buf[i] = c;
+	st.damaged++;
+}
+
+/*
+ * _get_response() - read tinyg_sim output up to the next prompt
+ *
+ *	Returns false if tinyg_sim ended. A resend request takes the stream back.
+ */
+static int _get_response(unsigned long *next, unsigned long line)
+{
+	char buf[STREAM_LINE_LEN*2];
+
+	while (fgets(buf, sizeof(buf), st.from_sim) != NULL) {
+		if (strncmp(buf, "resend ", 7) == 0) {	// the firmware doesn't know about a damaged N0
+			*next = strtoul(buf+7, NULL, 10);
+			if (*next > st.unanswered) { *next = st.unanswered;}
+			st.resends++;
+			continue;
+		}
+		if (strncmp(buf, "tinyg [", 7) != 0) continue;	// status reports and such
+		char *prompt = strchr(buf, ']') + 2;
+		if (strncmp(prompt, "ok>", 3) == 0) {
+			st.ok++;
+			st.answered[line] = true;
+		} else if (strstr(prompt, "Checksum mismatch") != NULL) {
+			st.checksum_errors++;
+		} else if (strstr(prompt, "Line number out of sequence") != NULL) {
+			st.sequence_errors++;
+		} else {
+			st.gcode_errors++;
+			st.answered[line] = true;
+			if (st.quiet == false) { fprintf(stderr, "%s", buf);}
+		}
+		while ((st.unanswered < st.lines) && (st.answered[st.unanswered] == true)) { st.unanswered++;}
+		return (true);
+	}
+	return (false);
+}
+
+static void _usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-w lines] [-r bytes] [-e percent] [-s seed] [-t trace_file] [-q] gcode_file\n", name);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	char buf[STREAM_LINE_LEN*2];
+	const char *trace = NULL;
+	unsigned long next = 0, highest = 0, lost = 0;
+	int status, opt;
+	pid_t pid;
+
+	st.window = STREAM_WINDOW_DEFAULT;
+	st.rx_bytes = STREAM_RX_BYTES_DEFAULT;
+	srand(1);
+	while ((opt = getopt(argc, argv, "w:r:e:s:t:q")) != -1) {
+		switch (opt) {
+			case 'w': { st.window = atoi(optarg); break;}
+			case 'r': { st.rx_bytes = atoi(optarg); break;}
+			case 'e': { st.damage_percent = atoi(optarg); break;}
+			case 's': { srand(atoi(optarg)); break;}
+			case 't': { trace = optarg; break;}
+			case 'q': { st.quiet = true; break;}
+			default: _usage(argv[0]);
+		}
+	}
+	if ((optind != argc-1) || (st.window < 1)) _usage(argv[0]);
+	_read_file(argv[optind]);
+	st.answered = calloc(st.lines, sizeof(uint8_t));
+	st.flight = malloc(st.window * sizeof(unsigned long));
+	st.flight_len = malloc(st.window * sizeof(int));
+	pid = _start_sim(argv[0], trace);
+	if (_get_response(&next, 0) == false) {		// startup prompt
+		fprintf(stderr, "tinyg_sim didn't start\n");
+		exit(1);
+	}
+	st.ok = 0;
+	st.answered[0] = false;
+	st.unanswered = 0;
+
+	while (true) {
+		while ((next < st.lines) && (st.flight_count < st.window)) {
+			char line[STREAM_LINE_LEN+32];
+			int len = _format_line(next, line, sizeof(line)) + 1;	// with its LF
+			if ((st.flight_count > 0) && (st.flight_bytes + len > st.rx_bytes)) break;
+			_damage_line(line, len-1);
+			fprintf(st.to_sim, "%s\n", line);
+			int slot = (st.flight_rd + st.flight_count++) % st.window;
+			st.flight[slot] = next;
+			st.flight_len[slot] = len;
+			st.flight_bytes += len;
+			if (next < highest) { st.resent++;} else { st.sent++; highest = next+1;}
+			next++;
+		}
+		if (st.flight_count == 0) break;
+		fflush(st.to_sim);
+		if (_get_response(&next, st.flight[st.flight_rd]) == false) break;
+		st.flight_bytes -= st.flight_len[st.flight_rd];
+		st.flight_rd = (st.flight_rd + 1) % st.window;
+		st.flight_count--;
+	}
+	fclose(st.to_sim);							// end of input: tinyg_sim finishes the moves
+	while (fgets(buf, sizeof(buf), st.from_sim) != NULL) {
+		if ((st.quiet == false) && (strncmp(buf, "[sim]", 5) == 0)) { printf("%s", buf);}
+	}
+	waitpid(pid, &status, 0);
+
+	for (unsigned long n=0; n < st.lines; n++) { lost += (st.answered[n] == false);}
+	if (st.quiet == true) {		// see streamtest.sh for the column headings
+		fprintf(stderr, "%8lu %8lu %8lu %8lu %6lu", st.sent, st.damaged, st.resends, st.resent, lost);
+		return ((lost > 0) ? 1 : (WIFEXITED(status) ? WEXITSTATUS(status) : 1));
+	}
+	fprintf(stderr, "[stream] lines          %lu sent, %lu sent again (%lu resend requests), %lu damaged, %lu lost\n",
+			st.sent, st.resent, st.resends, st.damaged, lost);
+	fprintf(stderr, "[stream] responses      %lu ok, %lu checksum mismatch, %lu out of sequence, %lu gcode errors\n",
+			st.ok, st.checksum_errors, st.sequence_errors, st.gcode_errors);
+	fprintf(stderr, "[stream] window         %d lines, %d bytes\n", st.window, st.rx_bytes);
+	if (lost > 0) { return (1);}
+	return (WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+}
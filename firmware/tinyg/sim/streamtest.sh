@@ -0,0 +1,62 @@
+#!/bin/sh
+#
+# streamtest.sh - loopback test of the checksummed streaming protocol
+# Part of TinyG project
+#
+# usage: streamtest.sh [-e percent] [-w lines] [gcode_file...]
+#
+# Streams each file to tinyg_sim with tinyg_stream (see stream.c), damaging
+# a percentage of the lines sent (default 10) with a window of lines in flight
+# (default 8), and checks that every line was answered and the steps are the
+# same as when tinyg_sim reads the file itself. The step traces are compared
+# without their times, as lines sent again take main loop passes. Prints the
+# lines sent, the lines damaged, the resend requests, the lines sent again,
+# the lines never answered and whether the steps are the same. Exits with
+# status 1 if a file fails.
+#
+
+DIR=$(dirname "$0")
+SIM=$DIR/tinyg_sim
+STREAM=$DIR/tinyg_stream
+SAMPLES=$DIR/../../../gcode_samples
+DAMAGE=10
+WINDOW=8
+WORK=${TMPDIR:-/tmp}/streamtest.$$
+FAILED=0
+
+while [ $# -gt 0 ]; do
+	case "$1" in
+		-e) DAMAGE=$2; shift 2;;
+		-w) WINDOW=$2; shift 2;;
+		*) break;;
+	esac
+done
+if [ $# -eq 0 ]; then
+	set -- $SAMPLES/circles2.gcode $SAMPLES/tinyg_test_001.gcode $SAMPLES/spiro.gcode \
+		   $SAMPLES/mudflap_10in.gcode $SAMPLES/zoetrope.gcode $SAMPLES/braid_two_decimals.gcode \
+		   $DIR/splines.gcode
+fi
+for prog in "$SIM" "$STREAM"; do
+	if [ ! -x "$prog" ]; then
+		echo "$prog not found - run make stream first" >&2
+		exit 1
+	fi
+done
+mkdir -p "$WORK" || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+printf "%-28s %8s %8s %8s %8s %6s %6s   (%s%% damaged, window %s)\n" \
+	file lines damaged resends again lost steps $DAMAGE $WINDOW
+for f in "$@"; do
+	[ -f "$f" ] || continue
+	printf "%-28s " "$(basename "$f")"
+	"$SIM" -q -t "$WORK/file.trace" "$f" > /dev/null
+	"$STREAM" -q -e "$DAMAGE" -w "$WINDOW" -t "$WORK/stream.trace" "$f" 2>&1
+	status=$?
+	grep -v '^#' "$WORK/file.trace" | cut -d' ' -f2- > "$WORK/file.steps"
+	grep -v '^#' "$WORK/stream.trace" | cut -d' ' -f2- > "$WORK/stream.steps"
+	if cmp -s "$WORK/file.steps" "$WORK/stream.steps"; then steps=same; else steps=differ; status=1; fi
+	printf " %6s\n" $steps
+	[ $status -eq 0 ] || FAILED=1
+done
+exit $FAILED
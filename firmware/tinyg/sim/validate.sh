@@ -0,0 +1,66 @@
+#!/bin/sh
+#
+# validate.sh - run the step check over a set of gcode files
+# Part of TinyG project
+#
+# usage: validate.sh [gcode_file...]
+#
+# Runs each file through tinyg_sim -v and prints the step check result: the
+# endpoints checked, the moves too short to check, and the worst error in
+# steps with the motor and gcode line it happened on (see "Step check" in
+# sim.h). With no arguments the files below are run from the gcode_samples
+# directory at the top of the repo. Exits 1 if any file fails.
+#
+# TinyPOV.PCB has runs of blocks too short for a segment. Those are skipped
+# and their travel lands on one segment of the next move, which can ask for
+# more steps than the segment has DDA ticks. The steps come out a segment late
+# (not lost), so the check reports an error at the endpoint. Files in
+# FINAL_ONLY are gated on the final error instead: every motor must end within
+# SIM_STEP_TOLERANCE (1 step) of its target, and the result says "ok (final)".
+#
+# delta.gcode, zmesh.gcode and compensation.gcode in this directory are in the
+# default set too. They switch the machine to delta kinematics, and turn on Z
+# mesh compensation and pitch error and backlash compensation (see
+# kinematics.h). splines.gcode runs G5 and G5.1 splines (see plan_spline.h).
+#
+
+DIR=$(dirname "$0")
+SIM=$DIR/tinyg_sim
+SAMPLES=$DIR/../../../gcode_samples
+FINAL_ONLY="TinyPOV.PCB.gcode"
+
+if [ ! -x "$SIM" ]; then
+	echo "$SIM not found - run make" >&2
+	exit 1
+fi
+if [ $# -eq 0 ]; then
+	set -- "$SAMPLES/braid_3000mm.gcode" "$SAMPLES/braid.gcode" \
+		   "$SAMPLES/circles2.gcode" "$SAMPLES/tinyg_test_001.gcode" \
+		   "$SAMPLES/birthday.nc" "$SAMPLES/boxes_400mm.gcode" \
+		   "$SAMPLES/DXF473.gcode" "$SAMPLES/TinyPOV.PCB.gcode" \
+		   "$DIR/delta.gcode" "$DIR/zmesh.gcode" "$DIR/compensation.gcode" \
+		   "$DIR/splines.gcode"
+fi
+
+status=0
+printf "%-36s %9s %7s %10s %6s %8s  %s\n" file endpoints short max_error motor line result
+for f in "$@"; do
+	if "$SIM" -q -v "$f" > "${TMPDIR:-/tmp}/validate.$$"; then
+		result=ok
+	else
+		result=FAILED
+		case " $FINAL_ONLY " in *" $(basename "$f") "*)
+			if awk '/final error/ { gsub(/,/, " "); for (i=4; i<=7; i++) if (($i < 0 ? -$i : $i) >= 1) exit 1; found=1 }
+					END { exit !found }' "${TMPDIR:-/tmp}/validate.$$"; then
+				result="ok (final)"
+			fi;;
+		esac
+		[ "$result" = FAILED ] && status=1
+	fi
+	awk -v file="$(basename "$f")" -v result="$result" '/step check/ {
+		gsub(/[(),]/, " ");
+		printf "%-36s %9s %7s %10s %6s %8s  %s\n", file, $5, $15, $9, $12, $14, result }' \
+		"${TMPDIR:-/tmp}/validate.$$"
+done
+rm -f "${TMPDIR:-/tmp}/validate.$$"
+exit $status
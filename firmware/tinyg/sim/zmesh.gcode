@@ -0,0 +1,59 @@
+(zmesh.gcode - Z mesh compensation on a cartesian machine for the simulator, see sim.h)
+(a 200 x 200mm spoilboard, bowed 0.4mm in the middle and twisted 0.2mm corner to corner)
+$zmx=0
+$zmy=0
+$zmi=50
+$zmj=50
+$zm00=0.100
+$zm01=0.050
+$zm02=0.000
+$zm03=-0.050
+$zm04=-0.100
+$zm10=0.050
+$zm11=0.250
+$zm12=0.300
+$zm13=0.200
+$zm14=-0.050
+$zm20=0.000
+$zm21=0.300
+$zm22=0.400
+$zm23=0.300
+$zm24=0.000
+$zm30=-0.050
+$zm31=0.200
+$zm32=0.300
+$zm33=0.250
+$zm34=0.050
+$zm40=-0.100
+$zm41=-0.050
+$zm42=0.000
+$zm43=0.050
+$zm44=0.100
+$zme=1
+g21 g90 g17 g64
+g28.3 x0 y0 z0
+g1 f3000 z-1
+g1 x210 y0
+g1 y25
+g1 x-10 y25
+g1 y50
+g1 x210 y50
+g1 y75
+g1 x-10 y75
+g1 y100
+g1 x210 y100
+g1 y125
+g1 x-10 y125
+g1 y150
+g1 x210 y150
+g1 y175
+g1 x-10 y175
+g1 y200
+g1 x210 y200
+g1 x100 y100
+g2 x100 y100 i-60 j0
+g3 x40 y100 z-2 i-30 j0
+g1 x0 y0 z-1
+g1 x200 y200
+g0 z5
+g0 x0 y0 z0
@@ -69,7 +69,7 @@
  *		  currently executing - the "segment", usually 5ms worth of pulses
  *
  *	  - When the current segment is finished the stepper interrupt LOADs the next 
- *		  segment from the prep buffer, reloads the timers, and starts the 
+ *		  segment from the prep queue, reloads the timers, and starts the 
  *		  next segment. At the end of the load the stepper interrupt routine
  *		  requests an "exec" of the next move in order to prepare for the 
  *		  next load operation. It does this by calling the exec using a 
@@ -83,7 +83,9 @@
  *
  *	  - Once the segment has been computed the exec handler finshes up by running 
  *		  the PREP routine in stepper.c. This computes the DDA values and gets 
- *		  the segment into the prep buffer - and ready for the next LOAD operation.
+ *		  the segment into the prep queue - and ready for the next LOAD operation.
+ *		  If there is another free prep buffer the exec requests itself again, 
+ *		  so it can run up to PREP_BUFFER_COUNT segments ahead of the loader.
  *
  *	  - The main loop runs in background to receive gcode blocks, parse them,
  *		  and send them to the planner in order to keep the planner queue 
@@ -121,7 +123,7 @@
  *		be needed to run the move - in this example st_prep_line().
  *
  *	 7	st_prep_line() generates the timer and DDA values and stages these into 
- *		the prep structure (sp) - ready for loading into the stepper runtime struct
+ *		a prep buffer (sps.bf) - ready for loading into the stepper runtime struct
  *
  *	 8	stepper.st_prep_line() returns back to planner.mp_exec_move(), which 
  *		frees the planning buffer (bf) back to the planner buffer pool if the 
@@ -164,6 +166,9 @@
 #include "stepper.h" 	
 #include "planner.h"
 #include "xmega/xmega_rtc.h"
+#ifdef __SIMULATION
+#include "sim/sim.h"
+#endif
 
 static void _exec_move(void);
 static void _load_move(void);
@@ -177,27 +182,46 @@ static void _request_load_move(void);
  *	data structure:						static to:		runs at:
  *	  mpBuffer planning buffers (bf)	  planner.c		  main loop
  *	  mrRuntimeSingleton (mr)			  planner.c		  MED ISR
- *	  stPrepSingleton (sp)				  stepper.c		  MED ISR
+ *	  stPrepSingleton (sps)				  stepper.c		  MED ISR
  *	  stRunSingleton (st)				  stepper.c		  HI ISR
  *  
  *	Care has been taken to isolate actions on these structures to the 
  *	execution level in which they run and to use the minimum number of 
  *	volatiles in these structures. This allows the compiler to optimize
  *	the stepper inner-loops better.
+ *
+ *	The prep buffers are a single-producer, single-consumer ring. The exec
+ *	fills the buffer at exec_index and the loader empties the buffer at 
+ *	load_index. Each index is only written by its own level, and a buffer 
+ *	changes hands by flipping its exec_state as the very last step. So no 
+ *	locking is needed between the exec and the loader.
  */
 
 // Runtime structs. Used exclusively by step generation ISR (HI)
 typedef struct stRunMotor { 		// one per controlled motor
 	int32_t phase_increment;		// total steps in axis times substeps factor
 	int32_t phase_accumulator;		// DDA phase angle accumulator for axis
+	int32_t step_count;				// steps actually made, signed (see st_get_step_count())
+	int8_t step_sign;				// +1 or -1 for the running segment
 	uint8_t polarity;				// 0=normal polarity, 1=reverse motor polarity
 } stRunMotor_t;
 
+#ifdef __STEP_SCHEDULE
+typedef struct stStepEvent {		// one step event of a precomputed schedule
+	uint16_t period;				// DDA timer period from the previous event
+	uint8_t steps;					// bit per motor that steps (1 << MOTOR_1 ...)
+} stStepEvent_t;
+#endif
+
 typedef struct stRunSingleton {		// Stepper static values and axis parameters
 	uint16_t magic_start;			// magic number to test memory integity	
-	int32_t dda_ticks_downcount;	// tick down-counter (unscaled)
+	int32_t dda_ticks_downcount;	// tick down-counter (unscaled). Events left in schedule mode
 	int32_t dda_ticks_X_substeps;	// ticks multiplied by scaling factor
 	stRunMotor_t m[MOTORS];			// runtime motor structures
+#ifdef __STEP_SCHEDULE
+	stStepEvent_t *event;			// next event of the running schedule, or NULL to run the DDA
+	struct stPrepBuffer *running;	// prep buffer holding the running schedule
+#endif
 } stRunSingleton_t;
 
 // Prep-time structs. Used by exec/prep ISR (MED) and read-only during load 
@@ -211,29 +235,132 @@ enum prepBufferState {
 typedef struct stPrepMotor {
  	uint32_t phase_increment; 		// total steps in axis times substep factor
 	int8_t dir;						// b0 = direction
+	int8_t step_sign;				// +1 or -1. Direction before polarity is applied
+#ifdef __STEP_SCHEDULE
+	int32_t phase_start;			// phase accumulator at the start of the segment
+#endif
 } stPrepMotor_t;
 
-typedef struct stPrepSingleton {
-	uint16_t magic_start;			// magic number to test memory integity	
+typedef struct stPrepBuffer {		// one prepared segment
+	volatile uint8_t exec_state;	// owner of the buffer - exec or loader
 	uint8_t move_type;				// move type
-	uint8_t prep_state;				// set TRUE to load, false to skip
-	volatile uint8_t exec_state;	// move execution state 
-	volatile uint8_t reset_flag;	// TRUE if accumulator should be reset
-	uint32_t prev_ticks;			// tick count from previous move
+	uint32_t phase_scale;			// 24 bit mantissa of the range ratio, 0 if unchanged (see stepper.h)
+	int8_t phase_shift;				// binary exponent of the range ratio
 	uint16_t dda_period;			// DDA or dwell clock period setting
 	uint32_t dda_ticks;				// DDA or dwell ticks for the move
 	uint32_t dda_ticks_X_substeps;	// DDA ticks scaled by substep factor
 //	float segment_velocity;			// +++++ record segment velocity for diagnostics
 	stPrepMotor_t m[MOTORS];		// per-motor structs
+#ifdef __STEP_SCHEDULE
+	uint8_t event_count;			// events in the schedule. 0 runs the segment on the DDA
+	stStepEvent_t event[SCHEDULE_EVENTS];
+#endif
+} stPrepBuffer_t;
+
+typedef struct stPrepSingleton {
+	uint16_t magic_start;			// magic number to test memory integity	
+	uint8_t exec_index;				// buffer being prepped. Only changed by the exec
+	uint8_t load_index;				// next buffer to load. Only changed by the loader
+	uint32_t prev_ticks_X_substeps;	// accumulator range of the previous segment
+	int8_t dda_octave;				// DDA rate of the last prepped segment is F_DDA >> dda_octave
+	float usec_residual;			// segment time not yet covered by whole DDA ticks
+	float step_residual[MOTORS];	// steps not yet covered by whole substeps
+	uint32_t underruns;				// DDA segment ends that found nothing to load
+	volatile uint8_t exec_pending;	// TRUE if the exec has more segments coming. Set by the exec only
+#ifdef __STEP_SCHEDULE
+	int32_t phase[MOTORS];			// phase accumulators as of the end of the last prepped segment
+	int8_t step_sign[MOTORS];		// step signs of the last prepped segment
+#endif
+	stPrepBuffer_t bf[PREP_BUFFER_COUNT];
 } stPrepSingleton_t;
 
 // Allocate static structures
 static stRunSingleton_t st;
 static struct stPrepSingleton sps;
 
+#define _bump_prep(a) ((a+1) & (PREP_BUFFER_COUNT-1))	// PREP_BUFFER_COUNT is a power of 2
+
+#ifdef __STEP_SCHEDULE
+static void _prep_schedule(stPrepBuffer_t *pb);
+static void _load_schedule(stPrepBuffer_t *pb);
+#else
+static void _carry_phase(const stPrepBuffer_t *pb);
+#endif
+static inline int32_t _scale_phase(const int32_t phase, const stPrepBuffer_t *pb);
+
+// Timing instrumentation. See stepper.h
+#ifdef __STEP_TIMING
+typedef struct stTimingRecord {
+	uint16_t min;
+	uint16_t max;
+	uint32_t sum;					// sum and count of samples in the running mean
+	uint16_t count;
+	uint32_t total;					// samples since cleared
+} stTimingRecord_t;
+
+typedef struct stTimingSingleton {
+	stTimingRecord_t row[TIMING_ROWS];
+	uint16_t starved_at;			// counter when a DDA segment ended with nothing to load
+	volatile uint8_t starved;		// TRUE until the next exec finishes
+} stTimingSingleton_t;
+static stTimingSingleton_t stt;
+
+static void _timing_record(const uint8_t row, const uint16_t start);
+static void _timing_clear(void);
+
+#define _timing_start() uint16_t timing_start = _timing_now()
+#define _timing_end(row) _timing_record(row, timing_start)
+#define _timing_starved() { stt.starved_at = _timing_now(); stt.starved = true;}
+#else
+#define _timing_start()
+#define _timing_end(row)
+#define _timing_starved()
+#endif
+
 uint16_t st_get_st_magic() { return (st.magic_start);}
 uint16_t st_get_sps_magic() { return (sps.magic_start);}
 
+/*
+ * st_get_underruns() - return the count of segments the DDA ran out of
+ *
+ *	Counted by the DDA ISR, so the 32 bit read is guarded like the step counts
+ */
+uint32_t st_get_underruns()
+{
+	uint32_t underruns;
+
+	cli();
+	underruns = sps.underruns;
+	sei();
+	return (underruns);
+}
+
+/*
+ * st_get_step_count() - return the steps a motor has actually made
+ * st_set_step_count() - set a motor's step counter
+ *
+ *	The counters are signed and counted by the DDA ISR as the pulses go out,
+ *	so they track the motors, not the planner. Counts are in the direction 
+ *	of the steps given to st_prep_line() - i.e. before motor polarity. 
+ *	See mp_get_step_position() for the conversion to axis positions.
+ */
+int32_t st_get_step_count(const uint8_t motor)
+{
+	int32_t count;
+
+	cli();									// a 32 bit read is not atomic
+	count = st.m[motor].step_count;
+	sei();
+	return (count);
+}
+
+void st_set_step_count(const uint8_t motor, const int32_t count)
+{
+	cli();
+	st.m[motor].step_count = count;
+	sei();
+}
+
 /* 
  * st_init() - initialize stepper motor subsystem 
  *
@@ -284,7 +411,17 @@ void st_init()
 	TIMER_EXEC.INTCTRLA = TIMER_EXEC_INTLVL;	// interrupt mode
 	TIMER_EXEC.PER = SWI_PERIOD;				// set period
 
-	sps.exec_state = PREP_BUFFER_OWNED_BY_EXEC;
+	for (uint8_t i=0; i<PREP_BUFFER_COUNT; i++) {
+		sps.bf[i].exec_state = PREP_BUFFER_OWNED_BY_EXEC;
+	}
+
+#ifdef __STEP_TIMING
+	TIMER_TIMING.CTRLA = STEP_TIMER_DISABLE;	// free running at F_CPU, no interrupts
+	TIMER_TIMING.CTRLB = STEP_TIMER_WGMODE;
+	TIMER_TIMING.PER = 0xFFFF;
+	TIMER_TIMING.CTRLA = STEP_TIMER_ENABLE;
+	_timing_clear();							// interrupts are not enabled yet
+#endif
 }
 
 /* 
@@ -363,38 +500,104 @@ void st_kill_motors()
  *	Even when -0s or -03 is used.
  */
 
+static inline void _end_segment(void);
+
 ISR(TIMER_DDA_ISR_vect)
 {
+	_timing_start();
+#ifdef __STEP_SCHEDULE
+	if (st.event != NULL) {						// run the next event of a schedule
+		uint8_t steps = st.event->steps;
+		if (steps & (1<<MOTOR_1)) {
+			PORT_MOTOR_1_VPORT.OUT |= STEP_BIT_bm;
+			_sim_step(MOTOR_1, PORT_MOTOR_1_VPORT);
+			st.m[MOTOR_1].step_count += st.m[MOTOR_1].step_sign;
+			PORT_MOTOR_1_VPORT.OUT &= ~STEP_BIT_bm;
+		}
+		if (steps & (1<<MOTOR_2)) {
+			PORT_MOTOR_2_VPORT.OUT |= STEP_BIT_bm;
+			_sim_step(MOTOR_2, PORT_MOTOR_2_VPORT);
+			st.m[MOTOR_2].step_count += st.m[MOTOR_2].step_sign;
+			PORT_MOTOR_2_VPORT.OUT &= ~STEP_BIT_bm;
+		}
+		if (steps & (1<<MOTOR_3)) {
+			PORT_MOTOR_3_VPORT.OUT |= STEP_BIT_bm;
+			_sim_step(MOTOR_3, PORT_MOTOR_3_VPORT);
+			st.m[MOTOR_3].step_count += st.m[MOTOR_3].step_sign;
+			PORT_MOTOR_3_VPORT.OUT &= ~STEP_BIT_bm;
+		}
+		if (steps & (1<<MOTOR_4)) {
+			PORT_MOTOR_4_VPORT.OUT |= STEP_BIT_bm;
+			_sim_step(MOTOR_4, PORT_MOTOR_4_VPORT);
+			st.m[MOTOR_4].step_count += st.m[MOTOR_4].step_sign;
+			PORT_MOTOR_4_VPORT.OUT &= ~STEP_BIT_bm;
+		}
+		if (--st.dda_ticks_downcount == 0) {
+			st.event = NULL;
+			_end_segment();
+		} else {
+			TIMER_DDA.PER = (++st.event)->period;
+		}
+		_timing_end(TIMING_DDA);
+		return;
+	}
+#endif
 	if ((st.m[MOTOR_1].phase_accumulator += st.m[MOTOR_1].phase_increment) > 0) {
 		PORT_MOTOR_1_VPORT.OUT |= STEP_BIT_bm;	// turn step bit on
+		_sim_step(MOTOR_1, PORT_MOTOR_1_VPORT);
  		st.m[MOTOR_1].phase_accumulator -= st.dda_ticks_X_substeps;
+		st.m[MOTOR_1].step_count += st.m[MOTOR_1].step_sign;
 		PORT_MOTOR_1_VPORT.OUT &= ~STEP_BIT_bm;	// turn step bit off in ~1 uSec
 	}
 	if ((st.m[MOTOR_2].phase_accumulator += st.m[MOTOR_2].phase_increment) > 0) {
 		PORT_MOTOR_2_VPORT.OUT |= STEP_BIT_bm;
+		_sim_step(MOTOR_2, PORT_MOTOR_2_VPORT);
  		st.m[MOTOR_2].phase_accumulator -= st.dda_ticks_X_substeps;
+		st.m[MOTOR_2].step_count += st.m[MOTOR_2].step_sign;
 		PORT_MOTOR_2_VPORT.OUT &= ~STEP_BIT_bm;
 	}
 	if ((st.m[MOTOR_3].phase_accumulator += st.m[MOTOR_3].phase_increment) > 0) {
 		PORT_MOTOR_3_VPORT.OUT |= STEP_BIT_bm;
+		_sim_step(MOTOR_3, PORT_MOTOR_3_VPORT);
  		st.m[MOTOR_3].phase_accumulator -= st.dda_ticks_X_substeps;
+		st.m[MOTOR_3].step_count += st.m[MOTOR_3].step_sign;
 		PORT_MOTOR_3_VPORT.OUT &= ~STEP_BIT_bm;
 	}
 	if ((st.m[MOTOR_4].phase_accumulator += st.m[MOTOR_4].phase_increment) > 0) {
 		PORT_MOTOR_4_VPORT.OUT |= STEP_BIT_bm;
+		_sim_step(MOTOR_4, PORT_MOTOR_4_VPORT);
  		st.m[MOTOR_4].phase_accumulator -= st.dda_ticks_X_substeps;
+		st.m[MOTOR_4].step_count += st.m[MOTOR_4].step_sign;
 		PORT_MOTOR_4_VPORT.OUT &= ~STEP_BIT_bm;
 	}
 	if (--st.dda_ticks_downcount == 0) {		// end move
- 		TIMER_DDA.CTRLA = STEP_TIMER_DISABLE;	// disable DDA timer
-		st_start_disable_motors_timer();
-		// power-down motors if this feature is enabled
-		if (cfg.m[MOTOR_1].power_mode == true) PORT_MOTOR_1_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; // set to 0 to disable
-		if (cfg.m[MOTOR_2].power_mode == true) PORT_MOTOR_2_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
-		if (cfg.m[MOTOR_3].power_mode == true) PORT_MOTOR_3_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
-		if (cfg.m[MOTOR_4].power_mode == true) PORT_MOTOR_4_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
-		_load_move();							// load the next move
+		_end_segment();
+	}
+	_timing_end(TIMING_DDA);
+}
+
+static inline void _end_segment()
+{
+ 	TIMER_DDA.CTRLA = STEP_TIMER_DISABLE;		// disable DDA timer
+	st_start_disable_motors_timer();
+	// power-down motors if this feature is enabled
+	if (cfg.m[MOTOR_1].power_mode == true) PORT_MOTOR_1_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; // set to 0 to disable
+	if (cfg.m[MOTOR_2].power_mode == true) PORT_MOTOR_2_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+	if (cfg.m[MOTOR_3].power_mode == true) PORT_MOTOR_3_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+	if (cfg.m[MOTOR_4].power_mode == true) PORT_MOTOR_4_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+#ifdef __STEP_SCHEDULE
+	if (st.running != NULL) {					// release the buffer that held the schedule
+		st.running->exec_state = PREP_BUFFER_OWNED_BY_EXEC;
+		st.running = NULL;
+	}
+#endif
+	if ((sps.bf[sps.load_index].exec_state != PREP_BUFFER_OWNED_BY_LOADER) && 
+		(sps.exec_pending == true)) {
+		sps.underruns++;						// the exec fell behind
+		_timing_starved();
 	}
+	_sim_segment_end();
+	_load_move();								// load the next move
 }
 
 ISR(TIMER_DWELL_ISR_vect) {						// DWELL timer interupt
@@ -416,7 +619,7 @@ ISR(TIMER_EXEC_ISR_vect) {						// exec move SW interrupt
 }
 
 /* Software interrupts to fire the above
- * st_test_exec_state()	   - return TRUE if exec/prep can run
+ * st_test_exec_state()	   - return TRUE if exec/prep can run (there is a free prep buffer)
  * _request_load_move()    - SW interrupt to request to load a move
  *	st_request_exec_move() - SW interrupt to request to execute a move
  * _exec_move() 		   - Run a move from the planner and prepare it for loading
@@ -427,7 +630,7 @@ ISR(TIMER_EXEC_ISR_vect) {						// exec move SW interrupt
 
 uint8_t st_test_exec_state()
 {
-	if (sps.exec_state == PREP_BUFFER_OWNED_BY_EXEC) {
+	if (sps.bf[sps.exec_index].exec_state == PREP_BUFFER_OWNED_BY_EXEC) {
 		return (true);
 	}
 	return (false);
@@ -435,7 +638,7 @@ uint8_t st_test_exec_state()
 
 void st_request_exec_move()
 {
-	if (sps.exec_state == PREP_BUFFER_OWNED_BY_EXEC) {	// bother interrupting
+	if (sps.bf[sps.exec_index].exec_state == PREP_BUFFER_OWNED_BY_EXEC) {	// bother interrupting
 		TIMER_EXEC.PER = SWI_PERIOD;
 		TIMER_EXEC.CTRLA = STEP_TIMER_ENABLE;			// trigger a LO interrupt
 	}
@@ -443,11 +646,25 @@ void st_request_exec_move()
 
 static void _exec_move()
 {
-   	if (sps.exec_state == PREP_BUFFER_OWNED_BY_EXEC) {
+	stPrepBuffer_t *pb = &sps.bf[sps.exec_index];
+
+	_timing_start();
+   	if (pb->exec_state == PREP_BUFFER_OWNED_BY_EXEC) {
 //		if (mp_exec_move(state) != STAT_NOOP) {
-		if (mp_exec_move() != STAT_NOOP) {
-			sps.exec_state = PREP_BUFFER_OWNED_BY_LOADER; // flip it back
+		uint8_t status = mp_exec_move();
+		sps.exec_pending = mp_runtime_is_pending();	// for the DDA ISR, which mustn't walk the planner
+		if (status != STAT_NOOP) {
+			_timing_end(TIMING_EXEC);
+#ifdef __STEP_TIMING
+			if (stt.starved == true) {				// the DDA ran dry waiting for this one
+				stt.starved = false;
+				_timing_record(TIMING_LATE, stt.starved_at);
+			}
+#endif
+			sps.exec_index = _bump_prep(sps.exec_index);
+			pb->exec_state = PREP_BUFFER_OWNED_BY_LOADER; // flip it over - must be last
 			_request_load_move();
+			st_request_exec_move();						// run ahead if there's a free buffer
 		}
 	}
 }
@@ -472,62 +689,65 @@ static void _request_load_move()
 void _load_move()
 {
 	if (st.dda_ticks_downcount != 0) return;					// exit if it's still busy
-	if (sps.exec_state != PREP_BUFFER_OWNED_BY_LOADER) return;	// if there are no more moves
+
+	stPrepBuffer_t *pb = &sps.bf[sps.load_index];
+	if (pb->exec_state != PREP_BUFFER_OWNED_BY_LOADER) {		// if there are no more moves
+		st_request_exec_move();									// make sure the exec is running
+		return;
+	}
+	_timing_start();
 
 	// handle aline loads first (most common case)  NB: there are no more lines, only alines
-	if (sps.move_type == MOVE_TYPE_ALINE) {
-		st.dda_ticks_downcount = sps.dda_ticks;
-		st.dda_ticks_X_substeps = sps.dda_ticks_X_substeps;
-		TIMER_DDA.PER = sps.dda_period;
+	if (pb->move_type == MOVE_TYPE_ALINE) {
+		st.dda_ticks_downcount = pb->dda_ticks;
+		st.dda_ticks_X_substeps = pb->dda_ticks_X_substeps;
+		TIMER_DDA.PER = pb->dda_period;
+#ifdef __STEP_SCHEDULE
+		_load_schedule(pb);						// phase was rescaled by the prep
+#else
+		_carry_phase(pb);						// before the step signs are loaded
+#endif
  
 		// This section is somewhat optimized for execution speed 
-		// All axes must set steps and compensate for out-of-range pulse phasing. 
+		// All axes must set steps. 
 		// If axis has 0 steps the direction setting can be omitted
 		// If axis has 0 steps enabling motors is req'd to support power mode = 1
 
-		st.m[MOTOR_1].phase_increment = sps.m[MOTOR_1].phase_increment;			// set steps
-		if (sps.reset_flag == true) {				// compensate for pulse phasing
-			st.m[MOTOR_1].phase_accumulator = -(st.dda_ticks_downcount);
-		}
+		st.m[MOTOR_1].phase_increment = pb->m[MOTOR_1].phase_increment;			// set steps
+		st.m[MOTOR_1].step_sign = pb->m[MOTOR_1].step_sign;
 		if (st.m[MOTOR_1].phase_increment != 0) {
 			// For ideal optimizations, only set or clear a bit at a time.
-			if (sps.m[MOTOR_1].dir == 0) {
+			if (pb->m[MOTOR_1].dir == 0) {
 				PORT_MOTOR_1_VPORT.OUT &= ~DIRECTION_BIT_bm;// CW motion (bit cleared)
 			} else {
 				PORT_MOTOR_1_VPORT.OUT |= DIRECTION_BIT_bm;	// CCW motion
 			}
 			PORT_MOTOR_1_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;	// enable motor
 		}
-		st.m[MOTOR_2].phase_increment = sps.m[MOTOR_2].phase_increment;
-		if (sps.reset_flag == true) {
-			st.m[MOTOR_2].phase_accumulator = -(st.dda_ticks_downcount);
-		}
+		st.m[MOTOR_2].phase_increment = pb->m[MOTOR_2].phase_increment;
+		st.m[MOTOR_2].step_sign = pb->m[MOTOR_2].step_sign;
 		if (st.m[MOTOR_2].phase_increment != 0) {
-			if (sps.m[MOTOR_2].dir == 0) {
+			if (pb->m[MOTOR_2].dir == 0) {
 				PORT_MOTOR_2_VPORT.OUT &= ~DIRECTION_BIT_bm;
 			} else {
 				PORT_MOTOR_2_VPORT.OUT |= DIRECTION_BIT_bm;
 			}
 			PORT_MOTOR_2_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;
 		}
-		st.m[MOTOR_3].phase_increment = sps.m[MOTOR_3].phase_increment;
-		if (sps.reset_flag == true) {
-			st.m[MOTOR_3].phase_accumulator = -(st.dda_ticks_downcount);
-		}
+		st.m[MOTOR_3].phase_increment = pb->m[MOTOR_3].phase_increment;
+		st.m[MOTOR_3].step_sign = pb->m[MOTOR_3].step_sign;
 		if (st.m[MOTOR_3].phase_increment != 0) {
-			if (sps.m[MOTOR_3].dir == 0) {
+			if (pb->m[MOTOR_3].dir == 0) {
 				PORT_MOTOR_3_VPORT.OUT &= ~DIRECTION_BIT_bm;
 			} else {
 				PORT_MOTOR_3_VPORT.OUT |= DIRECTION_BIT_bm;
 			}
 			PORT_MOTOR_3_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;
 		}
-		st.m[MOTOR_4].phase_increment = sps.m[MOTOR_4].phase_increment;
-		if (sps.reset_flag == true) {
-			st.m[MOTOR_4].phase_accumulator = (st.dda_ticks_downcount);
-		}
+		st.m[MOTOR_4].phase_increment = pb->m[MOTOR_4].phase_increment;
+		st.m[MOTOR_4].step_sign = pb->m[MOTOR_4].step_sign;
 		if (st.m[MOTOR_4].phase_increment != 0) {
-			if (sps.m[MOTOR_4].dir == 0) {
+			if (pb->m[MOTOR_4].dir == 0) {
 				PORT_MOTOR_4_VPORT.OUT &= ~DIRECTION_BIT_bm;
 			} else {
 				PORT_MOTOR_4_VPORT.OUT |= DIRECTION_BIT_bm;
@@ -537,20 +757,141 @@ void _load_move()
 		TIMER_DDA.CTRLA = STEP_TIMER_ENABLE;				// enable the DDA timer
 
 	// handle dwells
-	} else if (sps.move_type == MOVE_TYPE_DWELL) {
-		if (sps.prep_state == true) {
-			st.dda_ticks_downcount = sps.dda_ticks;
-			TIMER_DWELL.PER = sps.dda_period;					// load dwell timer period
- 			TIMER_DWELL.CTRLA = STEP_TIMER_ENABLE;				// enable the dwell timer
-		}
+	} else if (pb->move_type == MOVE_TYPE_DWELL) {
+		st.dda_ticks_downcount = pb->dda_ticks;
+		TIMER_DWELL.PER = pb->dda_period;						// load dwell timer period
+ 		TIMER_DWELL.CTRLA = STEP_TIMER_ENABLE;					// enable the dwell timer
 	}
 
 	// all other cases drop to here (e.g. Null moves after Mcodes skip to here) 
-	sps.exec_state = PREP_BUFFER_OWNED_BY_EXEC;				// flip it back
-	sps.prep_state = false;
+	pb->move_type = MOVE_TYPE_NULL;							// a stale buffer must never run twice
+	sps.load_index = _bump_prep(sps.load_index);
+#ifdef __STEP_SCHEDULE
+	if (st.running != pb)									// else flipped back by _end_segment()
+#endif
+	pb->exec_state = PREP_BUFFER_OWNED_BY_EXEC;				// flip it back
+	_timing_end(TIMING_LOAD);
 	st_request_exec_move();									// exec and prep next move
+	_request_load_move();									// load the next buffer if nothing started
 }
 
+/*
+ * _carry_phase() - carry partial steps into the next segment
+ *
+ *	Scales the accumulators to the new tick count and mirrors them for motors
+ *	that reverse. See "Phase carry" in stepper.h
+ */
+#ifndef __STEP_SCHEDULE
+static void _carry_phase(const stPrepBuffer_t *pb)
+{
+	for (uint8_t i=0; i<MOTORS; i++) {
+		if (pb->phase_scale != 0) {
+			st.m[i].phase_accumulator = _scale_phase(st.m[i].phase_accumulator, pb);
+		}
+		if (st.m[i].step_sign == 0) {			// first move since power up
+			st.m[i].phase_accumulator = -st.dda_ticks_X_substeps / 2;
+		} else if (pb->m[i].step_sign != st.m[i].step_sign) {
+			st.m[i].phase_accumulator = -st.dda_ticks_X_substeps - st.m[i].phase_accumulator;
+		}
+	}
+}
+#endif
+
+/*
+ * _scale_phase() - multiply a phase accumulator by the range ratio of a segment
+ *
+ *	The ratio is phase_scale/2^24 * 2^phase_shift. The accumulator and the
+ *	mantissa are split into 16 and 8 bit parts, so the product takes four
+ *	16x16 or 16x8 bit multiplies. The ratio is rounded, so the result is held
+ *	to no less than minus the new range, which keeps the rounding from piling
+ *	up on a motor that stands still. A positive accumulator is steps owed by a
+ *	segment that asked for more steps than it had ticks, and is kept.
+ */
+static inline int32_t _scale_phase(const int32_t phase, const stPrepBuffer_t *pb)
+{
+	int16_t phase_hi = (int16_t)(phase >> 16);
+	uint16_t phase_lo = (uint16_t)phase;
+	uint8_t scale_hi = (uint8_t)(pb->phase_scale >> 16);
+	uint16_t scale_lo = (uint16_t)pb->phase_scale;
+	int32_t scaled = ((int32_t)phase_hi * scale_hi) * 256 +
+					 (((int32_t)phase_hi * (int32_t)scale_lo) >> 8) +
+					 (int32_t)(((uint32_t)phase_lo * scale_hi) >> 8) +
+					 (int32_t)(((uint32_t)phase_lo * scale_lo) >> 24);
+	if (pb->phase_shift >= 0) {
+		scaled = (int32_t)((uint32_t)scaled << pb->phase_shift);	// no signed left shift
+	} else {
+		scaled >>= -pb->phase_shift;
+	}
+	if (scaled < -(int32_t)pb->dda_ticks_X_substeps) { return (-(int32_t)pb->dda_ticks_X_substeps);}
+	return (scaled);
+}
+
+/*
+ * _prep_schedule() - run the DDA for a prepped segment and record its step events
+ * _load_schedule()	- start a prepped segment from its schedule (or on the DDA)
+ *
+ *	See "Step schedules" in stepper.h. The prep keeps its own copy of the phase
+ *	accumulators (sps.phase) and carries it exactly as _load_move() would. Every
+ *	segment carries the phase it starts with, so a segment that falls back to the
+ *	DDA starts from the right phase even if the one before it ran from a schedule.
+ */
+#ifdef __STEP_SCHEDULE
+static void _prep_schedule(stPrepBuffer_t *pb)
+{
+	int32_t ticks_X_substeps = pb->dda_ticks_X_substeps;
+	uint16_t gap_max = 0xFFFF / pb->dda_period;	// most ticks one timer period can span
+	uint16_t gap = 0;
+	uint8_t count = 0;
+	uint8_t i;
+
+	for (i=0; i<MOTORS; i++) {
+		if (pb->phase_scale != 0) {
+			sps.phase[i] = _scale_phase(sps.phase[i], pb);
+		}
+		if (sps.step_sign[i] == 0) {			// same as _carry_phase()
+			sps.phase[i] = -ticks_X_substeps / 2;
+		} else if (pb->m[i].step_sign != sps.step_sign[i]) {
+			sps.phase[i] = -ticks_X_substeps - sps.phase[i];
+		}
+		sps.step_sign[i] = pb->m[i].step_sign;
+		pb->m[i].phase_start = sps.phase[i];
+	}
+
+	for (uint32_t tick=1; tick <= pb->dda_ticks; tick++) {
+		uint8_t steps = 0;
+		for (i=0; i<MOTORS; i++) {		// same math as the DDA ISR
+			if ((sps.phase[i] += (int32_t)pb->m[i].phase_increment) > 0) {
+				sps.phase[i] -= ticks_X_substeps;
+				steps |= (1<<i);
+			}
+		}
+		gap++;
+		if ((steps == 0) && (gap != gap_max) && (tick != pb->dda_ticks)) continue;
+		if (count < SCHEDULE_EVENTS) {
+			pb->event[count].period = gap * pb->dda_period;
+			pb->event[count].steps = steps;
+		}
+		if (count <= SCHEDULE_EVENTS) { count++;}	// one past the end means it did not fit
+		gap = 0;
+	}
+	pb->event_count = (count > SCHEDULE_EVENTS) ? 0 : count;
+}
+
+static void _load_schedule(stPrepBuffer_t *pb)
+{
+	st.m[MOTOR_1].phase_accumulator = pb->m[MOTOR_1].phase_start;
+	st.m[MOTOR_2].phase_accumulator = pb->m[MOTOR_2].phase_start;
+	st.m[MOTOR_3].phase_accumulator = pb->m[MOTOR_3].phase_start;
+	st.m[MOTOR_4].phase_accumulator = pb->m[MOTOR_4].phase_start;
+	if (pb->event_count != 0) {
+		st.event = pb->event;
+		st.running = pb;
+		st.dda_ticks_downcount = pb->event_count;
+		TIMER_DDA.PER = pb->event[0].period;
+	}
+}
+#endif
+
 /*
  * st_prep_line() - Prepare the next move for the loader
  *
@@ -560,6 +901,8 @@ void _load_move()
  *	(motors) and it works in steps, not length units. All args are provided as 
  *	floats and converted to their appropriate integer types for the loader. 
  *
+ *	The DDA rate is picked per segment. See "Adaptive DDA rate" in stepper.h
+ *
  * Args:
  *	steps[] are signed relative motion in steps (can be non-integer values)
  *	Microseconds - how many microseconds the segment should run 
@@ -568,33 +911,63 @@ void _load_move()
 stat_t st_prep_line(float steps[], float microseconds)
 {
 	uint8_t i;
-	float f_dda = F_DDA;		// starting point for adjustment
+	float f_dda;
 	float dda_substeps = DDA_SUBSTEPS;
+	float major_steps = 0;
+	int8_t octave = sps.dda_octave;
+	stPrepBuffer_t *pb = &sps.bf[sps.exec_index];
 
 	// *** defensive programming ***
 	// trap conditions that would prevent queueing the line
-	if (sps.exec_state != PREP_BUFFER_OWNED_BY_EXEC) { return (STAT_INTERNAL_ERROR);
+	if (pb->exec_state != PREP_BUFFER_OWNED_BY_EXEC) { return (STAT_INTERNAL_ERROR);
 	} else if (isfinite(microseconds) == false) { return (STAT_MINIMUM_LENGTH_MOVE_ERROR);
 	} else if (microseconds < EPSILON) { return (STAT_MINIMUM_TIME_MOVE_ERROR);
 	}
-	sps.reset_flag = false;		// initialize accumulator reset flag for this move.
-
-	// setup motor parameters
+	// setup motor parameters. The part of a step lost rounding to whole substeps is
+	// carried into the next segment, or long jobs drift by whole steps
 	for (i=0; i<MOTORS; i++) {
-		sps.m[i].dir = ((steps[i] < 0) ? 1 : 0) ^ cfg.m[i].polarity;
-		sps.m[i].phase_increment = (uint32_t)fabs(steps[i] * dda_substeps);
+		steps[i] += sps.step_residual[i];
+		pb->m[i].dir = ((steps[i] < 0) ? 1 : 0) ^ cfg.m[i].polarity;
+		pb->m[i].step_sign = (steps[i] < 0) ? -1 : 1;
+		pb->m[i].phase_increment = (uint32_t)lround(fabs(steps[i] * dda_substeps));
+		sps.step_residual[i] = steps[i] - (pb->m[i].step_sign * (float)pb->m[i].phase_increment / dda_substeps);
+		major_steps = max(major_steps, fabs(steps[i]));
 	}
-	sps.dda_period = _f_to_period(f_dda);
-	sps.dda_ticks = (uint32_t)((microseconds/1000000) * f_dda);
-	sps.dda_ticks_X_substeps = sps.dda_ticks * dda_substeps;	// see FOOTNOTE
 
-	// anti-stall measure in case change in velocity between segments is too great 
-	if ((sps.dda_ticks * ACCUMULATOR_RESET_FACTOR) < sps.prev_ticks) {  // NB: uint32_t math
-		sps.reset_flag = true;
+	// pick the DDA rate: up as far as needed, down one octave with headroom
+	float f_required = max(major_steps * DDA_OVERSAMPLE, DDA_SEGMENT_TICKS_MIN) * (1000000 / microseconds);
+	while ((octave > 0) && ((F_DDA / (1 << octave)) < f_required)) { octave--;}
+	if ((octave < DDA_OCTAVE_MAX) && ((F_DDA / (2 << octave)) >= (f_required * DDA_RATE_HYSTERESIS))) { octave++;}
+	sps.dda_octave = octave;
+	f_dda = F_DDA / (1 << octave);
+
+	pb->dda_period = _f_to_period(f_dda);
+	// carry the fraction of a tick into the next segment so segment times do not drift
+	microseconds += sps.usec_residual;
+	pb->dda_ticks = (uint32_t)((microseconds/1000000) * f_dda);
+	sps.usec_residual = microseconds - (pb->dda_ticks * (1000000 / f_dda));
+	pb->dda_ticks_X_substeps = pb->dda_ticks * dda_substeps;	// see FOOTNOTE
+
+	// carry the partial steps into this segment's accumulator range
+	pb->phase_scale = 0;
+	pb->phase_shift = 0;
+	if ((sps.prev_ticks_X_substeps != 0) && (sps.prev_ticks_X_substeps != pb->dda_ticks_X_substeps)) {
+		int exponent;
+		float mantissa = frexp((float)pb->dda_ticks_X_substeps / sps.prev_ticks_X_substeps, &exponent);
+		uint32_t scale = (uint32_t)lround(mantissa * 16777216);	// mantissa is 0.5 to 1
+		if (scale > 0xFFFFFF) {					// rounded up to 1
+			scale >>= 1;
+			exponent++;
+		}
+		pb->phase_scale = scale;
+		pb->phase_shift = (int8_t)exponent;
 	}
-	sps.prev_ticks = sps.dda_ticks;
-	sps.move_type = MOVE_TYPE_ALINE;
-	sps.prep_state = true;
+	sps.prev_ticks_X_substeps = pb->dda_ticks_X_substeps;
+#ifdef __STEP_SCHEDULE
+	_prep_schedule(pb);
+#endif
+	pb->move_type = MOVE_TYPE_ALINE;
+	_sim_prep_line();
 	return (STAT_OK);
 }
 // FOOTNOTE: This expression was previously computed as below but floating 
@@ -609,8 +982,7 @@ stat_t st_prep_line(float steps[], float microseconds)
 
 void st_prep_null()
 {
-	sps.move_type = MOVE_TYPE_NULL;
-	sps.prep_state = true;
+	sps.bf[sps.exec_index].move_type = MOVE_TYPE_NULL;
 }
 
 /* 
@@ -619,10 +991,12 @@ void st_prep_null()
 
 void st_prep_dwell(float microseconds)
 {
-	sps.move_type = MOVE_TYPE_DWELL;
-	sps.prep_state = true;
-	sps.dda_period = _f_to_period(F_DWELL);
-	sps.dda_ticks = (uint32_t)((microseconds/1000000) * F_DWELL);
+	stPrepBuffer_t *pb = &sps.bf[sps.exec_index];
+	float f_dwell = max(F_DDA_MIN, min(F_DWELL, DWELL_TICKS_MIN * (1000000 / microseconds)));
+
+	pb->move_type = MOVE_TYPE_DWELL;
+	pb->dda_period = _f_to_period(f_dwell);
+	pb->dda_ticks = (uint32_t)((microseconds/1000000) * f_dwell + 0.5);
 }
 
 /*
@@ -670,6 +1044,58 @@ void st_set_microsteps(const uint8_t motor, const uint8_t microstep_mode)
 }
 
 
+/*
+ * _timing_record()  - add a sample that started at counter value <start>
+ * st_get_timing()	 - return a statistic for a timing row (see stepper.h)
+ * st_clear_timing() - restart the statistics
+ * _timing_clear()	 - st_clear_timing() without the interrupt lock
+ */
+#ifdef __STEP_TIMING
+
+static void _timing_record(const uint8_t row, const uint16_t start)
+{
+	stTimingRecord_t *t = &stt.row[row];
+	uint16_t elapsed = _timing_now() - start;	// NB: uint16_t math handles counter rollover
+
+	if (elapsed < t->min) { t->min = elapsed;}
+	if (elapsed > t->max) { t->max = elapsed;}
+	t->sum += elapsed;
+	if (++t->count == (2 * TIMING_WINDOW)) {	// age the running mean
+		t->sum >>= 1;
+		t->count >>= 1;
+	}
+	t->total++;
+}
+
+uint32_t st_get_timing(const uint8_t row, const uint8_t stat)
+{
+	stTimingRecord_t *t = &stt.row[row];
+
+	if (t->total == 0) { return (0);}
+	switch (stat) {
+		case TIMING_MIN: { return (t->min);}
+		case TIMING_MAX: { return (t->max);}
+		case TIMING_MEAN: { return (t->sum / t->count);}
+	}
+	return (t->total);
+}
+
+void st_clear_timing()
+{
+	cli();
+	_timing_clear();
+	sei();
+}
+
+static void _timing_clear()
+{
+	memset(&stt, 0, sizeof(stt));
+	for (uint8_t i=0; i<TIMING_ROWS; i++) {
+		stt.row[i].min = 0xFFFF;
+	}
+}
+#endif // __STEP_TIMING
+
 /**** DEBUG routines ****/
 /*
  * st_dump_stepper_state()
@@ -47,14 +47,11 @@
  *	  prescaler is not used. Various methods are used to keep the numbers 
  *	  in range for long lines. See _st_set_f_dda() for details.
  *
- *	- Pulse phasing is preserved between segments if possible. This makes
- *	  for smoother motion, particularly at very low speeds and short 
- *	  segment lengths (avoids pulse jitter). Phase continuity is achieved 
- *	  by simply not resetting the DDA counters across segments. In some 
- *	  cases the differences between timer values across segments are too 
- *	  large for this to work, and you risk motor stalls due to pulse 
- *	  starvation. These cases are detected and the counters are reset 
- *	  to prevent stalling.
+ *	- Pulse phasing is preserved between segments. This makes for smoother 
+ *	  motion, particularly at very low speeds and short segment lengths 
+ *	  (avoids pulse jitter). Phase continuity is achieved by not resetting 
+ *	  the DDA counters across segments, but scaling them to the range of 
+ *	  the next segment. See "Phase carry" below.
  *
  *  - Pulse phasing is also helped by minimizing the time spent loading 
  *	  the next move segment. To this end as much as possible about that 
@@ -89,6 +86,14 @@ stat_t st_prep_line(float steps[], float microseconds);
 
 uint16_t st_get_st_magic(void);
 uint16_t st_get_sps_magic(void);
+uint32_t st_get_underruns(void);
+int32_t st_get_step_count(const uint8_t motor);
+void st_set_step_count(const uint8_t motor, const int32_t count);
+
+#ifdef __STEP_TIMING
+uint32_t st_get_timing(const uint8_t row, const uint8_t stat);
+void st_clear_timing(void);
+#endif
 
 #ifdef __DEBUG
 void st_dump_stepper_state(void);
@@ -97,6 +102,50 @@ void st_dump_stepper_state(void);
 // handy macro
 #define _f_to_period(f) (uint16_t)((float)F_CPU / (float)f)
 
+/* Stepper timing instrumentation
+ *	Define __STEP_TIMING (see tinyg.h) to time the DDA ISR, _load_move() and 
+ *	_exec_move() with a free running counter, and to catch execs that finish 
+ *	after the previous segment has already ended ("late" execs, the cause of
+ *	underruns). Results are reported in the "stp" group. Compiles out otherwise.
+ *
+ *	On the xmega the counter is TIMER_TIMING running at F_CPU, so times are 
+ *	in CPU cycles and anything over 65535 cycles (2 ms) wraps. The simulator 
+ *	substitutes a host clock counting nanoseconds (sim_timing_count()).
+ */
+enum stTimingRow {					// what was timed
+	TIMING_DDA = 0,					// DDA ISR
+	TIMING_LOAD,					// _load_move() that loaded a segment
+	TIMING_EXEC,					// _exec_move() that prepped a segment
+	TIMING_LATE,					// lateness of a late exec
+	TIMING_ROWS
+};
+enum stTimingStat {					// statistic kept for each row
+	TIMING_MIN = 0,
+	TIMING_MAX,
+	TIMING_MEAN,					// mean over the last TIMING_WINDOW to 2*TIMING_WINDOW samples
+	TIMING_COUNT					// total samples since cleared
+};
+#define TIMING_WINDOW 16384			// samples in the running mean (keeps the sum in 32 bits)
+
+#ifdef __SIMULATION
+#define _timing_now() sim_timing_count()
+#define TIMING_UNITS " ns"
+#else
+#define _timing_now() (TIMER_TIMING.CNT)
+#define TIMING_UNITS " cycles"
+#endif
+
+// host simulation hooks for step pulses and the step check (see sim/sim.h). Compile out on the target
+#ifdef __SIMULATION
+#define _sim_step(motor, vport) sim_step(motor, vport.OUT)
+#define _sim_prep_line() (sim.segments_prepped++)
+#define _sim_segment_end() sim_segment_end()
+#else
+#define _sim_step(motor, vport)
+#define _sim_prep_line()
+#define _sim_segment_end()
+#endif
+
 /*
  * Stepper configs and constants
  */
@@ -133,14 +182,40 @@ void st_dump_stepper_state(void);
 //#define DDA_OVERCLOCK 16		// doesn't have to be a binary multiple
 #define DDA_OVERCLOCK 0			// Permanently disabled. See above NOTE
 
-/* Accumulator resets
- * 	You want to reset the DDA accumulators if the new ticks value is way less 
- *	than previous value, but otherwise you should leave the accumulators alone.
- *	Preserving the accumulator value from the previous segment aligns pulse 
- *	phasing between segments. However, if the new accumulator is going to be 
- *	much less than the old one you must reset it or risk motor stalls.
+/* Phase carry
+ *	A motor's phase accumulator holds its partial step as a fraction of the
+ *	segment's dda_ticks_X_substeps. The next segment usually has a different
+ *	tick count (velocity or DDA rate changed), so _load_move() scales the
+ *	accumulators by the ratio of the two ranges. st_prep_line() turns the ratio
+ *	into a 24 bit mantissa (phase_scale) and a binary exponent (phase_shift),
+ *	so the load takes four small integer multiplies per motor and no float 
+ *	math. The partial step is then carried to within 2^-24 of itself, as close
+ *	as the float ratio it replaced. A coarser ratio is not enough: a motor that
+ *	stands still is scaled up and down on every segment, and 2^-16 errors add
+ *	up to whole steps over a long job. The result is held to no less than minus
+ *	the new range. Steps owed by a segment too short for them (a positive
+ *	accumulator) carry over.
+ *	A motor that reverses has its accumulator mirrored within the range, as its
+ *	progress towards the next step in the old direction is the distance back to
+ *	the last step in the new one. The first move after
+ *	power up starts half a step from a step, so motors step at the half step
+ *	points and the step count is the position rounded to the nearest step.
+ *	st_prep_line() rounds each motor's steps to whole substeps and carries the
+ *	remainder into the next segment (step_residual), for the same reason.
+ *
+ *	Carrying the raw value instead gains or loses a fraction of a step at every
+ *	change, and used to need an accumulator reset when the range shrank a lot 
+ *	(which dropped the partial step altogether). The step check in the 
+ *	simulator (sim.h) measures the result.
+ */
+
+/* Prep buffers
+ *	The number of prepared segments the exec can queue ahead of the loader.
+ *	More buffers ride out longer exec stalls (replanning, arc segments) but 
+ *	delay the response to a feedhold by one segment each. Must be a power 
+ *	of 2. Each buffer takes 32 bytes of RAM.
  */
-#define ACCUMULATOR_RESET_FACTOR 2	// amount counter range can safely change
+#define PREP_BUFFER_COUNT 4
 
 /* DDA minimum operating frequency
  *	This is the minumum value the DDA time can run with a fixed 32 Mhz 
@@ -149,10 +224,50 @@ void st_dump_stepper_state(void);
 //#define F_DDA_MIN (float)489	// hz
 #define F_DDA_MIN (float)500	// hz - is 489 Hz with some margin
 
+/* Adaptive DDA rate
+ *	st_prep_line() runs the DDA at F_DDA divided by a power of 2 (the DDA
+ *	"octave"). The octave is chosen per segment so the fastest motor still gets
+ *	DDA_OVERSAMPLE ticks per step, and the segment still lasts at least
+ *	DDA_SEGMENT_TICKS_MIN ticks. So slow moves, and the slow ends of accels and
+ *	decels, interrupt far less often than full rate.
+ *
+ *	A rate change is one more change in the segment's tick count, so the 
+ *	partial steps carry across it like any other (see "Phase carry").
+ *
+ *	The rate goes up as soon as a segment needs it. It comes down only one
+ *	octave per segment, and only when the lower rate still has
+ *	DDA_RATE_HYSTERESIS headroom. This keeps the rate from flapping on moves
+ *	that sit near a boundary.
+ */
+#define DDA_OVERSAMPLE 8			// min DDA ticks per step of the fastest motor
+#define DDA_SEGMENT_TICKS_MIN 32	// min DDA ticks per segment (limits segment time rounding)
+#define DDA_RATE_HYSTERESIS 1.5		// headroom required to drop an octave
+#define DDA_OCTAVE_MAX 6			// F_DDA/64 = 781 Hz. Must stay above F_DDA_MIN
+
+/* Step schedules (optional)
+ *	With __STEP_SCHEDULE defined st_prep_line() runs the DDA arithmetic for the
+ *	segment ahead of time and stores the ticks that step as a list of events.
+ *	Each event holds the timer period since the previous event and a bit per
+ *	motor that steps. The DDA ISR pops the next event, pulses its step bits and
+ *	loads the period of the event after it. So it fires when something steps,
+ *	not on every tick. An idle stretch longer than the 16 bit period register
+ *	is split with events that step nothing.
+ *
+ *	The events come from the same integer math as the DDA, so step counts and
+ *	step times are identical to the DDA path. "make schedule" in the sim
+ *	directory checks this over the sample files (see sim/schedule.sh).
+ *
+ *	A segment with more than SCHEDULE_EVENTS events runs on the DDA instead.
+ *	A prep buffer is held until its events have run, so the exec can queue 
+ *	one segment less ahead of the loader. Each buffer grows by 3 bytes per event.
+ */
+#define SCHEDULE_EVENTS 96			// max step events in one segment
+
 /* Timer settings for stepper module. See system.h for timer assignments
  */
 #define F_DDA 		(float)50000	// DDA frequency in hz.
-#define F_DWELL		(float)10000	// Dwell count frequency in hz.
+#define F_DWELL		(float)10000	// Dwell count frequency in hz (max)
+#define DWELL_TICKS_MIN 1000		// dwells slow the dwell timer down to this many ticks
 #define SWI_PERIOD 	100				// cycles you have to shut off SW interrupt
 #define TIMER_PERIOD_MIN (20)		// used to trap bad timer loads
 
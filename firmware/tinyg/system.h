@@ -144,7 +144,7 @@ enum cfgPortBits {			// motor control port bit positions
 #define TIMER_DWELL	 		TCD0		// Dwell timer	(see stepper.h)
 #define TIMER_LOAD			TCE0		// Loader timer	(see stepper.h)
 #define TIMER_EXEC			TCF0		// Exec timer	(see stepper.h)
-#define TIMER_5				TCC1		// unallocated timer
+#define TIMER_TIMING		TCC1		// Free running counter for __STEP_TIMING (see stepper.h)
 #define TIMER_PWM1			TCD1		// PWM timer #1 (see pwm.c)
 #define TIMER_PWM2			TCE1		// PWM timer #2	(see pwm.c)
 
@@ -34,7 +34,7 @@
 
 // NOTE: This header requires <stdio.h> be included previously
 
-#define TINYG_FIRMWARE_BUILD  		380.05	// Promote version 0.96 to Master
+#define TINYG_FIRMWARE_BUILD  		380.06	// new settings change the NVM layout (see cfgArray)
 #define TINYG_FIRMWARE_VERSION		0.96	// major version
 #define TINYG_HARDWARE_VERSION		8		// board revision number
 #define TINYG_HARDWARE_VERSION_MAX	8		// get ready for version 8
@@ -46,6 +46,8 @@
 //#define __SUPPRESS_STARTUP_MESSAGES 		// what it says
 //#define __UNIT_TESTS						// master enable for unit tests; uncomment modules in .h files
 //#define __DEBUG							// complies debug functions found in test.c
+//#define __STEP_TIMING						// time the stepper interrupts. See stepper.h
+//#define __STEP_SCHEDULE					// precompute step pulse times per segment. See stepper.h
 
 // UNIT_TESTS exist for various modules are can be enabled at the end of their .h files
 
@@ -172,10 +174,10 @@ extern stat_t status_code;				// declared in main.cpp
 #define	STAT_JSON_TOO_LONG 50				// JSON output exceeds buffer size
 #define	STAT_NO_BUFFER_SPACE 51				// Buffer pool is full and cannot perform this operation
 #define	STAT_CONFIG_NOT_TAKEN 52			// configuration value not taken while in machining cycle
-#define	STAT_ERROR_53 53
-#define	STAT_ERROR_54 54
-#define	STAT_ERROR_55 55
-#define	STAT_ERROR_56 56
+#define	STAT_BINARY_BLOCK_ERROR 53			// binary gcode block damaged in transit (see gcode_parser.h)
+#define	STAT_BINARY_SEQUENCE_ERROR 54		// binary gcode block out of sequence
+#define	STAT_CHECKSUM_MISMATCH 55			// line checksum doesn't match, resend requested (see controller.c)
+#define	STAT_LINE_NUMBER_ERROR 56			// line number out of sequence in a checksummed stream
 #define	STAT_ERROR_57 57
 #define	STAT_ERROR_58 58
 #define	STAT_ERROR_59 59
@@ -192,6 +194,7 @@ extern stat_t status_code;				// declared in main.cpp
 #define	STAT_MAX_TRAVEL_EXCEEDED 68
 #define	STAT_MAX_SPINDLE_SPEED_EXCEEDED 69
 #define	STAT_ARC_SPECIFICATION_ERROR 70		// arc specification error
+#define	STAT_SPLINE_SPECIFICATION_ERROR 71	// spline specification error (G5, G5.1)
 
 /*** Alarm States ***/
 #define ALARM_LIMIT_OFFSET 0
@@ -168,6 +168,70 @@ inline float max4(float x1, float x2, float x3, float x4)
 	return (max);
 }
 
+/* Fast math - approximations of the libm powers used by the planner
+ * 	fast_rcbrt() 		 - return 1/cbrt(x)
+ * 	fast_cbrt() 		 - return cbrt(x)
+ * 	fast_pow_two_thirds() - return x^(2/3), replaces pow(x, 0.66666666)
+ * 	fast_rsqrt() 		 - return 1/sqrt(x)
+ *
+ *	avr-libc computes pow() as exp(y*log(x)), which is several thousand cycles on the
+ *	xmega. These functions get a first estimate by operating on the IEEE 754 bit
+ *	pattern (the exponent is divided by -3 or -2), then refine it with Newton steps
+ *	that use only multiplies - there is no divide in any of them.
+ *
+ *	With FAST_MATH_ITERATIONS of 2 the relative error is less than 1.2e-5 for
+ *	fast_rcbrt() and fast_pow_two_thirds(), 2.4e-5 for fast_cbrt() and 5e-6 for
+ *	fast_rsqrt(), over the whole positive float range (no denormals). The results
+ *	are low except for float rounding (at most 4e-7 high), so a planner velocity
+ *	computed from them errs on the slow side.
+ *
+ *	avr-libc sqrt() already costs about as much as a divide, so the planner keeps
+ *	using it. fast_rsqrt() is for code that would otherwise divide by a square root.
+ *	Arguments must be positive or zero. Zero returns zero from the powers, and a
+ *	very large number from the reciprocals.
+ */
+
+typedef union {
+	float f;
+	uint32_t i;
+} fast_math_t;
+
+float fast_rcbrt(const float x)
+{
+	fast_math_t u = { .f = x };
+	uint32_t i = (u.i >> 2) + (u.i >> 4);		// i ~= u.i/3 without a 32 bit divide
+	i += (i >> 4);
+	i += (i >> 8);
+	u.i = FAST_RCBRT_MAGIC - i;
+	float y = u.f;								// within 3.5% of the result
+	for (uint8_t j=0; j<FAST_MATH_ITERATIONS; j++) {
+		y = y * (4 - x*y*y*y) * (float)(1.0/3.0);
+	}
+	return (y);
+}
+
+float fast_cbrt(const float x)
+{
+	float y = fast_rcbrt(x);
+	return (x*y*y);
+}
+
+float fast_pow_two_thirds(const float x)
+{
+	return (x * fast_rcbrt(x));
+}
+
+float fast_rsqrt(const float x)
+{
+	fast_math_t u = { .f = x };
+	u.i = FAST_RSQRT_MAGIC - (u.i >> 1);
+	float y = u.f;								// within 3.5% of the result
+	for (uint8_t j=0; j<FAST_MATH_ITERATIONS; j++) {
+		y = y * (1.5 - 0.5*x*y*y);
+	}
+	return (y);
+}
+
 /*
  * isnumber() - isdigit that also accepts plus, minus, and decimal point
  */
@@ -177,7 +241,7 @@ uint8_t isnumber(char c)
 	if (c == '.') { return (true); }
 	if (c == '-') { return (true); }
 	if (c == '+') { return (true); }
-	return (isdigit(c));
+	return ((isdigit(c) != 0) ? true : false);	// isdigit() returns non-zero, not necessarily 1
 }
 
 /* 
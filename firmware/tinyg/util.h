@@ -43,6 +43,10 @@ float min3(float x1, float x2, float x3);
 float min4(float x1, float x2, float x3, float x4);
 float max3(float x1, float x2, float x3);
 float max4(float x1, float x2, float x3, float x4);
+float fast_rcbrt(const float x);
+float fast_cbrt(const float x);
+float fast_pow_two_thirds(const float x);
+float fast_rsqrt(const float x);
 uint8_t isnumber(char c);
 uint8_t read_float(char *buf, uint8_t *i, float *float_ptr);
 uint16_t compute_checksum(char const *string, const uint16_t length);
@@ -72,6 +76,11 @@ float *set_vector_by_axis(float value, uint8_t axis);
       termA<termB ? termA:termB; })
 #endif
 
+// Fast math (see util.c for error bounds)
+#define FAST_MATH_ITERATIONS 2				// Newton steps. Each step roughly squares the relative error
+#define FAST_RCBRT_MAGIC 0x54A21C00			// about 4/3 of the bits of 1.0, tuned for the best first estimate
+#define FAST_RSQRT_MAGIC 0x5F3759DF
+
 #ifndef avg
 #define avg(a,b) ((a+b)/2)
 #endif